@@ -0,0 +1,297 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// Benchmark/ChunkBenchmark.cpp
+// 
+// Entry point of the chunk kernel micro-benchmarks. Builds synthetic
+// neighbourhoods of chunks and times Chunk::updateCellStates() and
+// Chunk::applyCellStates() on their centre chunks, for each sleep mode,
+// cell density and neighbour configuration.
+// 
+
+#include "gol/Simulation.hpp"
+#include "gol/Chunk.hpp"
+#include "Version.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace gol
+{
+
+// Puts chunks into states the simulation would not reach on its own, such as a random soup
+// asleep, so that every path of the kernels can be timed with the same cells.
+class ChunkBenchmark
+{
+public:
+	static void setSleepMode(Chunk& chunk, Chunk::ESleepMode mode) { chunk.m_sleepMode = mode; }
+
+	// Same representation as the chunk would settle in after applying, see Chunk::applyCellStates().
+	static void settleRepresentation(Chunk& chunk) {
+		chunk.m_representation = (chunk.m_aliveCells > Chunk::SPARSE_EXIT_POPULATION) ? Chunk::Dense : Chunk::Sparse;
+	}
+};
+
+}
+
+using namespace gol;
+
+
+struct Config
+{
+	Chunk::ESleepMode mode;
+	float density;
+	bool surrounded; //> All eight neighbours exist, with the same density of cells.
+};
+
+struct Result
+{
+	Config config;
+	Chunk::ERepresentation representation;
+	double updateNs; //> Median time of updateCellStates() per chunk.
+	double applyNs;  //> Median time of applyCellStates() per chunk.
+};
+
+static const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+static const int CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE;
+
+// Neighbourhoods per pass. Centre chunks are far enough apart that they never neighbour each other.
+static const int NEIGHBOURHOODS = 256;
+static const int NEIGHBOURHOOD_SPACING = 4;
+
+static const Chunk::ESleepMode MODES[] = { Chunk::Awake, Chunk::BorderOnly, Chunk::Sleeping };
+static const float DENSITIES[] = { 0.f, 0.05f, 0.35f, 1.f };
+
+
+//////////////////////////////////////////////////////////////////////
+static const char* getModeName(Chunk::ESleepMode mode)
+{
+	switch (mode)
+	{
+	case Chunk::Awake:      return "awake";
+	case Chunk::BorderOnly: return "border-only";
+	case Chunk::Sleeping:   return "sleeping";
+	case Chunk::Periodic:   return "periodic";
+	}
+	return "unknown";
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static void fillCells(std::mt19937_64& rng, float density, uint64_t out_cells[Chunk::CHUNK_SIZE])
+{
+	// Exactly the same number of cells in every chunk, so every chunk takes the same path
+	std::vector<int> indices(CHUNK_CELLS);
+	std::iota(indices.begin(), indices.end(), 0);
+	const int count = static_cast<int>(density * CHUNK_CELLS + 0.5f);
+	for (int i = 0; i < count; i++)
+		std::swap(indices[i], indices[i + rng() % (CHUNK_CELLS - i)]);
+
+	std::fill(out_cells, out_cells + CHUNK_SIZE, 0);
+	for (int i = 0; i < count; i++)
+		out_cells[indices[i] / CHUNK_SIZE] |= uint64_t(1) << (indices[i] % CHUNK_SIZE);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static void runPass(const Config& config, uint64_t seed, bool memo, double& out_updateNs, double& out_applyNs, Chunk::ERepresentation& out_representation)
+{
+	Simulation sim;
+	sim.setThreadCount(1);
+	sim.getChunkMemo().setCapacity(memo ? (1 << 16) : 0);
+
+	// Build neighbourhoods, one chunk or a 3x3 block of chunks each
+	std::mt19937_64 rng(seed);
+	std::vector<Chunk*> centres;
+	uint64_t cells[Chunk::CHUNK_SIZE];
+	for (int i = 0; i < NEIGHBOURHOODS; i++)
+	{
+		const int col = i * NEIGHBOURHOOD_SPACING;
+		for (int row = -1; row <= 1; row++)
+		{
+			for (int c = col - 1; c <= col + 1; c++)
+			{
+				if (!config.surrounded && (c != col || row != 0))
+					continue;
+				Chunk* chunk = sim.getChunkAt(c * CHUNK_SIZE, row * CHUNK_SIZE, true);
+				fillCells(rng, config.density, cells);
+				chunk->setCells(cells);
+				ChunkBenchmark::settleRepresentation(*chunk);
+			}
+		}
+		centres.push_back(sim.getChunkAt(col * CHUNK_SIZE, 0));
+	}
+
+	for (Chunk* chunk : centres)
+		ChunkBenchmark::setSleepMode(*chunk, config.mode);
+	out_representation = centres.front()->getRepresentation();
+
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start = Clock::now();
+	for (Chunk* chunk : centres)
+		chunk->updateCellStates();
+	Clock::time_point updated = Clock::now();
+	for (Chunk* chunk : centres)
+		chunk->applyCellStates();
+	Clock::time_point applied = Clock::now();
+
+	out_updateNs = std::chrono::duration<double, std::nano>(updated - start).count() / centres.size();
+	out_applyNs = std::chrono::duration<double, std::nano>(applied - updated).count() / centres.size();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static void printUsage(const char* program)
+{
+	std::cout
+		<< "usage: " << program << " [options]" << std::endl
+		<< std::endl
+		<< "      --passes N      passes of " << NEIGHBOURHOODS << " chunks each, the median is reported (default: 15)" << std::endl
+		<< "      --memo          enable the chunk memo (disabled by default, to time the kernels themselves)" << std::endl
+		<< "      --filter TEXT   only run sleep modes whose name contains TEXT" << std::endl
+		<< "      --json FILE     write results to FILE as JSON" << std::endl
+		<< "  -h, --help          show this message" << std::endl;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+	unsigned int passes = 15;
+	bool memo = false;
+	std::string filter;
+	std::string jsonPath;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const bool hasValue = (i + 1 < argc);
+		if (arg == "-h" || arg == "--help")
+		{
+			printUsage(argv[0]);
+			return 0;
+		}
+		else if (arg == "--memo")
+			memo = true;
+		else if (arg == "--passes" && hasValue)
+			passes = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		else if (arg == "--filter" && hasValue)
+			filter = argv[++i];
+		else if (arg == "--json" && hasValue)
+			jsonPath = argv[++i];
+		else
+		{
+			std::cerr << "unknown option " << arg << std::endl;
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	std::cout << "game of life v" << VERSION_STRING << " chunk kernels, median of " << passes << " passes of "
+	          << NEIGHBOURHOODS << " chunks" << (memo ? ", memo enabled" : "") << std::endl
+	          << std::endl
+	          << std::left << std::setw(13) << "mode" << std::setw(9) << "density" << std::setw(12) << "neighbours" << std::setw(8) << "repr"
+	          << std::right << std::setw(17) << "update ns/chunk" << std::setw(16) << "update ns/cell"
+	          << std::setw(16) << "apply ns/chunk" << std::setw(15) << "apply ns/cell" << std::endl;
+
+	std::vector<Result> results;
+	for (Chunk::ESleepMode mode : MODES)
+	{
+		if (!filter.empty() && std::string(getModeName(mode)).find(filter) == std::string::npos)
+			continue;
+
+		for (float density : DENSITIES)
+		{
+			for (bool surrounded : { false, true })
+			{
+				Result result;
+				result.config = { mode, density, surrounded };
+
+				// Each pass steps fresh chunks, as stepping the same cells again would be a different path
+				std::vector<double> update(passes), apply(passes);
+				for (unsigned int pass = 0; pass < passes; pass++)
+					runPass(result.config, pass + 1, memo, update[pass], apply[pass], result.representation);
+				std::sort(update.begin(), update.end());
+				std::sort(apply.begin(), apply.end());
+				result.updateNs = update[passes / 2];
+				result.applyNs = apply[passes / 2];
+				results.push_back(result);
+
+				std::cout << std::left << std::setw(13) << getModeName(mode)
+				          << std::setw(9) << (std::to_string(static_cast<int>(density * 100)) + "%")
+				          << std::setw(12) << (surrounded ? "surrounded" : "isolated")
+				          << std::setw(8) << (result.representation == Chunk::Dense ? "dense" : "sparse")
+				          << std::right << std::fixed
+				          << std::setprecision(1) << std::setw(17) << result.updateNs
+				          << std::setprecision(3) << std::setw(16) << result.updateNs / CHUNK_CELLS
+				          << std::setprecision(1) << std::setw(16) << result.applyNs
+				          << std::setprecision(3) << std::setw(15) << result.applyNs / CHUNK_CELLS
+				          << std::defaultfloat << std::endl;
+			}
+		}
+	}
+
+	if (!jsonPath.empty())
+	{
+		std::ofstream json(jsonPath);
+		if (!json)
+		{
+			std::cerr << "could not write " << jsonPath << "!" << std::endl;
+			return 1;
+		}
+
+		json << "{" << std::endl
+		     << "  \"version\": \"" << VERSION_STRING << "\"," << std::endl
+		     << "  \"chunks_per_pass\": " << NEIGHBOURHOODS << "," << std::endl
+		     << "  \"passes\": " << passes << "," << std::endl
+		     << "  \"memo\": " << (memo ? "true" : "false") << "," << std::endl
+		     << "  \"results\": [" << std::endl;
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& r = results[i];
+			json << "    { \"mode\": \"" << getModeName(r.config.mode) << "\""
+			     << ", \"density\": " << r.config.density
+			     << ", \"neighbours\": \"" << (r.config.surrounded ? "surrounded" : "isolated") << "\""
+			     << ", \"representation\": \"" << (r.representation == Chunk::Dense ? "dense" : "sparse") << "\""
+			     << ", \"update_ns_per_chunk\": " << r.updateNs
+			     << ", \"update_ns_per_cell\": " << r.updateNs / CHUNK_CELLS
+			     << ", \"apply_ns_per_chunk\": " << r.applyNs
+			     << ", \"apply_ns_per_cell\": " << r.applyNs / CHUNK_CELLS
+			     << " }" << (i + 1 < results.size() ? "," : "") << std::endl;
+		}
+		json << "  ]" << std::endl
+		     << "}" << std::endl;
+		std::cout << std::endl << "results written to " << jsonPath << std::endl;
+	}
+
+	return 0;
+}
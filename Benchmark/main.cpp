@@ -0,0 +1,585 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// Benchmark/main.cpp
+// 
+// Entry point of the benchmark suite. Runs a fixed corpus of patterns and
+// seeded random soups under several rules, without rendering, and reports
+// throughput and memory of each run. Results can be written as JSON to
+// track regressions between builds.
+// 
+
+#include "gol/Simulation.hpp"
+#include "gol/Pattern.hpp"
+#include "Version.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if !defined(__linux__) && (defined(__unix__) || defined(__APPLE__))
+#include <sys/resource.h>
+#endif
+
+using namespace gol;
+
+
+struct Case
+{
+	const char* name;
+	const char* rle;         //> Pattern, or nullptr for a random soup.
+	const char* rule;        //> Rule the pattern is made for, or nullptr to run under every benchmark rule.
+	int soupSize;            //> Width and height of the soup.
+	float soupDensity;
+	unsigned int generations;
+};
+
+struct Result
+{
+	std::string name;
+	std::string rule;
+	unsigned int generations;
+	unsigned int population;  //> Final population, changes when results are no longer comparable.
+	double seconds;
+	double generationsPerSecond;
+	double cellsPerSecond;
+	unsigned int peakChunks;
+	size_t peakRSS;           //> Peak resident memory in bytes, 0 if unknown.
+};
+
+// Patterns die out quickly under other rules, so only soups are run under each of these.
+// Soups are always seeded the same, so every run steps the same cells.
+static const uint64_t SOUP_SEED = 20190817;
+
+static const Case CORPUS[] = {
+	{ "r-pentomino",      "x = 3, y = 3\nb2o$2ob$bo!", "B3/S23", 0, 0.f, 2000 },
+	{ "acorn",            "x = 7, y = 3\nbo5b$3bo3b$2o2b3o!", "B3/S23", 0, 0.f, 6000 },
+	{ "gosper-gun",       "x = 36, y = 9\n24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$"
+	                      "2o8bo3bob2o4bobo$10bo5bo7bo$11bo3bo$12b2o!", "B3/S23", 0, 0.f, 6000 },
+	{ "switch-engine",    "x = 8, y = 6\n6bob$4bob2o$4bobob$4bo3b$2bo5b$obo!", "B3/S23", 0, 0.f, 10000 },
+	{ "soup-dense-256",   nullptr, nullptr,  256, 0.50f, 1000 },
+	{ "soup-dense-1024",  nullptr, nullptr, 1024, 0.50f,  200 },
+	{ "soup-dense-4096",  nullptr, nullptr, 4096, 0.50f,   20 },
+	{ "soup-sparse-1024", nullptr, nullptr, 1024, 0.05f,  500 },
+	{ "soup-sparse-4096", nullptr, nullptr, 4096, 0.05f,  100 },
+};
+
+// API calls timed apart from stepping, each against a baseline doing the same work another way.
+struct QueryResult
+{
+	std::string name;
+	double seconds;          //> Median seconds per call.
+	double baselineSeconds;  //> Median seconds per call of the baseline.
+	uint64_t items;          //> Chunks or cells handled per call, the same for the call and its baseline.
+	size_t peakRSS;
+};
+
+struct QueryCase
+{
+	const char* name;
+	const char* description;
+	void (*run)(unsigned int repeat, QueryResult& out_result);
+};
+
+static void runViewportQuery(unsigned int repeat, QueryResult& out_result);
+static void runStamp(unsigned int repeat, QueryResult& out_result);
+static void runRegionReadDense(unsigned int repeat, QueryResult& out_result);
+static void runRegionReadSparse(unsigned int repeat, QueryResult& out_result);
+
+static const QueryCase QUERIES[] = {
+	{ "viewport-1m",        "forEachChunkIn() of a 1920x1080 viewport of 1M chunks, against scanning every chunk", runViewportQuery },
+	{ "stamp-4096",         "stampCells() of a 4096x4096 soup, against a setCell() loop", runStamp },
+	{ "read-16k-dense",     "forEachSpanIn() of a 16384x16384 soup of density 0.35, against readCells()", runRegionReadDense },
+	{ "read-16k-sparse",    "forEachSpanIn() of a 16384x16384 soup of density 0.01, against readCells()", runRegionReadSparse },
+};
+
+static const char* RULES[] = {
+	"B3/S23",        // Life
+	"B36/S23",       // HighLife
+	"B3678/S34678",  // Day & Night
+	"B34/S34",       // 34 Life
+};
+
+
+//////////////////////////////////////////////////////////////////////
+static void resetPeakRSS()
+{
+#if defined(__linux__)
+	// Hand memory freed by the last case back to the system, then writing 5 resets
+	// the peak resident set size of the process (VmHWM) to what is resident now
+#if defined(__GLIBC__)
+	malloc_trim(0);
+#endif
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+#endif
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static size_t getPeakRSS()
+{
+#if defined(__linux__)
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, 6, "VmHWM:") == 0)
+			return static_cast<size_t>(std::strtoull(line.c_str() + 6, nullptr, 10)) * 1024;
+	}
+	return 0;
+#elif defined(__APPLE__)
+	struct rusage usage;
+	return (getrusage(RUSAGE_SELF, &usage) == 0) ? static_cast<size_t>(usage.ru_maxrss) : 0;
+#elif defined(__unix__)
+	struct rusage usage;
+	return (getrusage(RUSAGE_SELF, &usage) == 0) ? static_cast<size_t>(usage.ru_maxrss) * 1024 : 0;
+#else
+	return 0;
+#endif
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static Result runCase(const Case& c, const Pattern& pattern, const Ruleset& ruleset, size_t threads)
+{
+	resetPeakRSS();
+
+	Simulation sim;
+	sim.setThreadCount(threads);
+	sim.setRuleset(ruleset);
+	pattern.place(sim, -pattern.getWidth() / 2, -pattern.getHeight() / 2);
+
+	typedef std::chrono::steady_clock Clock;
+	uint64_t cellsStepped = 0;
+	unsigned int peakChunks = sim.getChunkCount();
+	const Clock::time_point start = Clock::now();
+	for (unsigned int i = 0; i < c.generations; i++)
+	{
+		cellsStepped += sim.getPopulation();
+		sim.step();
+		peakChunks = std::max(peakChunks, sim.getChunkCount());
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	Result result;
+	result.name = c.name;
+	result.rule = ruleset.getString();
+	result.generations = c.generations;
+	result.population = sim.getPopulation();
+	result.seconds = seconds;
+	result.generationsPerSecond = (seconds > 0) ? c.generations / seconds : 0;
+	result.cellsPerSecond = (seconds > 0) ? cellsStepped / seconds : 0;
+	result.peakChunks = peakChunks;
+	result.peakRSS = getPeakRSS();
+	return result;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+template<class F, class P>
+static double timeCalls(unsigned int calls, unsigned int repeat, F call, P prepare)
+{
+	// Median seconds per call of each repeat, preparing before each repeat untimed
+	typedef std::chrono::steady_clock Clock;
+	std::vector<double> times;
+	for (unsigned int r = 0; r < repeat; r++)
+	{
+		prepare();
+		const Clock::time_point start = Clock::now();
+		for (unsigned int i = 0; i < calls; i++)
+			call(i);
+		times.push_back(std::chrono::duration<double>(Clock::now() - start).count() / calls);
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+
+//////////////////////////////////////////////////////////////////////
+template<class F>
+static double timeCalls(unsigned int calls, unsigned int repeat, F call)
+{
+	return timeCalls(calls, repeat, call, []() {});
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static void runViewportQuery(unsigned int repeat, QueryResult& out_result)
+{
+	// Empty chunks, as the chunk index is under test rather than cells
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	const int SIDE = 1024;
+	const int VIEW_WIDTH = 1920, VIEW_HEIGHT = 1080;
+	Simulation sim;
+	sim.setThreadCount(1);
+	for (int col = 0; col < SIDE; col++)
+		for (int row = 0; row < SIDE; row++)
+			sim.getChunkAt(col * CHUNK_SIZE, row * CHUNK_SIZE, true);
+
+	std::vector<std::pair<int, int>> views;
+	uint64_t seed = SOUP_SEED;
+	for (int i = 0; i < 1000; i++)
+	{
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		views.push_back({ static_cast<int>((seed >> 33) % (SIDE * CHUNK_SIZE - VIEW_WIDTH)), static_cast<int>((seed >> 13) % (SIDE * CHUNK_SIZE - VIEW_HEIGHT)) });
+	}
+
+	const unsigned int SCANS = 10;
+	uint64_t visited = 0, scanned = 0;
+	out_result.seconds = timeCalls(static_cast<unsigned int>(views.size()), repeat, [&](unsigned int i) {
+		const std::pair<int, int>& view = views[i];
+		sim.forEachChunkIn(view.first, view.second, view.first + VIEW_WIDTH - 1, view.second + VIEW_HEIGHT - 1, [&visited](const Chunk*) { visited++; });
+	}, [&visited]() { visited = 0; });
+	out_result.items = visited / views.size();
+
+	// Scanning every chunk is slow, so fewer viewports are scanned
+	std::vector<const Chunk*> chunks;
+	out_result.baselineSeconds = timeCalls(SCANS, repeat, [&](unsigned int i) {
+		const std::pair<int, int>& view = views[i];
+		const int left = view.first / CHUNK_SIZE, right = (view.first + VIEW_WIDTH - 1) / CHUNK_SIZE;
+		const int top = view.second / CHUNK_SIZE, bottom = (view.second + VIEW_HEIGHT - 1) / CHUNK_SIZE;
+		chunks.clear();
+		sim.getAllChunks(chunks);
+		for (const Chunk* chunk : chunks)
+			if (chunk->getColumn() >= left && chunk->getColumn() <= right && chunk->getRow() >= top && chunk->getRow() <= bottom)
+				scanned++;
+	}, [&scanned]() { scanned = 0; });
+
+	visited = 0;
+	for (unsigned int i = 0; i < SCANS; i++)
+		sim.forEachChunkIn(views[i].first, views[i].second, views[i].first + VIEW_WIDTH - 1, views[i].second + VIEW_HEIGHT - 1, [&visited](const Chunk*) { visited++; });
+	if (visited != scanned)
+		std::cerr << "viewport query and scan found different chunks!" << std::endl;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static void runStamp(unsigned int repeat, QueryResult& out_result)
+{
+	Pattern soup;
+	soup.randomize(4096, 4096, 0.35f, SOUP_SEED);
+
+	// Only stamping is timed, not freeing cells stamped before
+	Simulation sim;
+	sim.setThreadCount(1);
+	out_result.seconds = timeCalls(1, repeat, [&](unsigned int) {
+		soup.place(sim, 0, 0);
+	}, [&sim]() { sim.reset(); });
+	const unsigned int stamped = sim.getPopulation();
+
+	out_result.baselineSeconds = timeCalls(1, repeat, [&](unsigned int) {
+		for (int y = 0; y < soup.getHeight(); y++)
+			for (int x = 0; x < soup.getWidth(); x++)
+				if (soup.getCell(x, y))
+					sim.setCell(x, y, true);
+	}, [&sim]() { sim.reset(); });
+
+	out_result.items = soup.getCellCount();
+	if (stamped != soup.getCellCount() || sim.getPopulation() != soup.getCellCount())
+		std::cerr << "stamped and set cells differ!" << std::endl;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static void runRegionRead(float density, unsigned int repeat, QueryResult& out_result)
+{
+	const int SIZE = 16384;
+	Simulation sim;
+	sim.setThreadCount(1);
+	{
+		Pattern soup;
+		soup.randomize(SIZE, SIZE, density, SOUP_SEED);
+		soup.place(sim, 0, 0);
+	}
+
+	uint64_t spanCells = 0;
+	out_result.seconds = timeCalls(1, repeat, [&](unsigned int) {
+		spanCells = 0;
+		sim.forEachSpanIn(0, 0, SIZE - 1, SIZE - 1, [&spanCells](const CellSpan& span) { spanCells += span.length; });
+	});
+
+	const size_t stride = SIZE / 64;
+	std::vector<uint64_t> bitmap(stride * SIZE);
+	out_result.baselineSeconds = timeCalls(1, repeat, [&](unsigned int) {
+		sim.readCells(0, 0, SIZE, SIZE, bitmap.data(), stride);
+	});
+
+	uint64_t bitmapCells = 0;
+	for (uint64_t word : bitmap)
+		for (; word != 0; word &= word - 1)
+			bitmapCells++;
+
+	out_result.items = sim.getPopulation();
+	if (spanCells != out_result.items || bitmapCells != out_result.items)
+		std::cerr << "cells read as spans and as a bitmap differ!" << std::endl;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static void runRegionReadDense(unsigned int repeat, QueryResult& out_result)
+{
+	runRegionRead(0.35f, repeat, out_result);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static void runRegionReadSparse(unsigned int repeat, QueryResult& out_result)
+{
+	runRegionRead(0.01f, repeat, out_result);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static QueryResult runQuery(const QueryCase& q, unsigned int repeat)
+{
+	resetPeakRSS();
+
+	QueryResult result;
+	result.name = q.name;
+	q.run(repeat, result);
+	result.peakRSS = getPeakRSS();
+	return result;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static void writeJSON(std::ostream& out, const std::vector<Result>& results, const std::vector<QueryResult>& queryResults, size_t threads, unsigned int repeat)
+{
+	out << std::setprecision(6)
+	    << "{" << std::endl
+	    << "  \"version\": \"" << VERSION_STRING << "\"," << std::endl
+	    << "  \"threads\": " << threads << "," << std::endl
+	    << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << "," << std::endl
+	    << "  \"repeat\": " << repeat << "," << std::endl
+	    << "  \"results\": [" << std::endl;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		out << "    { \"name\": \"" << r.name << "\", \"rule\": \"" << r.rule << "\""
+		    << ", \"generations\": " << r.generations
+		    << ", \"population\": " << r.population
+		    << ", \"seconds\": " << r.seconds
+		    << ", \"generations_per_second\": " << r.generationsPerSecond
+		    << ", \"cells_per_second\": " << r.cellsPerSecond
+		    << ", \"peak_chunks\": " << r.peakChunks
+		    << ", \"peak_rss_bytes\": " << r.peakRSS
+		    << " }" << (i + 1 < results.size() ? "," : "") << std::endl;
+	}
+	out << "  ]," << std::endl
+	    << "  \"queries\": [" << std::endl;
+	for (size_t i = 0; i < queryResults.size(); i++)
+	{
+		const QueryResult& r = queryResults[i];
+		out << "    { \"name\": \"" << r.name << "\""
+		    << ", \"seconds\": " << r.seconds
+		    << ", \"baseline_seconds\": " << r.baselineSeconds
+		    << ", \"items\": " << r.items
+		    << ", \"peak_rss_bytes\": " << r.peakRSS
+		    << " }" << (i + 1 < queryResults.size() ? "," : "") << std::endl;
+	}
+	out << "  ]" << std::endl
+	    << "}" << std::endl;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static void printUsage(const char* program)
+{
+	std::cout
+		<< "usage: " << program << " [options]" << std::endl
+		<< std::endl
+		<< "  -t, --threads N     worker threads, 1 runs single-threaded (default: 0, one per core)" << std::endl
+		<< "      --repeat N      runs of each case, the median is reported (default: 3)" << std::endl
+		<< "      --filter TEXT   only run cases and queries whose name contains TEXT" << std::endl
+		<< "      --rule RULE     run every case under RULE only, instead of the benchmark rules" << std::endl
+		<< "      --json FILE     write results to FILE as JSON" << std::endl
+		<< "      --list          list cases and rules, then exit" << std::endl
+		<< "  -h, --help          show this message" << std::endl;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+	size_t threads = 0;
+	unsigned int repeat = 3;
+	std::string filter;
+	std::vector<std::string> rules(std::begin(RULES), std::end(RULES));
+	bool ruleGiven = false;
+	std::string jsonPath;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const bool hasValue = (i + 1 < argc);
+		if (arg == "-h" || arg == "--help")
+		{
+			printUsage(argv[0]);
+			return 0;
+		}
+		else if (arg == "--list")
+		{
+			for (const Case& c : CORPUS)
+				std::cout << c.name << " (" << c.generations << " generations" << (c.rule ? std::string(", ") + c.rule : "") << ")" << std::endl;
+			for (const std::string& rule : rules)
+				std::cout << "rule " << rule << std::endl;
+			for (const QueryCase& q : QUERIES)
+				std::cout << q.name << " (" << q.description << ")" << std::endl;
+			return 0;
+		}
+		else if ((arg == "-t" || arg == "--threads") && hasValue)
+			threads = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (arg == "--repeat" && hasValue)
+			repeat = std::max(1u, static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+		else if (arg == "--filter" && hasValue)
+			filter = argv[++i];
+		else if (arg == "--rule" && hasValue)
+		{
+			rules.assign(1, argv[++i]);
+			ruleGiven = true;
+		}
+		else if (arg == "--json" && hasValue)
+			jsonPath = argv[++i];
+		else
+		{
+			std::cerr << "unknown option " << arg << std::endl;
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::cout << "game of life v" << VERSION_STRING << " benchmark, " << threads << " thread(s), median of " << repeat << std::endl
+	          << std::endl
+	          << std::left << std::setw(18) << "case" << std::setw(15) << "rule"
+	          << std::right << std::setw(8) << "gens" << std::setw(12) << "gen/s" << std::setw(14) << "cells/s"
+	          << std::setw(10) << "chunks" << std::setw(10) << "rss (MB)" << std::setw(12) << "population" << std::endl;
+
+	std::vector<Result> results;
+	for (const Case& c : CORPUS)
+	{
+		if (!filter.empty() && std::string(c.name).find(filter) == std::string::npos)
+			continue;
+
+		Pattern pattern;
+		if (c.rle)
+		{
+			std::istringstream rle(c.rle);
+			pattern.parse(rle);
+		}
+		else
+		{
+			pattern.randomize(c.soupSize, c.soupSize, c.soupDensity, SOUP_SEED);
+		}
+
+		std::vector<std::string> caseRules = rules;
+		if (c.rule && !ruleGiven)
+			caseRules.assign(1, c.rule);
+
+		for (const std::string& rule : caseRules)
+		{
+			Ruleset ruleset;
+			if (!ruleset.set(rule))
+			{
+				std::cerr << "invalid rule-string " << rule << std::endl;
+				return 1;
+			}
+
+			// Report the run with the median time, peaks are the same between runs
+			std::vector<Result> runs;
+			for (unsigned int i = 0; i < repeat; i++)
+				runs.push_back(runCase(c, pattern, ruleset, threads));
+			std::sort(runs.begin(), runs.end(), [](const Result& a, const Result& b) { return a.seconds < b.seconds; });
+			Result result = runs[runs.size() / 2];
+			for (const Result& run : runs)
+				result.peakRSS = std::max(result.peakRSS, run.peakRSS);
+			results.push_back(result);
+
+			std::cout << std::left << std::setw(18) << result.name << std::setw(15) << result.rule << std::right
+			          << std::setw(8) << result.generations
+			          << std::fixed << std::setprecision(1)
+			          << std::setw(12) << result.generationsPerSecond
+			          << std::scientific << std::setprecision(3)
+			          << std::setw(14) << result.cellsPerSecond
+			          << std::setw(10) << result.peakChunks
+			          << std::fixed << std::setprecision(1)
+			          << std::setw(10) << result.peakRSS / (1024.0 * 1024.0)
+			          << std::setw(12) << result.population
+			          << std::defaultfloat << std::endl;
+		}
+	}
+
+	// API calls, each against its baseline
+	std::vector<QueryResult> queryResults;
+	for (const QueryCase& q : QUERIES)
+	{
+		if (!filter.empty() && std::string(q.name).find(filter) == std::string::npos)
+			continue;
+
+		if (queryResults.empty())
+			std::cout << std::endl
+			          << std::left << std::setw(18) << "query" << std::right << std::setw(14) << "ms/call" << std::setw(14) << "baseline ms"
+			          << std::setw(10) << "speedup" << std::setw(12) << "items" << std::setw(10) << "rss (MB)" << std::endl;
+
+		const QueryResult result = runQuery(q, repeat);
+		queryResults.push_back(result);
+
+		std::cout << std::left << std::setw(18) << result.name << std::right
+		          << std::fixed << std::setprecision(3)
+		          << std::setw(14) << result.seconds * 1000.0
+		          << std::setw(14) << result.baselineSeconds * 1000.0
+		          << std::setprecision(1)
+		          << std::setw(9) << ((result.seconds > 0) ? result.baselineSeconds / result.seconds : 0) << "x"
+		          << std::setw(12) << result.items
+		          << std::setw(10) << result.peakRSS / (1024.0 * 1024.0)
+		          << std::defaultfloat << std::endl;
+	}
+
+	if (!jsonPath.empty())
+	{
+		std::ofstream json(jsonPath);
+		if (!json)
+		{
+			std::cerr << "could not write " << jsonPath << "!" << std::endl;
+			return 1;
+		}
+		writeJSON(json, results, queryResults, threads, repeat);
+		std::cout << std::endl << "results written to " << jsonPath << std::endl;
+	}
+
+	return 0;
+}
@@ -65,6 +65,27 @@ void MenuScene::init()
 			m_menuSettings.targetFPSIdx = i;
 	}
 
+	// Default is an unbounded universe, bounded universes are 512x512
+	std::string universe = settings.getString("universe", "unbounded");
+	for (int i = 0; i < m_menuSettings.universeMax; i++)
+	{
+		if (universe == m_menuSettings.universeArr[i])
+			m_menuSettings.universeIdx = i;
+	}
+	int boundedWidth  = settings.getInteger("bounded_width", 512);
+	int boundedHeight = settings.getInteger("bounded_height", 512);
+	for (int i = 0; i < m_menuSettings.boundedSizeMax; i++)
+	{
+		if (m_menuSettings.boundedSizeArr[i] <= boundedWidth)
+			m_menuSettings.boundedWidthIdx = i;
+		if (m_menuSettings.boundedSizeArr[i] <= boundedHeight)
+			m_menuSettings.boundedHeightIdx = i;
+	}
+
+	// Store the sizes actually shown, so out-of-range settings never reach the universe
+	settings.setInteger("bounded_width", m_menuSettings.boundedSizeArr[m_menuSettings.boundedWidthIdx]);
+	settings.setInteger("bounded_height", m_menuSettings.boundedSizeArr[m_menuSettings.boundedHeightIdx]);
+
 	this->invalidate();
 }
 
@@ -191,7 +212,14 @@ void MenuScene::menuMain_onInvalidate()
 	m_ss << "implementation by nathan cousins" << std::endl;
 	m_ss << std::endl;
 	m_ss << std::endl;
-	m_ss << "      " << (m_menuMain.selection == 0 ? "> " : "  ") << "start (" << m_menuRuleset.rules << ")" << std::endl;
+	m_ss << "      " << (m_menuMain.selection == 0 ? "> " : "  ") << "start (" << m_menuRuleset.rules;
+	if (m_menuSettings.universeIdx != 0)
+	{
+		m_ss << ", " << m_menuSettings.universeArr[m_menuSettings.universeIdx] << " "
+		     << m_menuSettings.boundedSizeArr[m_menuSettings.boundedWidthIdx] << "x"
+		     << m_menuSettings.boundedSizeArr[m_menuSettings.boundedHeightIdx];
+	}
+	m_ss << ")" << std::endl;
 	m_ss << "      " << (m_menuMain.selection == 1 ? "> " : "  ") << "change ruleset" << std::endl;
 	m_ss << "      " << (m_menuMain.selection == 2 ? "> " : "  ") << "settings" << std::endl;
 	m_ss << "      " << (m_menuMain.selection == 3 ? "> " : "  ") << "exit" << std::endl;
@@ -432,7 +460,21 @@ void MenuScene::menuSettings_onInvalidate()
 		m_ss << "no limit" << std::endl;
 	else
 		m_ss << targetFramerate << std::endl;
-	m_ss << "      " << (m_menuSettings.selection == 1 ? "> " : "  ") << "exit" << std::endl;
+	m_ss << "      " << (m_menuSettings.selection == 1 ? "> " : "  ") << "universe: "
+	     << m_menuSettings.universeArr[m_menuSettings.universeIdx] << std::endl;
+	if (m_menuSettings.universeIdx != 0)
+	{
+		m_ss << "      " << (m_menuSettings.selection == 2 ? "> " : "  ") << "universe width: "
+		     << m_menuSettings.boundedSizeArr[m_menuSettings.boundedWidthIdx] << std::endl;
+		m_ss << "      " << (m_menuSettings.selection == 3 ? "> " : "  ") << "universe height: "
+		     << m_menuSettings.boundedSizeArr[m_menuSettings.boundedHeightIdx] << std::endl;
+	}
+	else
+	{
+		m_ss << std::endl;
+		m_ss << std::endl;
+	}
+	m_ss << "      " << (m_menuSettings.selection == 4 ? "> " : "  ") << "exit" << std::endl;
 }
 
 
@@ -442,7 +484,7 @@ bool MenuScene::menuSettings_onKeyPress(sf::Keyboard::Key key)
 	switch (key)
 	{
 	case sf::Keyboard::Return:
-		if (m_menuSettings.selection == 1) // exit
+		if (m_menuSettings.selection == 4) // exit
 		{
 			m_currentMenu = MainMenu;
 			return true;
@@ -450,9 +492,12 @@ bool MenuScene::menuSettings_onKeyPress(sf::Keyboard::Key key)
 		break;
 
 	case sf::Keyboard::Down:
-		if (m_menuSettings.selection < 1)
+		if (m_menuSettings.selection < 4)
 		{
 			m_menuSettings.selection++;
+			// Universe size is only available for bounded universes
+			if (m_menuSettings.universeIdx == 0 && m_menuSettings.selection == 2)
+				m_menuSettings.selection = 4;
 			return true;
 		}
 		break;
@@ -461,6 +506,9 @@ bool MenuScene::menuSettings_onKeyPress(sf::Keyboard::Key key)
 		if (m_menuSettings.selection > 0)
 		{
 			m_menuSettings.selection--;
+			// Universe size is only available for bounded universes
+			if (m_menuSettings.universeIdx == 0 && m_menuSettings.selection == 3)
+				m_menuSettings.selection = 1;
 			return true;
 		}
 		break;
@@ -474,6 +522,24 @@ bool MenuScene::menuSettings_onKeyPress(sf::Keyboard::Key key)
 			UserSettings::instance().setInteger("target_framerate", tfr);
 			return true;
 		}
+		else if (m_menuSettings.selection == 1)
+		{
+			m_menuSettings.universeIdx = std::max(0, m_menuSettings.universeIdx - 1);
+			UserSettings::instance().setString("universe", m_menuSettings.universeArr[m_menuSettings.universeIdx]);
+			return true;
+		}
+		else if (m_menuSettings.selection == 2)
+		{
+			m_menuSettings.boundedWidthIdx = std::max(0, m_menuSettings.boundedWidthIdx - 1);
+			UserSettings::instance().setInteger("bounded_width", m_menuSettings.boundedSizeArr[m_menuSettings.boundedWidthIdx]);
+			return true;
+		}
+		else if (m_menuSettings.selection == 3)
+		{
+			m_menuSettings.boundedHeightIdx = std::max(0, m_menuSettings.boundedHeightIdx - 1);
+			UserSettings::instance().setInteger("bounded_height", m_menuSettings.boundedSizeArr[m_menuSettings.boundedHeightIdx]);
+			return true;
+		}
 		break;
 
 	case sf::Keyboard::Right:
@@ -485,6 +551,24 @@ bool MenuScene::menuSettings_onKeyPress(sf::Keyboard::Key key)
 			UserSettings::instance().setInteger("target_framerate", tfr);
 			return true;
 		}
+		else if (m_menuSettings.selection == 1)
+		{
+			m_menuSettings.universeIdx = std::min(m_menuSettings.universeMax - 1, m_menuSettings.universeIdx + 1);
+			UserSettings::instance().setString("universe", m_menuSettings.universeArr[m_menuSettings.universeIdx]);
+			return true;
+		}
+		else if (m_menuSettings.selection == 2)
+		{
+			m_menuSettings.boundedWidthIdx = std::min(m_menuSettings.boundedSizeMax - 1, m_menuSettings.boundedWidthIdx + 1);
+			UserSettings::instance().setInteger("bounded_width", m_menuSettings.boundedSizeArr[m_menuSettings.boundedWidthIdx]);
+			return true;
+		}
+		else if (m_menuSettings.selection == 3)
+		{
+			m_menuSettings.boundedHeightIdx = std::min(m_menuSettings.boundedSizeMax - 1, m_menuSettings.boundedHeightIdx + 1);
+			UserSettings::instance().setInteger("bounded_height", m_menuSettings.boundedSizeArr[m_menuSettings.boundedHeightIdx]);
+			return true;
+		}
 		break;
 	}
 	return false;
@@ -107,6 +107,13 @@ private:
 		int targetFPSIdx = 3;
 		const int targetFPSMax = 8;
 		const int targetFramerateArr[8] = { 0, 24, 30, 60, 120, 144, 240, 300 };
+		int universeIdx = 0;
+		const int universeMax = 3;
+		const char* const universeArr[3] = { "unbounded", "bounded", "torus" };
+		int boundedWidthIdx = 3;
+		int boundedHeightIdx = 3;
+		const int boundedSizeMax = 9;
+		const int boundedSizeArr[9] = { 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384 };
 	} m_menuSettings;
 	void menuSettings_onInvalidate();
 	bool menuSettings_onKeyPress(sf::Keyboard::Key);
@@ -0,0 +1,98 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// OverlayLayer.cpp
+// 
+// Implements class OverlayLayer
+// 
+
+#include "OverlayLayer.hpp"
+
+
+//////////////////////////////////////////////////////////////////////
+OverlayLayer::OverlayLayer()
+	: m_vertices(sf::Quads)
+	, m_key(0)
+	, m_built(false)
+{
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool OverlayLayer::rebuild(uint64_t key)
+{
+	if (m_built && m_key == key)
+		return false;
+
+	m_vertices.clear();
+	m_key = key;
+	m_built = true;
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void OverlayLayer::clear()
+{
+	m_vertices.clear();
+	m_built = false;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void OverlayLayer::addRect(const sf::FloatRect& rect, const sf::Color& color)
+{
+	m_vertices.append(sf::Vertex(sf::Vector2f(rect.left, rect.top), color));
+	m_vertices.append(sf::Vertex(sf::Vector2f(rect.left + rect.width, rect.top), color));
+	m_vertices.append(sf::Vertex(sf::Vector2f(rect.left + rect.width, rect.top + rect.height), color));
+	m_vertices.append(sf::Vertex(sf::Vector2f(rect.left, rect.top + rect.height), color));
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void OverlayLayer::addOutline(const sf::FloatRect& rect, float thickness, const sf::Color& color)
+{
+	// Top and bottom edges span the full width, left and right edges fit between them
+	this->addRect(sf::FloatRect(rect.left, rect.top, rect.width, thickness), color);
+	this->addRect(sf::FloatRect(rect.left, rect.top + rect.height - thickness, rect.width, thickness), color);
+	this->addRect(sf::FloatRect(rect.left, rect.top + thickness, thickness, rect.height - thickness * 2), color);
+	this->addRect(sf::FloatRect(rect.left + rect.width - thickness, rect.top + thickness, thickness, rect.height - thickness * 2), color);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void OverlayLayer::draw(sf::RenderTarget& target, const sf::RenderStates& states) const
+{
+	if (m_vertices.getVertexCount() > 0)
+		target.draw(m_vertices, states);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+uint64_t OverlayLayer::combineKey(uint64_t key, uint64_t value)
+{
+	// Mix each value in so the order of values matters
+	key ^= value + 0x9E3779B97F4A7C15ull + (key << 6) + (key >> 2);
+	return key;
+}
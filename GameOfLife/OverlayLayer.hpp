@@ -0,0 +1,71 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// OverlayLayer.hpp
+//
+// class OverlayLayer
+// 
+// Overlay geometry (grid lines, chunk outlines) batched into one vertex
+// array, so it is drawn in a single call. Geometry is built for a key
+// describing what it depends on, and only rebuilt once the key changes.
+// 
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+
+
+class OverlayLayer
+{
+public:
+	OverlayLayer();
+
+	// Returns true if geometry must be rebuilt for the key given, in which case the old geometry is removed.
+	// Returns false if geometry was already built for the same key.
+	bool rebuild(uint64_t key);
+
+	// Remove all geometry, it will be rebuilt for any key.
+	void clear();
+
+	// Add a filled rectangle.
+	void addRect(const sf::FloatRect& rect, const sf::Color& color);
+
+	// Add outline of a rectangle, drawn inside of it.
+	void addOutline(const sf::FloatRect& rect, float thickness, const sf::Color& color);
+
+	// Draw all geometry in one call.
+	void draw(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default) const;
+
+	// Get count of rectangles.
+	inline size_t getRectCount() const { return m_vertices.getVertexCount() / 4; }
+
+	// Combine a value with a key, for building keys from several values.
+	static uint64_t combineKey(uint64_t key, uint64_t value);
+
+private:
+	sf::VertexArray m_vertices;
+	uint64_t m_key;
+	bool m_built;
+};
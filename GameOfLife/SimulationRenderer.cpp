@@ -31,6 +31,8 @@
 #include "SimulationRenderer.hpp"
 #include "gol/CellManipulation.hpp"
 #include "SceneManager.hpp"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 
@@ -39,11 +41,15 @@ using namespace gol;
 
 //////////////////////////////////////////////////////////////////////
 SimulationRenderer::SimulationRenderer()
-	: m_renderTarget(nullptr)
-	, m_simulation(nullptr)
-	, showChunks(false)
-	, showChunkID(false)
+	: showChunks(false)
 	, showChunksCellCount(false)
+	, showChunkID(false)
+	, m_renderTarget(nullptr)
+	, m_boundedCellGraph(sf::Quads)
+	, m_tilePixels(Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE * 4)
+	, m_tileQuads(sf::Quads)
+	, m_frame(0)
+	, m_regionQuads(sf::Quads)
 {
 
 }
@@ -57,24 +63,86 @@ void SimulationRenderer::setRenderTarget(sf::RenderTarget& renderTarget)
 
 
 //////////////////////////////////////////////////////////////////////
-void SimulationRenderer::setSimulation(const Simulation& simulator)
+void SimulationRenderer::setSnapshot(const std::shared_ptr<const Snapshot>& snapshot)
 {
-	m_simulation = &simulator;
+	m_snapshot = snapshot;
+	m_boundedSnapshot.reset();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationRenderer::setSnapshot(const std::shared_ptr<const BoundedSnapshot>& snapshot)
+{
+	m_boundedSnapshot = snapshot;
+	m_snapshot.reset();
 }
 
 
 //////////////////////////////////////////////////////////////////////
 void SimulationRenderer::render() const
 {
-	sf::RectangleShape chunkRect;
-	if (showChunks)
+	sf::Clock clock;
+	m_submitTime = sf::Time::Zero;
+
+	if (m_boundedSnapshot)
+		this->renderBounded();
+	else if (m_snapshot)
+		this->renderSnapshot();
+
+	m_buildTime = clock.getElapsedTime() - m_submitTime;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationRenderer::submit(const sf::Drawable& drawable, const sf::RenderStates& states) const
+{
+	sf::Clock clock;
+	m_renderTarget->draw(drawable, states);
+	m_submitTime += clock.getElapsedTime();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationRenderer::renderSnapshot() const
+{
+	// Only visit chunks within the cull zone
+	int left   = static_cast<int>(std::floor(cullZone.left));
+	int top    = static_cast<int>(std::floor(cullZone.top));
+	int right  = static_cast<int>(std::ceil(cullZone.left + cullZone.width));
+	int bottom = static_cast<int>(std::ceil(cullZone.top + cullZone.height));
+
+	// Pick the coarsest level of detail which still has a block of cells per screen pixel
+	const float cellsPerPixel = m_renderTarget->getView().getSize().x / m_renderTarget->getSize().x;
+	int level = 0;
+	while (level < Chunk::DENSITY_LEVELS && static_cast<float>(2 << level) <= cellsPerPixel)
+		level++;
+
+	if (level < Chunk::DENSITY_LEVELS)
+		this->renderChunks(left, top, right, bottom, level);
+	else
+		this->renderRegions(left, top, right, bottom, cellsPerPixel);
+
+	// Escaped spaceships are not part of any chunk
+	static sf::VertexArray cellGraph(sf::Quads);
+	cellGraph.clear();
+	for (const std::pair<int,int>& xy : m_snapshot->getEscapeeCells())
 	{
-		chunkRect.setFillColor(sf::Color::Transparent);
-		chunkRect.setOutlineColor(sf::Color(255, 255, 255, 64));
-		chunkRect.setOutlineThickness(-1.f);
-		chunkRect.setSize(sf::Vector2f(static_cast<float>(Chunk::CHUNK_SIZE), static_cast<float>(Chunk::CHUNK_SIZE)));
+		float xcell = static_cast<float>(xy.first);
+		float ycell = static_cast<float>(xy.second);
+		if (xcell + 1 < cullZone.left || ycell + 1 < cullZone.top || xcell > cullZone.left + cullZone.width || ycell > cullZone.top + cullZone.height)
+			continue;
+		cellGraph.append(sf::Vector2f(xcell + 1, ycell + 1));
+		cellGraph.append(sf::Vector2f(xcell + 1, ycell));
+		cellGraph.append(sf::Vector2f(xcell, ycell));
+		cellGraph.append(sf::Vector2f(xcell, ycell + 1));
 	}
+	this->submit(cellGraph);
+}
+
 
+//////////////////////////////////////////////////////////////////////
+void SimulationRenderer::renderChunks(int left, int top, int right, int bottom, int level) const
+{
 	sf::Text chunkText;
 	if (showChunksCellCount)
 	{
@@ -84,70 +152,144 @@ void SimulationRenderer::render() const
 		chunkText.setOutlineThickness(1.5f);
 	}
 
-	m_chunkBuffer.clear();
-	m_simulation->getAllChunks(m_chunkBuffer);
-
 	static sf::VertexArray cellGraph(sf::Quads, Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE * 4);
 
-	for (auto chunk : m_chunkBuffer)
+	m_frame++;
+	m_visibleChunks.clear();
+	m_snapshot->forEachChunkIn(left, top, right, bottom, [this](const ChunkSnapshot& chunk) {
+		m_visibleChunks.push_back(&chunk);
+
+		// Keep tiles of visible chunks
+		auto it = m_tiles.find(chunk.getUniqueID());
+		if (it != m_tiles.end())
+			it->second.lastFrame = m_frame;
+	});
+
+	this->reserveTiles(m_visibleChunks.size());
+
+	// Assign atlas tiles first, the atlas is only used from this thread
+	const size_t TILE_BYTES = Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE * 4;
+	size_t jobs = 0;
+	size_t redraws = 0;
+	m_buildJobs.clear();
+	for (const ChunkSnapshot* chunk : m_visibleChunks)
 	{
-		if (!chunk->isValid())
+		if (chunk->getAliveCells() == 0)
 			continue;
 
-		int col = chunk->getColumn();
-		int row = chunk->getRow();
+		if (jobs == m_chunkJobs.size())
+			m_chunkJobs.emplace_back();
+		ChunkJob& job = m_chunkJobs[jobs];
+		job.chunk = chunk;
+		job.hasTile = this->assignTile(*chunk, level, job.tile, job.redraw);
+		job.pixels = job.redraw ? TILE_BYTES * redraws++ : 0;
+		if (!job.hasTile || job.redraw)
+			m_buildJobs.push_back(jobs);
+		jobs++;
+	}
+	if (m_tilePixels.size() < TILE_BYTES * redraws)
+		m_tilePixels.resize(TILE_BYTES * redraws);
 
-		float xchunk = col * static_cast<float>(Chunk::CHUNK_SIZE);
-		float ychunk = row * static_cast<float>(Chunk::CHUNK_SIZE);
+	// Draw pixels of changed tiles (or cell quads, once the atlas is full) on every core
+	m_workers.run(m_buildJobs.size(), [this, level](size_t i) {
+		ChunkJob& job = m_chunkJobs[m_buildJobs[i]];
+		if (job.hasTile)
+			drawTile(*job.chunk, level, &m_tilePixels[job.pixels]);
+		else
+			buildCellQuads(*job.chunk, job.quads);
+	});
 
-		if ((xchunk + Chunk::CHUNK_SIZE) < cullZone.left)
-			continue;
-		if ((ychunk + Chunk::CHUNK_SIZE) < cullZone.top)
-			continue;
-		if (xchunk > (cullZone.left + cullZone.width))
-			continue;
-		if (ychunk > (cullZone.top + cullZone.height))
+	// Upload changed tiles, and batch tiles of every visible chunk into one draw
+	const float CHUNK_SIZE = static_cast<float>(Chunk::CHUNK_SIZE);
+	const unsigned int tilesPerRow = m_atlas.getSize().x / Chunk::CHUNK_SIZE;
+	const unsigned int tileSize = Chunk::CHUNK_SIZE >> level;
+	m_tileQuads.clear();
+	cellGraph.clear();
+	for (size_t i = 0; i < jobs; i++)
+	{
+		const ChunkJob& job = m_chunkJobs[i];
+		if (!job.hasTile)
+		{
+			for (const sf::Vertex& vertex : job.quads)
+				cellGraph.append(vertex);
 			continue;
+		}
 
-		cellGraph.clear();
-
-		auto& cellCoords = chunk->getCellCoords();
-		for (const std::pair<int,int>& xy : cellCoords)
+		const unsigned int xtile = (job.tile % tilesPerRow) * Chunk::CHUNK_SIZE;
+		const unsigned int ytile = (job.tile / tilesPerRow) * Chunk::CHUNK_SIZE;
+		if (job.redraw)
 		{
-			float xcell = static_cast<float>(xy.first  + xchunk);
-			float ycell = static_cast<float>(xy.second + ychunk);
-			cellGraph.append(sf::Vector2f(xcell + 1, ycell + 1));
-			cellGraph.append(sf::Vector2f(xcell + 1, ycell));
-			cellGraph.append(sf::Vector2f(xcell, ycell));
-			cellGraph.append(sf::Vector2f(xcell, ycell + 1));
+			sf::Clock clock;
+			m_atlas.update(&m_tilePixels[job.pixels], tileSize, tileSize, xtile, ytile);
+			m_submitTime += clock.getElapsedTime();
 		}
 
-		m_renderTarget->draw(cellGraph);
+		// Tiles of density levels only fill part of their space in the atlas
+		float xchunk = job.chunk->getColumn() * CHUNK_SIZE;
+		float ychunk = job.chunk->getRow() * CHUNK_SIZE;
+		float xtex = static_cast<float>(xtile);
+		float ytex = static_cast<float>(ytile);
+		float size = static_cast<float>(tileSize);
+		m_tileQuads.append(sf::Vertex(sf::Vector2f(xchunk, ychunk), sf::Vector2f(xtex, ytex)));
+		m_tileQuads.append(sf::Vertex(sf::Vector2f(xchunk + CHUNK_SIZE, ychunk), sf::Vector2f(xtex + size, ytex)));
+		m_tileQuads.append(sf::Vertex(sf::Vector2f(xchunk + CHUNK_SIZE, ychunk + CHUNK_SIZE), sf::Vector2f(xtex + size, ytex + size)));
+		m_tileQuads.append(sf::Vertex(sf::Vector2f(xchunk, ychunk + CHUNK_SIZE), sf::Vector2f(xtex, ytex + size)));
+	}
+	this->submit(m_tileQuads, &m_atlas);
+	this->submit(cellGraph);
 
-		if (showChunks)
+	if (showChunks)
+	{
+		// Outlines only change when visible chunks or their sleep modes do
+		uint64_t key = 0;
+		for (const ChunkSnapshot* chunk : m_visibleChunks)
 		{
-			switch (chunk->getSleepMode())
+			key = OverlayLayer::combineKey(key, chunk->getUniqueID());
+			key = OverlayLayer::combineKey(key, chunk->getSleepMode());
+		}
+
+		if (m_chunkOutlines.rebuild(key))
+		{
+			for (const ChunkSnapshot* chunk : m_visibleChunks)
 			{
-			case Chunk::Sleeping:
-				chunkRect.setOutlineColor(sf::Color(255, 32, 32, 64));
-				break;
-			case Chunk::BorderOnly:
-				chunkRect.setOutlineColor(sf::Color(255, 255, 32, 64));
-				break;
-			case Chunk::Awake:
-				chunkRect.setOutlineColor(sf::Color(32, 255, 255, 64));
-				break;
+				sf::Color color;
+				switch (chunk->getSleepMode())
+				{
+				case Chunk::Sleeping:
+					color = sf::Color(255, 32, 32, 64);
+					break;
+				case Chunk::BorderOnly:
+					color = sf::Color(255, 255, 32, 64);
+					break;
+				case Chunk::Awake:
+					color = sf::Color(32, 255, 255, 64);
+					break;
+				case Chunk::Periodic:
+					color = sf::Color(255, 32, 255, 64);
+					break;
+				}
+				m_chunkOutlines.addOutline(sf::FloatRect(chunk->getColumn() * CHUNK_SIZE, chunk->getRow() * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE), 1.f, color);
 			}
-			chunkRect.setPosition(xchunk, ychunk);
-			m_renderTarget->draw(chunkRect);
 		}
+		sf::Clock clock;
+		m_chunkOutlines.draw(*m_renderTarget);
+		m_submitTime += clock.getElapsedTime();
+	}
+
+	if (!showChunksCellCount && !showChunkID)
+		return;
+
+	for (const ChunkSnapshot* chunk : m_visibleChunks)
+	{
+		float xchunk = chunk->getColumn() * CHUNK_SIZE;
+		float ychunk = chunk->getRow() * CHUNK_SIZE;
 
 		if (showChunksCellCount)
 		{
 			chunkText.setFillColor(sf::Color(255, 255, 255, 192));
 			chunkText.setString(std::to_string(chunk->getAliveCells()));
 			chunkText.setPosition(xchunk, ychunk);
-			m_renderTarget->draw(chunkText);
+			this->submit(chunkText);
 		}
 
 		if (showChunkID)
@@ -156,7 +298,229 @@ void SimulationRenderer::render() const
 			chunkText.setString(std::to_string(chunk->getUniqueID()));
 			chunkText.setFillColor(sf::Color(255, 255, 255, 64));
 			chunkText.setPosition(xchunk, y);
-			m_renderTarget->draw(chunkText);
+			this->submit(chunkText);
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationRenderer::renderRegions(int left, int top, int right, int bottom, float cellsPerPixel) const
+{
+	// Smallest regions of chunks which still cover a screen pixel
+	int level = 0;
+	float span = static_cast<float>(Chunk::CHUNK_SIZE);
+	while (level + 1 < PopulationPyramid::LEVELS && span < cellsPerPixel)
+	{
+		level++;
+		span *= 4;
+	}
+
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	auto chunkCoord = [CHUNK_SIZE](int v) { return (v < 0) ? (v + 1) / CHUNK_SIZE - 1 : v / CHUNK_SIZE; };
+
+	// Shade each populated region by its density, faintly for even a single alive cell
+	const float area = span * span;
+	m_regionQuads.clear();
+	m_snapshot->forEachRegionIn(level, chunkCoord(left), chunkCoord(top), chunkCoord(right), chunkCoord(bottom), [&](int column, int row, unsigned int population) {
+		sf::Color color(255, 255, 255, static_cast<sf::Uint8>(32 + std::min(223.f, population * 223.f / area)));
+		float x = column * span;
+		float y = row * span;
+		m_regionQuads.append(sf::Vertex(sf::Vector2f(x, y), color));
+		m_regionQuads.append(sf::Vertex(sf::Vector2f(x + span, y), color));
+		m_regionQuads.append(sf::Vertex(sf::Vector2f(x + span, y + span), color));
+		m_regionQuads.append(sf::Vertex(sf::Vector2f(x, y + span), color));
+	});
+	this->submit(m_regionQuads);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationRenderer::reserveTiles(size_t count) const
+{
+	const unsigned int TILE_SIZE = Chunk::CHUNK_SIZE;
+
+	// Grow atlas until every visible chunk fits, as far as the graphics card allows
+	unsigned int size = m_atlas.getSize().x;
+	unsigned int wanted = std::max(size, 1024u);
+	while (static_cast<size_t>(wanted / TILE_SIZE) * (wanted / TILE_SIZE) < count && wanted * 2 <= sf::Texture::getMaximumSize())
+		wanted *= 2;
+
+	if (wanted != size)
+	{
+		// Start over with an empty atlas
+		m_tiles.clear();
+		m_freeTiles.clear();
+		if (!m_atlas.create(wanted, wanted))
+		{
+			std::cerr << "renderer could not create " << wanted << "x" << wanted << " atlas texture!" << std::endl;
+			return;
+		}
+		const unsigned int tiles = (wanted / TILE_SIZE) * (wanted / TILE_SIZE);
+		for (unsigned int i = tiles; i > 0; i--)
+			m_freeTiles.push_back(i - 1);
+	}
+
+	// Free tiles of chunks which are no longer visible
+	if (m_freeTiles.size() < count)
+	{
+		for (auto it = m_tiles.begin(); it != m_tiles.end(); )
+		{
+			if (it->second.lastFrame != m_frame)
+			{
+				m_freeTiles.push_back(it->second.index);
+				it = m_tiles.erase(it);
+			}
+			else
+			{
+				it++;
+			}
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool SimulationRenderer::assignTile(const ChunkSnapshot& chunk, int level, unsigned int& out_index, bool& out_redraw) const
+{
+	auto it = m_tiles.find(chunk.getUniqueID());
+	out_redraw = false;
+	if (it == m_tiles.end())
+	{
+		if (m_freeTiles.empty())
+			return false;
+
+		Tile tile;
+		tile.index = m_freeTiles.back();
+		tile.version = chunk.getVersion();
+		tile.level = level;
+		m_freeTiles.pop_back();
+		it = m_tiles.emplace(chunk.getUniqueID(), tile).first;
+		out_redraw = true;
+	}
+
+	Tile& tile = it->second;
+	tile.lastFrame = m_frame;
+	if (tile.version != chunk.getVersion() || tile.level != level)
+		out_redraw = true;
+	tile.version = chunk.getVersion();
+	tile.level = level;
+
+	out_index = tile.index;
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationRenderer::drawTile(const ChunkSnapshot& chunk, int level, sf::Uint8* out_pixels)
+{
+	const unsigned int TILE_SIZE = Chunk::CHUNK_SIZE;
+	const unsigned int size = TILE_SIZE >> level;
+	if (level == 0)
+	{
+		// Alive cells are opaque white, dead cells transparent
+		uint64_t cells[Chunk::CHUNK_SIZE];
+		chunk.getCells(cells);
+		for (unsigned int y = 0; y < TILE_SIZE; y++)
+		{
+			for (unsigned int x = 0; x < TILE_SIZE; x++)
+			{
+				sf::Uint8* pixel = &out_pixels[(y * TILE_SIZE + x) * 4];
+				pixel[0] = pixel[1] = pixel[2] = pixel[3] = ((cells[y] >> x) & 1) ? 255 : 0;
+			}
 		}
 	}
+	else
+	{
+		// Blocks of cells are white, as opaque as they are dense
+		const unsigned char* density = chunk.getDensity(level);
+		for (unsigned int i = 0; i < size * size; i++)
+		{
+			sf::Uint8* pixel = &out_pixels[i * 4];
+			pixel[0] = pixel[1] = pixel[2] = 255;
+			pixel[3] = density[i];
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationRenderer::buildCellQuads(const ChunkSnapshot& chunk, std::vector<sf::Vertex>& out_quads)
+{
+	const float xchunk = static_cast<float>(chunk.getColumn() * static_cast<int>(Chunk::CHUNK_SIZE));
+	const float ychunk = static_cast<float>(chunk.getRow() * static_cast<int>(Chunk::CHUNK_SIZE));
+
+	uint64_t cells[Chunk::CHUNK_SIZE];
+	chunk.getCells(cells);
+	out_quads.clear();
+	for (int y = 0; y < Chunk::CHUNK_SIZE; y++)
+	{
+		for (int x = 0; x < Chunk::CHUNK_SIZE; x++)
+		{
+			if (((cells[y] >> x) & 1) == 0)
+				continue;
+			float xcell = x + xchunk;
+			float ycell = y + ychunk;
+			out_quads.emplace_back(sf::Vector2f(xcell + 1, ycell + 1));
+			out_quads.emplace_back(sf::Vector2f(xcell + 1, ycell));
+			out_quads.emplace_back(sf::Vector2f(xcell, ycell));
+			out_quads.emplace_back(sf::Vector2f(xcell, ycell + 1));
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationRenderer::renderBounded() const
+{
+	const BoundedSnapshot& sim = *m_boundedSnapshot;
+	const int width  = sim.getWidth();
+	const int height = sim.getHeight();
+
+	// Only visit cells within both the universe and the cull zone
+	int left   = std::max(0, static_cast<int>(std::floor(cullZone.left)));
+	int top    = std::max(0, static_cast<int>(std::floor(cullZone.top)));
+	int right  = std::min(width,  static_cast<int>(std::ceil(cullZone.left + cullZone.width)) + 1);
+	int bottom = std::min(height, static_cast<int>(std::ceil(cullZone.top + cullZone.height)) + 1);
+
+	m_boundedCellGraph.clear();
+
+	for (int y = top; y < bottom; y++)
+	{
+		const BoundedSimulation::Word* row = sim.getRow(y);
+		float ycell = static_cast<float>(y);
+
+		for (int wx = left / BoundedSimulation::WORD_BITS; wx * BoundedSimulation::WORD_BITS < right; wx++)
+		{
+			BoundedSimulation::Word w = row[wx];
+
+			// Skip words with no alive cells
+			while (w != 0)
+			{
+				int bit = 0;
+				while (((w >> bit) & 1) == 0)
+					bit++;
+				w &= ~(BoundedSimulation::Word(1) << bit);
+
+				int x = wx * BoundedSimulation::WORD_BITS + bit;
+				if (x < left || x >= right)
+					continue;
+
+				float xcell = static_cast<float>(x);
+				m_boundedCellGraph.append(sf::Vector2f(xcell + 1, ycell + 1));
+				m_boundedCellGraph.append(sf::Vector2f(xcell + 1, ycell));
+				m_boundedCellGraph.append(sf::Vector2f(xcell, ycell));
+				m_boundedCellGraph.append(sf::Vector2f(xcell, ycell + 1));
+			}
+		}
+	}
+
+	this->submit(m_boundedCellGraph);
+
+	// Outline universe edges
+	sf::RectangleShape bounds(sf::Vector2f(static_cast<float>(width), static_cast<float>(height)));
+	bounds.setFillColor(sf::Color::Transparent);
+	bounds.setOutlineColor(sim.isWrapping() ? sf::Color(32, 255, 255, 96) : sf::Color(255, 255, 255, 96));
+	bounds.setOutlineThickness(1.f);
+	this->submit(bounds);
 }
@@ -35,7 +35,12 @@
 
 #include <SFML/Graphics.hpp>
 #include "gol/Simulation.hpp"
+#include "gol/BoundedSimulation.hpp"
 #include "gol/Chunk.hpp"
+#include "OverlayLayer.hpp"
+#include "TaskPool.hpp"
+#include <unordered_map>
+#include <memory>
 
 
 class SimulationRenderer
@@ -44,10 +49,17 @@ public:
 	SimulationRenderer();
 
 	void setRenderTarget(sf::RenderTarget& renderTarget);
-	void setSimulation(const gol::Simulation& simulator);
+	void setSnapshot(const std::shared_ptr<const gol::Snapshot>& snapshot);
+	void setSnapshot(const std::shared_ptr<const gol::BoundedSnapshot>& snapshot);
 
 	void render() const;
 
+	// Get time taken by the last render() to build geometry and tile pixels, on every core.
+	inline float getProfiledBuildTime() const { return m_buildTime.asSeconds(); }
+
+	// Get time taken by the last render() to upload tiles and submit draws (on the CPU, not counting the GPU's own time).
+	inline float getProfiledSubmitTime() const { return m_submitTime.asSeconds(); }
+
 	sf::FloatRect cullZone;
 
 	bool showChunks;
@@ -56,7 +68,71 @@ public:
 
 private:
 	sf::RenderTarget* m_renderTarget;
-	const gol::Simulation* m_simulation;
+	std::shared_ptr<const gol::Snapshot> m_snapshot;
+	std::shared_ptr<const gol::BoundedSnapshot> m_boundedSnapshot;
+
+	mutable sf::VertexArray m_boundedCellGraph;
+
+	// Cells of chunks are drawn to tiles of one atlas texture, and only redrawn when the chunk changes.
+	struct Tile
+	{
+		unsigned int index;     //> Position in the atlas, counting tiles left to right, top to bottom.
+		unsigned int version;   //> gol::Chunk::getVersion() the tile was drawn from.
+		int level;              //> Level of detail the tile was drawn at, see gol::Chunk::getDensity().
+		unsigned int lastFrame; //> Last frame the chunk was visible.
+	};
+	mutable sf::Texture m_atlas;
+	mutable std::unordered_map<unsigned int, Tile> m_tiles; //> Tiles by chunk unique ID.
+	mutable std::vector<unsigned int> m_freeTiles;
+	mutable std::vector<sf::Uint8> m_tilePixels; //> Pixels of tiles being redrawn this frame.
+	mutable sf::VertexArray m_tileQuads;
+	mutable std::vector<const gol::ChunkSnapshot*> m_visibleChunks;
+	mutable unsigned int m_frame;
+	mutable sf::VertexArray m_regionQuads;
+	mutable OverlayLayer m_chunkOutlines;
+
+	// Geometry of visible chunks is built in parallel, then submitted from the rendering thread.
+	struct ChunkJob
+	{
+		const gol::ChunkSnapshot* chunk;
+		bool hasTile;                  //> Drawn as an atlas tile, otherwise as cell quads.
+		unsigned int tile;
+		bool redraw;                   //> Tile pixels are redrawn this frame.
+		size_t pixels;                 //> Offset of the tile's pixels in m_tilePixels.
+		std::vector<sf::Vertex> quads; //> Cell quads if the chunk has no tile.
+	};
+	mutable std::vector<ChunkJob> m_chunkJobs;
+	mutable std::vector<size_t> m_buildJobs; //> Indices of jobs with pixels or quads to build.
+	mutable TaskPool m_workers;
+	mutable sf::Time m_buildTime;
+	mutable sf::Time m_submitTime;
+
+	// Draw to the render target, counting the time taken towards getProfiledSubmitTime().
+	void submit(const sf::Drawable& drawable, const sf::RenderStates& states = sf::RenderStates::Default) const;
+
+	void renderBounded() const;
+
+	// Draw chunks (or regions of chunks) within the cull zone, and escaped spaceships.
+	void renderSnapshot() const;
+
+	// Draw chunks within the bounds given (in cell coordinates), at the level of detail given.
+	// Level 0 draws every cell, levels above draw the density of blocks of cells, see gol::Chunk::getDensity().
+	void renderChunks(int left, int top, int right, int bottom, int level) const;
+
+	// Draw the density of regions of chunks within the bounds given (in cell coordinates), see gol::PopulationPyramid.
+	// Used once chunks are smaller than a screen pixel, so the cost is bound by screen pixels rather than by chunks.
+	void renderRegions(int left, int top, int right, int bottom, float cellsPerPixel) const;
+
+	// Make room in the atlas for tiles of the count of chunks given, growing it or freeing tiles of chunks no longer visible.
+	void reserveTiles(size_t count) const;
+
+	// Get atlas tile of the chunk given, and whether it must be redrawn as the chunk or level of detail changed.
+	// Returns false if the atlas is full.
+	bool assignTile(const gol::ChunkSnapshot& chunk, int level, unsigned int& out_index, bool& out_redraw) const;
+
+	// Draw pixels of the chunk's tile at the level of detail given. Safe to call from any thread.
+	static void drawTile(const gol::ChunkSnapshot& chunk, int level, sf::Uint8* out_pixels);
 
-	mutable std::vector<const gol::Chunk*> m_chunkBuffer;
+	// Build quads of the chunk's alive cells. Safe to call from any thread.
+	static void buildCellQuads(const gol::ChunkSnapshot& chunk, std::vector<sf::Vertex>& out_quads);
 };
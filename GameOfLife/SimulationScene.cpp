@@ -34,10 +34,20 @@
 #include <sstream>
 #include <iomanip>
 #include <iostream>
+#include <algorithm>
 
 
 const float CAMERA_ZOOM_INIT = 1 / 8.f;
 const float CAMERA_ZOOM_SHOW_GRID = 1 / 4.f;
+const float CAMERA_ZOOM_MIN = 0.01f;
+const float CAMERA_ZOOM_MAX = 1024.f;
+
+// Frame sweep (b key) renders this many frames at each debug mode and zoom level, measuring all but the warm-up frames
+const int FRAME_SWEEP_DEBUG_MODES[] = { 0, 1, 2, 3 };
+const float FRAME_SWEEP_ZOOMS[] = { 1 / 16.f, 1 / 4.f, 1.f, 16.f, 256.f };
+const unsigned int FRAME_SWEEP_WARMUP = 10;
+const unsigned int FRAME_SWEEP_FRAMES = 60;
+const int FRAME_SWEEP_STEPS = static_cast<int>((sizeof(FRAME_SWEEP_DEBUG_MODES) / sizeof(int)) * (sizeof(FRAME_SWEEP_ZOOMS) / sizeof(float)));
 
 
 //////////////////////////////////////////////////////////////////////
@@ -46,18 +56,39 @@ void SimulationScene::init()
 	auto& rw = this->getManager().getWindow();
 	auto& settings = UserSettings::instance();
 	m_renderer.setRenderTarget(rw);
-	m_renderer.setSimulation(m_sim);
 
 	m_camera        = rw.getView();
 	m_lastPreUpdate = this->getManager().getElapsedTime().asSeconds();
 	this->cameraSetZoom(CAMERA_ZOOM_INIT);
 
+	// Create universe, either unbounded (chunked) or a fixed-size grid
+	std::string universe = settings.getString("universe", "unbounded");
+	if (universe == "bounded" || universe == "torus")
+	{
+		int width  = settings.getInteger("bounded_width", 512);
+		int height = settings.getInteger("bounded_height", 512);
+		m_boundedSim = new gol::BoundedSimulation(width, height, universe == "torus");
+		m_sim = m_boundedSim;
+
+		// Start with the universe centered on screen
+		m_camera.setCenter(m_boundedSim->getWidth() / 2.f, m_boundedSim->getHeight() / 2.f);
+	}
+	else
+	{
+		m_chunkedSim = new gol::Simulation();
+		m_chunkedSim->getChunkMemo().setCapacity(std::max(0, settings.getInteger("chunk_memo", 0)));
+		m_chunkedSim->setMemoryBudget(static_cast<size_t>(std::max(0, settings.getInteger("memory_budget_mb", 0))) * 1024 * 1024);
+		m_sim = m_chunkedSim;
+	}
+
 	gol::Ruleset rules;
 	if (rules.set(settings.getString("ruleset")))
-		m_sim.setRuleset(rules);
-	rw.setTitle(std::string("GOL - ") + m_sim.getRuleset().getString());
+		m_sim->setRuleset(rules);
+	rw.setTitle(std::string("GOL - ") + m_sim->getRuleset().getString());
 
 	this->setTargetStepsPerSecond(settings.getFloat("steps_per_second", 60.f));
+	m_simThread.setPaused(m_paused);
+	m_simThread.start(*m_sim);
 
 	std::stringstream ss;
 	ss << "                       WELCOME TO GAME OF LIFE" << std::endl;
@@ -71,6 +102,7 @@ void SimulationScene::init()
 	ss << "          equals / keypad+ : zoom in camera" << std::endl;
 	ss << "          hyphen / keypad- : zoom out camera" << std::endl;
 	ss << "           1-9 / keypad1-9 : set zoom level" << std::endl;
+	ss << "                         f : fit pattern to screen" << std::endl;
 	ss << "                         g : toggle grid (when zoomed in)" << std::endl;
 	ss << "                    period : step once (while paused)" << std::endl;
 	ss << "                  spacebar : pause/resume simulation" << std::endl;
@@ -109,7 +141,14 @@ void SimulationScene::init()
 //////////////////////////////////////////////////////////////////////
 void SimulationScene::finish()
 {
-	m_sim.reset();
+	if (m_frameSweep.step >= 0)
+		this->stopFrameSweep();
+
+	m_simThread.stop();
+	delete m_sim;
+	m_sim        = nullptr;
+	m_chunkedSim = nullptr;
+	m_boundedSim = nullptr;
 
 	auto& rw = this->getManager().getWindow();
 	rw.setTitle("GOL");
@@ -176,26 +215,43 @@ void SimulationScene::processEvent(const sf::Event & ev)
 		{
 		case sf::Keyboard::Space:
 			m_paused = !m_paused;
+			m_simThread.setPaused(m_paused);
 			break;
 		case sf::Keyboard::Escape:
 			this->getManager().load<MenuScene>();
 			this->close();
 			break;
 		case sf::Keyboard::R:
-			m_sim.reset();
+			{
+				std::lock_guard<std::mutex> lock(m_simThread.getGuard());
+				m_sim->reset();
+			}
+			m_simThread.invalidate();
 			break;
 		case sf::Keyboard::Tilde:
 			toggleDebug(++m_debugMode);
 			break;
 		case sf::Keyboard::T:
-			m_sim.setMultithreadMode(!m_sim.isMultithreaded());
+			{
+				std::lock_guard<std::mutex> lock(m_simThread.getGuard());
+				m_sim->setMultithreadMode(!m_sim->isMultithreaded());
+			}
 			break;
 		case sf::Keyboard::Period:
-			if (m_paused) m_stepOnce = true;
+			if (m_paused) m_simThread.stepOnce();
 			break;
 		case sf::Keyboard::G:
 			m_showGrid = !m_showGrid;
 			break;
+		case sf::Keyboard::F:
+			this->cameraFitPattern();
+			break;
+		case sf::Keyboard::B:
+			if (m_frameSweep.step < 0)
+				this->startFrameSweep();
+			else
+				this->stopFrameSweep();
+			break;
 		case sf::Keyboard::A:
 		case sf::Keyboard::Left:
 			m_controls.moveLeft = true;
@@ -307,7 +363,7 @@ void SimulationScene::processEvent(const sf::Event & ev)
 
 
 //////////////////////////////////////////////////////////////////////
-int SimulationScene::preUpdate()
+void SimulationScene::preUpdate()
 {
 	float curTime   = this->getManager().getElapsedTime().asSeconds();
 	float dt        = curTime - m_lastPreUpdate;
@@ -330,56 +386,22 @@ int SimulationScene::preUpdate()
 	if (m_controls.moveDown)
 		m_camera.move(0.f, m_cameraMoveSpeed * m_cameraZoom * dt);
 	if (m_controls.zoomIn)
-		cameraSetZoom(std::max(0.01f, m_cameraZoom *= 1.f - dt));
+		cameraSetZoom(std::max(CAMERA_ZOOM_MIN, m_cameraZoom *= 1.f - dt));
 	if (m_controls.zoomOut)
-		cameraSetZoom(std::min(10.f, m_cameraZoom *= 1.f + dt));
+		cameraSetZoom(std::min(CAMERA_ZOOM_MAX, m_cameraZoom *= 1.f + dt));
 
 	this->screenToWorld(m_controls.mouseX, m_controls.mouseY, m_controls.cursorX, m_controls.cursorY);
-
-	if (m_stepOnce)
-	{
-		m_stepOnce = false;
-		return 1;
-	}
-
-	if (m_paused)
-		return 0;
-
-	if (m_targetStepsPerSecond > 0)
-	{
-		m_stepAccumulator += dt;
-		float stepTime = (1.f / m_targetStepsPerSecond);
-		int steps = static_cast<int>(m_stepAccumulator / stepTime);
-		if (steps > 0)
-			m_stepAccumulator -= (stepTime * steps);
-		return steps;
-	}
-
-	return 1;
 }
 
 
 //////////////////////////////////////////////////////////////////////
 void SimulationScene::update()
 {
-	int stepsFinished, steps = preUpdate();
-	float curTime = this->getManager().getElapsedTime().asSeconds();
-	for (stepsFinished = 0; stepsFinished < steps; stepsFinished++)
-	{
-		m_sim.step();
+	// The universe is stepped by m_simThread
+	this->preUpdate();
 
-		// Break when we've been stepping for too long
-		if (this->getManager().getElapsedTime().asSeconds() - curTime > 0.01f)
-			break;
-	}
-
-	m_debugStepsPerSecond = 0;
-	if (steps > 0)
-	{
-		float elapsedTime = this->getManager().getElapsedTime().asSeconds() - curTime;
-		float stepTime = (1.f / elapsedTime) * stepsFinished;
-		m_debugStepsPerSecond = std::min(m_targetStepsPerSecond, stepTime);
-	}
+	if (m_frameSweep.step >= 0)
+		this->updateFrameSweep();
 }
 
 
@@ -396,39 +418,48 @@ void SimulationScene::render()
 	m_renderer.cullZone.height = m_camera.getSize().y;
 	m_renderer.cullZone.left   = m_camera.getCenter().x - m_renderer.cullZone.width / 2;
 	m_renderer.cullZone.top    = m_camera.getCenter().y - m_renderer.cullZone.height / 2;
+	// Universes are drawn from the latest snapshot, while the next generations are stepped
+	if (m_chunkedSim)
+		m_renderer.setSnapshot(m_simThread.getSnapshot());
+	else
+		m_renderer.setSnapshot(m_simThread.getBoundedSnapshot());
 	m_renderer.render();
 	
 	if (m_showGrid && m_cameraZoom <= CAMERA_ZOOM_SHOW_GRID)
 	{
-		int pos;
 		int left   = static_cast<int>(std::floor(m_renderer.cullZone.left));
 		int top    = static_cast<int>(std::floor(m_renderer.cullZone.top));
-		int right  = static_cast<int>(std::ceil(m_renderer.cullZone.left + m_renderer.cullZone.width));
-		int bottom = static_cast<int>(std::ceil(m_renderer.cullZone.top + m_renderer.cullZone.height));
-		
+
+		// Grid starts from a multiple of 10 cells, so panning only moves it and it is rebuilt only when zooming
+		int originX = left - ((left % 10) + 10) % 10;
+		int originY = top - ((top % 10) + 10) % 10;
+		int columns = static_cast<int>(std::ceil(m_renderer.cullZone.width)) + 10;
+		int rows    = static_cast<int>(std::ceil(m_renderer.cullZone.height)) + 10;
+
 		float alpha = std::min(1.f, (1.f - m_cameraZoom / CAMERA_ZOOM_SHOW_GRID) * 2.f);
 		const sf::Color LINE_COLOR1 = sf::Color(0x7F, 0x7F, 0x7F, static_cast<sf::Uint8>(alpha * 0x7Fu));
 		const sf::Color LINE_COLOR2 = sf::Color(0x3F, 0x3F, 0x3F, static_cast<sf::Uint8>(alpha * 0x7Fu));
 
-		m_gridLine.setScale(m_cameraZoom, m_cameraZoom);
+		// Lines are one screen pixel thick
+		const float thickness = m_cameraZoom;
+		uint64_t key = OverlayLayer::combineKey(columns, rows);
+		key = OverlayLayer::combineKey(key, LINE_COLOR1.a);
+		key = OverlayLayer::combineKey(key, static_cast<uint64_t>(thickness * 65536.f));
 
-		// left->right vertical lines
-		m_gridLine.setSize(sf::Vector2f(1.f, static_cast<float>(screen.y)));
-		for (pos = left; pos <= right; pos++)
+		if (m_gridOverlay.rebuild(key))
 		{
-			m_gridLine.setPosition(static_cast<float>(pos), m_renderer.cullZone.top);
-			m_gridLine.setFillColor((pos % 10 == 0) ? LINE_COLOR1 : LINE_COLOR2);
-			rw.draw(m_gridLine);
-		}
+			// left->right vertical lines
+			for (int pos = 0; pos <= columns; pos++)
+				m_gridOverlay.addRect(sf::FloatRect(static_cast<float>(pos), 0.f, thickness, static_cast<float>(rows)), (pos % 10 == 0) ? LINE_COLOR1 : LINE_COLOR2);
 
-		// top->bottom horizontal lines
-		m_gridLine.setSize(sf::Vector2f(static_cast<float>(screen.x), 1.f));
-		for (pos = top; pos <= bottom; pos++)
-		{
-			m_gridLine.setPosition(m_renderer.cullZone.left, static_cast<float>(pos));
-			m_gridLine.setFillColor((pos % 10 == 0) ? LINE_COLOR1 : LINE_COLOR2);
-			rw.draw(m_gridLine);
+			// top->bottom horizontal lines
+			for (int pos = 0; pos <= rows; pos++)
+				m_gridOverlay.addRect(sf::FloatRect(0.f, static_cast<float>(pos), static_cast<float>(columns), thickness), (pos % 10 == 0) ? LINE_COLOR1 : LINE_COLOR2);
 		}
+
+		sf::RenderStates states;
+		states.transform.translate(static_cast<float>(originX), static_cast<float>(originY));
+		m_gridOverlay.draw(rw, states);
 	}
 
 	// Reset camera view
@@ -454,9 +485,18 @@ void SimulationScene::render()
 		std::stringstream strDebug;
 		strDebug << std::fixed << std::setprecision(2);
 		strDebug << "DEBUG (" << m_debugMode << ")";
-		
-		if (m_sim.isMultithreaded())
-			strDebug << "\nMULTITHREADED (" << m_sim.getWorkerThreadCount() << ")";
+
+		// Universe statistics are read while it isn't being stepped, the last ones read are shown otherwise
+		std::unique_lock<std::mutex> lock(m_simThread.getGuard(), std::try_to_lock);
+		if (lock.owns_lock())
+		{
+			m_debugWorkers = m_sim->isMultithreaded() ? m_sim->getWorkerThreadCount() : 0;
+			m_debugUniverse = (m_debugMode == 4) ? this->getStepStatistics() : this->getUniverseStatistics();
+		}
+		lock.unlock();
+
+		if (m_debugWorkers > 0)
+			strDebug << "\nMULTITHREADED (" << m_debugWorkers << ")";
 		
 		strDebug << "\nframes/sec  : " << static_cast<int>(this->getManager().getFramesPerSecond());
 		if (this->getManager().getTargetFramerate() > 0)
@@ -468,13 +508,10 @@ void SimulationScene::render()
 
 		strDebug << "\nupdate (ms) : " << this->getManager().getProfiledUpdateTime() * 1000.f
 		         << "\nrender (ms) : " << this->getManager().getProfiledRenderTime() * 1000.f
-		         << "\nchunks      : " << m_sim.getChunkCount()
-		         << "\npopulation  : " << m_sim.getPopulation()
-		         << "\nbirths      : " << m_sim.getBirths()
-		         << "\ndeaths      : " << m_sim.getDeaths()
-		         << "\npop delta   : " << (static_cast<long long>(m_sim.getBirths()) - m_sim.getDeaths())
-		         << "\ngeneration  : " << m_sim.getGeneration()
-		         << "\nruleset     : " << m_sim.getRuleset().getString()
+		         << "\n  build (ms)  : " << m_renderer.getProfiledBuildTime() * 1000.f
+		         << "\n  submit (ms) : " << m_renderer.getProfiledSubmitTime() * 1000.f;
+
+		strDebug << m_debugUniverse
 		         << "\ncursor      : " << m_controls.cursorX << ",\t" << m_controls.cursorY
 		         << "\nzoom        : " << m_cameraZoom;
 		m_txtDebug.setString(strDebug.str());
@@ -482,6 +519,101 @@ void SimulationScene::render()
 }
 
 
+//////////////////////////////////////////////////////////////////////
+std::string SimulationScene::getUniverseStatistics() const
+{
+	std::stringstream strUniverse;
+	strUniverse << std::fixed << std::setprecision(2);
+
+	if (m_chunkedSim)
+	{
+		strUniverse << "\nchunks      : " << m_chunkedSim->getChunkCount()
+		            << " (dense=" << m_chunkedSim->getDenseChunkCount()
+		            << ", sparse=" << m_chunkedSim->getSparseChunkCount() << ")"
+		            << "\ncell memory : " << m_chunkedSim->getResidentCellBytes() / 1024 << " KB"
+		            << " (allocated=" << m_chunkedSim->getAllocatedChunkCount() << ")"
+		            << "\ncompressed  : " << m_chunkedSim->getCompressedCellBytes() / 1024 << " KB"
+		            << " (chunks=" << m_chunkedSim->getCompressedChunkCount()
+		            << ", dedup=" << m_chunkedSim->getCompressedDedupRatio() << "x)"
+		            << "\nperiodic    : " << m_chunkedSim->getPeriodicChunkCount()
+		            << "\nescapees    : " << m_chunkedSim->getEscapeeCount()
+		            << "\nstable      : ";
+		if (m_chunkedSim->isStable())
+			strUniverse << "yes (period=" << m_chunkedSim->getPeriod() << ")";
+		else
+			strUniverse << "no";
+
+		const gol::ChunkMemo& memo = m_chunkedSim->getChunkMemo();
+		if (memo.isEnabled())
+			strUniverse << "\nmemo        : " << memo.getSize() << "/" << memo.getCapacity()
+			            << " (hits=" << memo.getHitRate() * 100.f << "%)";
+
+		const gol::ChunkPager& pager = m_chunkedSim->getChunkPager();
+		if (m_chunkedSim->getMemoryBudget() > 0)
+			strUniverse << "\npaged       : " << pager.getPagedCount() << " chunks, " << pager.getFileBytes() / 1024 << " KB"
+			            << " (in=" << pager.getPageIns() << ", out=" << pager.getPageOuts() << ")";
+	}
+	if (m_boundedSim)
+		strUniverse << "\nuniverse    : " << m_boundedSim->getWidth() << "x" << m_boundedSim->getHeight()
+		            << (m_boundedSim->isWrapping() ? " (torus)" : " (bounded)");
+
+	strUniverse << "\npopulation  : " << m_sim->getPopulation()
+	            << "\nbirths      : " << m_sim->getBirths()
+	            << "\ndeaths      : " << m_sim->getDeaths()
+	            << "\npop delta   : " << (static_cast<long long>(m_sim->getBirths()) - m_sim->getDeaths())
+	            << "\ngeneration  : " << m_sim->getGeneration()
+	            << "\nruleset     : " << m_sim->getRuleset().getString();
+	return strUniverse.str();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+std::string SimulationScene::getStepStatistics() const
+{
+	std::stringstream strStep;
+	strStep << std::fixed << std::setprecision(3);
+
+	if (!m_chunkedSim)
+	{
+		strStep << "\nstep profile: chunked universes only";
+		return strStep.str();
+	}
+
+	const gol::StepProfile::Stats stats = m_chunkedSim->getStats();
+	strStep << "\nstep (ms)   : " << stats.total.average * 1000.f
+	        << " (p50=" << stats.total.p50 * 1000.f << ", p95=" << stats.total.p95 * 1000.f
+	        << ", p99=" << stats.total.p99 * 1000.f << ", max=" << stats.total.max * 1000.f
+	        << ", steps=" << stats.steps << ")";
+
+	for (int i = 0; i < gol::StepProfile::PHASE_COUNT; i++)
+	{
+		const gol::StepProfile::Summary& phase = stats.phases[i];
+		std::string name = gol::StepProfile::getPhaseName(static_cast<gol::StepProfile::EPhase>(i));
+		name.resize(10, ' ');
+		strStep << "\n  " << name << ": " << phase.average * 1000.f
+		        << " (p95=" << phase.p95 * 1000.f << ", max=" << phase.max * 1000.f << ")";
+	}
+
+	if (!stats.workerBusy.empty())
+	{
+		strStep << "\nbarrier (ms): " << stats.barrier.average * 1000.f
+		        << " (p95=" << stats.barrier.p95 * 1000.f << ", max=" << stats.barrier.max * 1000.f << ")";
+		for (size_t i = 0; i < stats.workerBusy.size(); i++)
+			strStep << "\n  worker " << i << "  : busy=" << stats.workerBusy[i] * 1000.f
+			        << " idle=" << stats.workerIdle[i] * 1000.f;
+	}
+
+	strStep << std::setprecision(1)
+	        << "\nchunks/step : awake=" << stats.chunks[gol::Chunk::Awake]
+	        << ", border=" << stats.chunks[gol::Chunk::BorderOnly]
+	        << ", sleeping=" << stats.chunks[gol::Chunk::Sleeping]
+	        << ", periodic=" << stats.chunks[gol::Chunk::Periodic]
+	        << "\n  created   : " << stats.chunksCreated
+	        << "\n  freed     : " << stats.chunksFreed;
+	return strStep.str();
+}
+
+
 //////////////////////////////////////////////////////////////////////
 void SimulationScene::toggleDebug(int mode)
 {
@@ -513,23 +645,111 @@ void SimulationScene::toggleDebug(int mode)
 		m_renderer.showChunksCellCount = true;
 		m_renderer.showChunkID = true;
 		break;
+
+	case 4:
+		// Step profile instead of universe statistics
+		m_renderer.showChunks = false;
+		m_renderer.showChunksCellCount = false;
+		m_renderer.showChunkID = false;
+		break;
 	}
 }
 
 
 //////////////////////////////////////////////////////////////////////
-void SimulationScene::placeCells(int x, int y, int size, bool alive)
+void SimulationScene::startFrameSweep()
 {
-	if (size <= 1)
+	m_frameSweep.debugMode = m_debugMode;
+	m_frameSweep.zoom = m_cameraZoom;
+	m_frameSweep.step = -1;
+
+	unsigned int population;
 	{
-		m_sim.setCell(x, y, alive);
+		std::lock_guard<std::mutex> lock(m_simThread.getGuard());
+		population = m_sim->getPopulation();
 	}
+	std::cout << "frame sweep: " << FRAME_SWEEP_FRAMES << " frames at each debug mode and zoom, "
+	          << (m_paused ? "paused" : "stepping") << ", population " << population << std::endl;
+	std::cout << "frame sweep: debug  zoom     render (ms)  build (ms)  submit (ms)" << std::endl;
+
+	// Finish the (empty) step before the first one, moving on to it
+	m_frameSweep.frame = FRAME_SWEEP_WARMUP + FRAME_SWEEP_FRAMES;
+	this->updateFrameSweep();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationScene::stopFrameSweep()
+{
+	if (m_frameSweep.step < FRAME_SWEEP_STEPS)
+		std::cout << "frame sweep: stopped" << std::endl;
 	else
+		std::cout << "frame sweep: done" << std::endl;
+
+	m_frameSweep.step = -1;
+	this->toggleDebug(m_frameSweep.debugMode);
+	this->cameraSetZoom(m_frameSweep.zoom);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationScene::updateFrameSweep()
+{
+	// Called before each frame is rendered, so the timings read are of the frame before, rendered at this step
+	const unsigned int frame = m_frameSweep.frame++;
+	if (frame > FRAME_SWEEP_WARMUP)
+	{
+		m_frameSweep.render += this->getManager().getProfiledRenderTime();
+		m_frameSweep.build  += m_renderer.getProfiledBuildTime();
+		m_frameSweep.submit += m_renderer.getProfiledSubmitTime();
+	}
+	if (frame < FRAME_SWEEP_WARMUP + FRAME_SWEEP_FRAMES)
+		return;
+
+	if (m_frameSweep.step >= 0)
+	{
+		const float ms = 1000.f / FRAME_SWEEP_FRAMES;
+		std::stringstream strResult;
+		strResult << std::fixed << std::setprecision(3)
+		          << "frame sweep: " << std::setw(5) << m_debugMode
+		          << "  " << std::left << std::setw(7) << m_cameraZoom << std::right
+		          << "  " << std::setw(11) << m_frameSweep.render * ms
+		          << "  " << std::setw(10) << m_frameSweep.build * ms
+		          << "  " << std::setw(11) << m_frameSweep.submit * ms;
+		std::cout << strResult.str() << std::endl;
+	}
+
+	// Move on to the next zoom level, then the next debug mode
+	if (++m_frameSweep.step >= FRAME_SWEEP_STEPS)
 	{
-		for (int ox = -(size - 1); ox <= (size - 1); ox++)
-			for (int oy = -(size - 1); oy <= (size - 1); oy++)
-				m_sim.setCell(x + ox, y + oy, alive);
+		this->stopFrameSweep();
+		return;
 	}
+	const int zooms = static_cast<int>(sizeof(FRAME_SWEEP_ZOOMS) / sizeof(float));
+	this->toggleDebug(FRAME_SWEEP_DEBUG_MODES[m_frameSweep.step / zooms]);
+	this->cameraSetZoom(FRAME_SWEEP_ZOOMS[m_frameSweep.step % zooms]);
+	m_frameSweep.frame  = 0;
+	m_frameSweep.render = 0.f;
+	m_frameSweep.build  = 0.f;
+	m_frameSweep.submit = 0.f;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationScene::placeCells(int x, int y, int size, bool alive)
+{
+	// Queued without waiting for the simulation thread, and set in one go before the next generation
+	const int radius = std::max(size, 1) - 1;
+	std::vector<gol::CellEdit> edits;
+	edits.reserve((2 * radius + 1) * (2 * radius + 1));
+	for (int ox = -radius; ox <= radius; ox++)
+		for (int oy = -radius; oy <= radius; oy++)
+			edits.push_back({ x + ox, y + oy, alive });
+	if (m_chunkedSim)
+		m_chunkedSim->queueCells(std::move(edits));
+	else if (m_boundedSim)
+		m_boundedSim->queueCells(std::move(edits));
+	m_simThread.invalidate();
 }
 
 
@@ -551,3 +771,36 @@ void SimulationScene::cameraSetZoom(float zoom)
 	m_camera.zoom(zoom);
 	m_cameraZoom = zoom;
 }
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationScene::cameraFitPattern()
+{
+	int left, top, right, bottom;
+	if (m_chunkedSim)
+	{
+		std::lock_guard<std::mutex> lock(m_simThread.getGuard());
+		if (!m_chunkedSim->getBounds(left, top, right, bottom))
+			return;
+	}
+	else if (m_boundedSim)
+	{
+		// Whole universe
+		left = 0;
+		top = 0;
+		right = m_boundedSim->getWidth() - 1;
+		bottom = m_boundedSim->getHeight() - 1;
+	}
+	else
+	{
+		return;
+	}
+
+	// Leave a small margin around the pattern
+	sf::Vector2u sz = this->getManager().getWindow().getSize();
+	float width = static_cast<float>(right - left + 1);
+	float height = static_cast<float>(bottom - top + 1);
+	float zoom = 1.1f * std::max(width / sz.x, height / sz.y);
+	m_camera.setCenter(left + width / 2.f, top + height / 2.f);
+	cameraSetZoom(std::min(CAMERA_ZOOM_MAX, std::max(CAMERA_ZOOM_MIN, zoom)));
+}
@@ -32,7 +32,10 @@
 
 #include "Scene.hpp"
 #include "gol/Simulation.hpp"
+#include "gol/BoundedSimulation.hpp"
 #include "SimulationRenderer.hpp"
+#include "SimulationThread.hpp"
+#include <string>
 
 
 class SimulationScene : public Scene
@@ -40,28 +43,28 @@ class SimulationScene : public Scene
 public:
 	SimulationScene(SceneManager& m)
 		: Scene(m, "Simulation")
-		, m_paused(true)
-		, m_stepOnce(false)
-		, m_hideIntro(false)
-		, m_showGrid(true)
-		, m_debugMode(0)
+		, m_sim(nullptr)
+		, m_chunkedSim(nullptr)
+		, m_boundedSim(nullptr)
 		, m_cameraZoom(1.f)
 		, m_cameraMoveSpeed(1.f)
-		, m_targetStepsPerSecond(60.f)
-		, m_debugStepsPerSecond(0.f)
+		, m_showGrid(true)
+		, m_paused(true)
+		, m_debugMode(0)
+		, m_debugWorkers(0)
+		, m_hideIntro(false)
 		, m_lastPreUpdate(0.f)
-		, m_stepAccumulator(0.f)
 	{ }
 
 	// Get steps/second performance.
-	inline float getStepsPerSecond() const { return m_debugStepsPerSecond; }
+	inline float getStepsPerSecond() const { return m_simThread.getStepsPerSecond(); }
 
 	// Get the target simulation steps/second.
-	inline float getTargetStepsPerSecond() const { return m_targetStepsPerSecond; }
+	inline float getTargetStepsPerSecond() const { return m_simThread.getTargetStepsPerSecond(); }
 
 	// Set the target simulation steps/second.
-	// Setting to 0 disables update limiting and will step once per frame.
-	inline void setTargetStepsPerSecond(float updateRate) { m_targetStepsPerSecond = std::max(0.f, updateRate); }
+	// Setting to 0 disables update limiting and will step as fast as possible.
+	inline void setTargetStepsPerSecond(float updateRate) { m_simThread.setTargetStepsPerSecond(updateRate); }
 
 protected:
 	virtual void init()   override;
@@ -71,22 +74,27 @@ protected:
 	virtual void render() override;
 
 private:
-	gol::Simulation    m_sim;
+	// Active universe. Points to either m_chunkedSim or m_boundedSim.
+	gol::Universe*           m_sim;
+	gol::Simulation*         m_chunkedSim;
+	gol::BoundedSimulation*  m_boundedSim;
 	SimulationRenderer m_renderer;
 
+	// Steps the active universe. Hold its guard to use the universe.
+	SimulationThread m_simThread;
+
 	sf::View m_camera;
 	float    m_cameraZoom;
 	float    m_cameraMoveSpeed;
 
 	bool m_showGrid;
-	sf::RectangleShape m_gridLine;
+	OverlayLayer m_gridOverlay;
 
 	bool m_paused;
-	bool m_stepOnce;
 
 	int   m_debugMode;
-	float m_debugStepsPerSecond;
-	float m_targetStepsPerSecond;
+	size_t m_debugWorkers;       //> Worker threads of the universe, as last read.
+	std::string m_debugUniverse; //> Universe statistics (or step profile), as last read.
 
 	sf::Text m_txtIntro;
 	bool     m_hideIntro;
@@ -108,12 +116,28 @@ private:
 		bool zoomIn     = false;
 		bool zoomOut    = false;
 	} m_controls;
+
+	// Frame times measured at each debug mode and zoom level in turn (b key), logged to the console.
+	struct {
+		int          step      = -1;  //> Debug mode and zoom level being measured, or -1 if not sweeping.
+		unsigned int frame     = 0;   //> Frames rendered at this step.
+		float        render    = 0.f; //> Totals of the measured frames, in seconds.
+		float        build     = 0.f;
+		float        submit    = 0.f;
+		int          debugMode = 0;   //> Debug mode and zoom restored once done.
+		float        zoom      = 1.f;
+	} m_frameSweep;
 	
 	float m_lastPreUpdate;
-	float m_stepAccumulator;
-	int preUpdate();
+	void preUpdate();
 	void toggleDebug(int mode);
+	void startFrameSweep();
+	void stopFrameSweep();
+	void updateFrameSweep();
+	std::string getUniverseStatistics() const;
+	std::string getStepStatistics() const;
 	void placeCells(int x, int y, int size, bool alive);
 	void screenToWorld(int scr_x, int scr_y, int& out_x, int& out_y);
 	void cameraSetZoom(float zoom);
+	void cameraFitPattern();
 };
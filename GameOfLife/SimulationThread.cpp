@@ -0,0 +1,301 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// SimulationThread.cpp
+// 
+// Implements class SimulationThread
+// 
+
+#include "SimulationThread.hpp"
+#include <algorithm>
+
+
+//////////////////////////////////////////////////////////////////////
+SimulationThread::SimulationThread()
+	: m_universe(nullptr)
+	, m_chunkedSim(nullptr)
+	, m_boundedSim(nullptr)
+	, m_running(false)
+	, m_paused(true)
+	, m_stepOnce(false)
+	, m_targetStepsPerSecond(60.f)
+	, m_changes(0)
+	, m_publishedChanges(0)
+	, m_snapshotWanted(true)
+	, m_stepsPerSecond(0.f)
+{
+}
+
+
+//////////////////////////////////////////////////////////////////////
+SimulationThread::~SimulationThread()
+{
+	this->stop();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationThread::start(gol::Universe& universe)
+{
+	this->stop();
+
+	std::lock_guard<std::mutex> state(m_stateGuard);
+	m_universe = &universe;
+	m_chunkedSim = dynamic_cast<gol::Simulation*>(&universe);
+	m_boundedSim = dynamic_cast<gol::BoundedSimulation*>(&universe);
+	m_running = true;
+	m_nextStep = Clock::now();
+	m_changes++;
+	m_snapshot.reset();
+	m_boundedSnapshot.reset();
+	m_snapshotWanted = true;
+	m_thread = std::thread(&SimulationThread::run, this);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationThread::stop()
+{
+	{
+		std::lock_guard<std::mutex> state(m_stateGuard);
+		m_running = false;
+	}
+	m_wake.notify_all();
+
+	if (m_thread.joinable())
+		m_thread.join();
+
+	m_snapshot.reset();
+	m_boundedSnapshot.reset();
+	m_universe = nullptr;
+	m_chunkedSim = nullptr;
+	m_boundedSim = nullptr;
+	m_stepsPerSecond = 0.f;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationThread::invalidate()
+{
+	{
+		std::lock_guard<std::mutex> state(m_stateGuard);
+		m_changes++;
+	}
+	m_wake.notify_all();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationThread::setPaused(bool paused)
+{
+	{
+		std::lock_guard<std::mutex> state(m_stateGuard);
+		m_paused = paused;
+		m_nextStep = Clock::now();
+	}
+	m_wake.notify_all();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool SimulationThread::isPaused() const
+{
+	std::lock_guard<std::mutex> state(m_stateGuard);
+	return m_paused;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationThread::stepOnce()
+{
+	{
+		std::lock_guard<std::mutex> state(m_stateGuard);
+		m_stepOnce = true;
+	}
+	m_wake.notify_all();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationThread::setTargetStepsPerSecond(float rate)
+{
+	{
+		std::lock_guard<std::mutex> state(m_stateGuard);
+		m_targetStepsPerSecond = std::max(0.f, rate);
+		m_nextStep = Clock::now();
+	}
+	m_wake.notify_all();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+float SimulationThread::getTargetStepsPerSecond() const
+{
+	std::lock_guard<std::mutex> state(m_stateGuard);
+	return m_targetStepsPerSecond;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+std::shared_ptr<const gol::Snapshot> SimulationThread::getSnapshot()
+{
+	std::shared_ptr<const gol::Snapshot> snapshot;
+	{
+		std::lock_guard<std::mutex> state(m_stateGuard);
+		snapshot = m_snapshot;
+		m_snapshotWanted = true;
+	}
+	m_wake.notify_all();
+	return snapshot;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+std::shared_ptr<const gol::BoundedSnapshot> SimulationThread::getBoundedSnapshot()
+{
+	std::shared_ptr<const gol::BoundedSnapshot> snapshot;
+	{
+		std::lock_guard<std::mutex> state(m_stateGuard);
+		snapshot = m_boundedSnapshot;
+		m_snapshotWanted = true;
+	}
+	m_wake.notify_all();
+	return snapshot;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationThread::run()
+{
+	Clock::time_point rateStart = Clock::now();
+	unsigned int rateSteps = 0;
+
+	std::unique_lock<std::mutex> state(m_stateGuard);
+	while (m_running)
+	{
+		const Clock::time_point now = Clock::now();
+		const bool limited = (m_targetStepsPerSecond > 0);
+		const bool stepping = m_stepOnce || (!m_paused && (!limited || now >= m_nextStep));
+
+		// Snapshots are only made once the previous one has been read, so stepping flat out doesn't wait on them
+		const bool publishing = (m_chunkedSim != nullptr || m_boundedSim != nullptr) && m_snapshotWanted && (m_publishedChanges != m_changes);
+
+		if (!stepping && !publishing)
+		{
+			if (m_paused)
+				m_stepsPerSecond = 0.f;
+
+			// Sleep until the next step is due, or anything changes
+			if (!m_paused && limited)
+				m_wake.wait_until(state, m_nextStep);
+			else
+				m_wake.wait(state);
+			continue;
+		}
+
+		// Catch up on every step due since the last one, though at most a quarter second behind
+		unsigned int steps = 0;
+		if (m_stepOnce)
+		{
+			steps = 1;
+		}
+		else if (stepping && !limited)
+		{
+			steps = 1;
+		}
+		else if (stepping)
+		{
+			const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.f / m_targetStepsPerSecond));
+			const unsigned int maxSteps = std::max(1u, static_cast<unsigned int>(m_targetStepsPerSecond / 4.f));
+			steps = 1 + static_cast<unsigned int>((now - m_nextStep) / interval);
+			if (steps > maxSteps)
+			{
+				steps = maxSteps;
+				m_nextStep = now;
+			}
+			m_nextStep += interval * steps;
+		}
+		m_stepOnce = false;
+
+		// Changes seen by the snapshot, including the steps about to be made
+		if (steps > 0)
+			m_changes++;
+		const unsigned long long changes = m_changes;
+		const bool snapshotWanted = m_snapshotWanted;
+		state.unlock();
+
+		std::shared_ptr<const gol::Snapshot> snapshot;
+		std::shared_ptr<const gol::BoundedSnapshot> boundedSnapshot;
+		{
+			std::lock_guard<std::mutex> engine(m_guard);
+
+			// Queued edits are applied by step(), or here while paused
+			if (m_chunkedSim)
+				m_chunkedSim->applyEdits();
+			else if (m_boundedSim)
+				m_boundedSim->applyEdits();
+			this->stepUniverse(steps);
+			if (snapshotWanted && m_chunkedSim)
+				snapshot = m_chunkedSim->snapshot();
+			else if (snapshotWanted && m_boundedSim)
+				boundedSnapshot = m_boundedSim->snapshot();
+		}
+
+		// Measure steps/second every half second
+		rateSteps += steps;
+		const float elapsed = std::chrono::duration<float>(Clock::now() - rateStart).count();
+		if (elapsed >= 0.5f)
+		{
+			m_stepsPerSecond = rateSteps / elapsed;
+			rateSteps = 0;
+			rateStart = Clock::now();
+		}
+
+		state.lock();
+		if (snapshot || boundedSnapshot)
+		{
+			m_snapshot = std::move(snapshot);
+			m_boundedSnapshot = std::move(boundedSnapshot);
+			m_snapshotWanted = false;
+			m_publishedChanges = changes;
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void SimulationThread::stepUniverse(unsigned int steps)
+{
+	for (unsigned int i = 0; i < steps; i++)
+	{
+		// Skip whole cycles once the universe repeats itself
+		if (m_chunkedSim && m_chunkedSim->isStable())
+		{
+			m_chunkedSim->fastForward(steps - i);
+			return;
+		}
+
+		m_universe->step();
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// SimulationThread.hpp
+//
+// class SimulationThread
+// 
+// Steps a gol::Universe on its own thread, at a target rate or as fast as
+// possible, so slow steps never stall rendering or input. The universe is
+// only touched while holding getGuard(). Universes publish immutable
+// snapshots (see gol::Simulation::snapshot() and
+// gol::BoundedSimulation::snapshot()) for the renderer, which reads them
+// without holding the lock.
+// 
+
+#include "gol/Universe.hpp"
+#include "gol/Simulation.hpp"
+#include "gol/BoundedSimulation.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+
+class SimulationThread
+{
+public:
+	SimulationThread();
+	~SimulationThread();
+
+	// Start stepping the universe given, stopping any universe stepped before.
+	void start(gol::Universe& universe);
+
+	// Stop stepping, waiting for the current step to finish.
+	void stop();
+
+	// Get the lock held while the universe is stepped. Hold it to use the universe from any other thread,
+	// and call invalidate() afterwards if the universe was modified.
+	inline std::mutex& getGuard() { return m_guard; }
+
+	// Publish a new snapshot, as the universe was modified outside of this thread
+	// (or edits were queued, see gol::Simulation::queueCell() and gol::BoundedSimulation::queueCell()).
+	void invalidate();
+
+	// Pause or resume stepping.
+	void setPaused(bool paused);
+	bool isPaused() const;
+
+	// Step once while paused.
+	void stepOnce();
+
+	// Set the target simulation steps/second. Setting to 0 steps as fast as possible.
+	void setTargetStepsPerSecond(float rate);
+	float getTargetStepsPerSecond() const;
+
+	// Get measured steps/second.
+	inline float getStepsPerSecond() const { return m_stepsPerSecond; }
+
+	// Get the latest snapshot of a chunked universe (nullptr for other universes).
+	// A newer snapshot is published once the universe changes.
+	std::shared_ptr<const gol::Snapshot> getSnapshot();
+
+	// Get the latest snapshot of a bounded universe (nullptr for other universes).
+	// A newer snapshot is published once the universe changes.
+	std::shared_ptr<const gol::BoundedSnapshot> getBoundedSnapshot();
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	gol::Universe* m_universe;
+	gol::Simulation* m_chunkedSim; //> m_universe if chunked, or nullptr.
+	gol::BoundedSimulation* m_boundedSim; //> m_universe if bounded, or nullptr.
+	std::thread m_thread;
+	std::mutex m_guard;
+
+	// State shared with the thread, guarded by m_stateGuard.
+	mutable std::mutex m_stateGuard;
+	std::condition_variable m_wake;
+	bool m_running;
+	bool m_paused;
+	bool m_stepOnce;
+	float m_targetStepsPerSecond;
+	Clock::time_point m_nextStep;
+	unsigned long long m_changes;          //> Count of steps and modifications, see invalidate().
+	unsigned long long m_publishedChanges; //> m_changes as of the latest snapshot.
+	bool m_snapshotWanted;                 //> Latest snapshot has been read by getSnapshot().
+	std::shared_ptr<const gol::Snapshot> m_snapshot;
+	std::shared_ptr<const gol::BoundedSnapshot> m_boundedSnapshot;
+
+	std::atomic<float> m_stepsPerSecond;
+
+	// Internal: Thread main loop.
+	void run();
+
+	// Internal: Step the universe a number of generations. Must hold m_guard.
+	void stepUniverse(unsigned int steps);
+};
@@ -0,0 +1,121 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// TaskPool.cpp
+// 
+// Implements class TaskPool
+// 
+
+#include "TaskPool.hpp"
+#include <algorithm>
+
+
+//////////////////////////////////////////////////////////////////////
+TaskPool::TaskPool()
+	: m_running(true)
+	, m_job(nullptr)
+	, m_count(0)
+	, m_jobID(0)
+	, m_busy(0)
+	, m_next(0)
+{
+	const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int i = 1; i < cores; i++)
+		m_threads.emplace_back(&TaskPool::work, this);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_guard);
+		m_running = false;
+	}
+	m_wake.notify_all();
+
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void TaskPool::run(size_t count, const std::function<void(size_t)>& fn)
+{
+	// Not worth waking workers for
+	if (m_threads.empty() || count <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+			fn(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_guard);
+		m_job = &fn;
+		m_count = count;
+		m_next = 0;
+		m_jobID++;
+	}
+	m_wake.notify_all();
+
+	this->runTasks();
+
+	// Wait for workers still running tasks, and stop late workers joining
+	std::unique_lock<std::mutex> lock(m_guard);
+	m_done.wait(lock, [this]() { return m_busy == 0; });
+	m_job = nullptr;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void TaskPool::work()
+{
+	unsigned int lastJobID = 0;
+	std::unique_lock<std::mutex> lock(m_guard);
+	while (true)
+	{
+		m_wake.wait(lock, [&]() { return !m_running || (m_job != nullptr && m_jobID != lastJobID); });
+		if (!m_running)
+			break;
+
+		lastJobID = m_jobID;
+		m_busy++;
+		lock.unlock();
+
+		this->runTasks();
+
+		lock.lock();
+		if (--m_busy == 0)
+			m_done.notify_all();
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void TaskPool::runTasks()
+{
+	for (size_t i = m_next++; i < m_count; i = m_next++)
+		(*m_job)(i);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// TaskPool.hpp
+//
+// class TaskPool
+// 
+// A small pool of worker threads for splitting work between cores, such
+// as building render geometry for many chunks at once. The thread calling
+// run() works on tasks too, so a pool without workers runs everything on
+// the calling thread.
+// 
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+
+class TaskPool
+{
+public:
+	// Start a worker for each core, besides the one calling run().
+	TaskPool();
+	~TaskPool();
+
+	// Call fn with each index from 0 to count - 1, spread over the workers. Returns once every call has finished.
+	// Only one thread may call run() at a time.
+	void run(size_t count, const std::function<void(size_t)>& fn);
+
+	// Get number of worker threads, not counting the thread calling run().
+	inline size_t getThreadCount() const { return m_threads.size(); }
+
+private:
+	std::vector<std::thread> m_threads;
+	std::mutex m_guard;
+	std::condition_variable m_wake; //> Workers wait for a job.
+	std::condition_variable m_done; //> run() waits for workers to finish the job.
+	bool m_running;
+
+	// Current job, guarded by m_guard.
+	const std::function<void(size_t)>* m_job;
+	size_t m_count;
+	unsigned int m_jobID;           //> Counts jobs, so workers join each job once.
+	size_t m_busy;                  //> Workers working on the current job.
+	std::atomic<size_t> m_next;     //> Next task of the current job.
+
+	// Internal: Worker main loop.
+	void work();
+
+	// Internal: Run tasks of the current job until none are left.
+	void runTasks();
+};
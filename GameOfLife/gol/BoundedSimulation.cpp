@@ -0,0 +1,426 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/BoundedSimulation.cpp
+// 
+// Implements class gol::BoundedSimulation
+// 
+
+#include "BoundedSimulation.hpp"
+#include <bitset>
+#include <algorithm>
+
+
+using namespace gol;
+
+
+// Count alive cells in a packed word.
+static inline unsigned int countWord(BoundedSimulation::Word w)
+{
+	return static_cast<unsigned int>(std::bitset<BoundedSimulation::WORD_BITS>(w).count());
+}
+
+
+//////////////////////////////////////////////////////////////////////
+BoundedSimulation::BoundedSimulation(int width, int height, bool wrap)
+	: m_width(0)
+	, m_height(0)
+	, m_wrap(wrap)
+	, m_rowWords(0)
+	, m_lastWordMask(0)
+	, m_cellCount(0)
+	, m_births(0)
+	, m_deaths(0)
+	, m_generation(0)
+	, m_ruleset(Ruleset::GameOfLife)
+	, m_multithreaded(true)
+	, m_availableThreads(std::thread::hardware_concurrency())
+	, m_ccStepID(0)
+	, m_ccRemaining(0)
+	, m_ccCellCount(0)
+	, m_ccBirths(0)
+	, m_ccDeaths(0)
+{
+	this->resize(width, height);
+	this->setRuleset(m_ruleset);
+
+	// Initialize multithreaded mode
+	this->setMultithreadMode(m_multithreaded);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+BoundedSimulation::~BoundedSimulation()
+{
+	// Destroy worker threads if necessary
+	this->setMultithreadMode(false);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void BoundedSimulation::resize(int width, int height)
+{
+	m_width    = std::max(MIN_SIZE, width);
+	m_height   = std::max(MIN_SIZE, height);
+	m_rowWords = (m_width + WORD_BITS - 1) / WORD_BITS;
+
+	// Mask off bits past the east edge in the last word of each row
+	int lastBits = m_width % WORD_BITS;
+	m_lastWordMask = (lastBits == 0) ? ~Word(0) : ((Word(1) << lastBits) - 1);
+
+	m_cells.assign(m_rowWords * m_height, 0);
+	m_nextCells.assign(m_rowWords * m_height, 0);
+	m_deadRow.assign(m_rowWords, 0);
+
+	this->reset();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void BoundedSimulation::reset(bool resetGeneration)
+{
+	std::fill(m_cells.begin(), m_cells.end(), 0);
+	m_edits.clear();
+	m_cellCount = 0;
+	m_births    = 0;
+	m_deaths    = 0;
+
+	if (resetGeneration)
+		m_generation = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void BoundedSimulation::step()
+{
+	this->applyEdits();
+
+	if (m_multithreaded && !m_ccWorkers.empty() && m_height >= MIN_MULTITHREADED_ROWS)
+	{
+		m_ccCellCount = 0;
+		m_ccBirths    = 0;
+		m_ccDeaths    = 0;
+
+		// Wake workers, each one processes its own band of rows
+		{
+			std::unique_lock<std::mutex> lk(m_ccGuard);
+			m_ccRemaining = m_availableThreads;
+			m_ccStepID++;
+		}
+		m_ccSync.notify_all();
+
+		// Wait for all bands to finish
+		{
+			std::unique_lock<std::mutex> lk(m_ccGuard);
+			m_ccDone.wait(lk, [this] { return m_ccRemaining == 0; });
+		}
+
+		m_cellCount = m_ccCellCount;
+		m_births    = m_ccBirths;
+		m_deaths    = m_ccDeaths;
+	}
+	else // Single-threaded
+	{
+		unsigned int births = 0, deaths = 0, population = 0;
+		this->stepRows(0, m_height, births, deaths, population);
+		m_cellCount = population;
+		m_births    = births;
+		m_deaths    = deaths;
+	}
+
+	m_cells.swap(m_nextCells);
+	m_generation++;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void BoundedSimulation::stepRows(int yBegin, int yEnd, unsigned int& births, unsigned int& deaths, unsigned int& population)
+{
+	const size_t words = m_rowWords;
+	const int eastBit  = (m_width - 1) % WORD_BITS;
+
+	for (int y = yBegin; y < yEnd; y++)
+	{
+		// Find rows north and south of this row, wrapping or reading dead cells past the edges
+		const Word* up;
+		const Word* down;
+		if (y > 0)
+			up = &m_cells[(y - 1) * words];
+		else
+			up = m_wrap ? &m_cells[(m_height - 1) * words] : m_deadRow.data();
+		if (y < m_height - 1)
+			down = &m_cells[(y + 1) * words];
+		else
+			down = m_wrap ? &m_cells[0] : m_deadRow.data();
+
+		const Word* mid = &m_cells[y * words];
+		Word* out = &m_nextCells[y * words];
+
+		for (size_t i = 0; i < words; i++)
+		{
+			// Shift each row one cell east and west so that every bit lines up with its neighbours.
+			// Bits are carried across word boundaries, and across the universe edges when wrapping.
+			Word uw = up[i]   << 1, ue = up[i]   >> 1;
+			Word mw = mid[i]  << 1, me = mid[i]  >> 1;
+			Word dw = down[i] << 1, de = down[i] >> 1;
+
+			if (i > 0)
+			{
+				uw |= up[i - 1]   >> (WORD_BITS - 1);
+				mw |= mid[i - 1]  >> (WORD_BITS - 1);
+				dw |= down[i - 1] >> (WORD_BITS - 1);
+			}
+			else if (m_wrap)
+			{
+				uw |= (up[words - 1]   >> eastBit) & 1;
+				mw |= (mid[words - 1]  >> eastBit) & 1;
+				dw |= (down[words - 1] >> eastBit) & 1;
+			}
+
+			if (i < words - 1)
+			{
+				ue |= up[i + 1]   << (WORD_BITS - 1);
+				me |= mid[i + 1]  << (WORD_BITS - 1);
+				de |= down[i + 1] << (WORD_BITS - 1);
+			}
+			else if (m_wrap)
+			{
+				ue |= (up[0]   & 1) << eastBit;
+				me |= (mid[0]  & 1) << eastBit;
+				de |= (down[0] & 1) << eastBit;
+			}
+
+			// Sum neighbours as bit-sliced binary counters (64 cells at a time)
+			// Row north: three cells, row south: three cells, this row: two cells
+			Word us = uw ^ up[i] ^ ue,  uc = (uw & up[i])   | (ue & (uw ^ up[i]));
+			Word ds = dw ^ down[i] ^ de, dc = (dw & down[i]) | (de & (dw ^ down[i]));
+			Word ms = mw ^ me,           mc = mw & me;
+
+			// Ones column
+			Word b0 = us ^ ms ^ ds;
+			Word c0 = (us & ms) | (ds & (us ^ ms));
+
+			// Twos column (three row carries plus ones carry)
+			Word t0 = uc ^ mc ^ dc;
+			Word t1 = (uc & mc) | (dc & (uc ^ mc));
+			Word b1 = t0 ^ c0;
+			Word c1 = t0 & c0;
+
+			// Fours and eights columns
+			Word b2 = t1 ^ c1;
+			Word b3 = t1 & c1;
+
+			// Apply rules
+			Word born = 0, survive = 0;
+			for (const RuleTerm& term : m_ruleTerms)
+			{
+				const int n = term.neighbours;
+				Word match = ((n & 1) ? b0 : ~b0) & ((n & 2) ? b1 : ~b1) &
+				             ((n & 4) ? b2 : ~b2) & ((n & 8) ? b3 : ~b3);
+				if (term.birth)
+					born |= match;
+				if (term.survival)
+					survive |= match;
+			}
+
+			Word cur  = mid[i];
+			Word next = (cur & survive) | (~cur & born);
+			if (i == words - 1)
+				next &= m_lastWordMask;
+
+			out[i] = next;
+			births     += countWord(next & ~cur);
+			deaths     += countWord(cur & ~next);
+			population += countWord(next);
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void BoundedSimulation::ccStartWorker(BoundedSimulation* sim, size_t band, unsigned int stepID)
+{
+	for (;;)
+	{
+		// Wait for next step
+		{
+			std::unique_lock<std::mutex> lk(sim->m_ccGuard);
+			sim->m_ccSync.wait(lk, [&] { return !sim->m_multithreaded || sim->m_ccStepID != stepID; });
+			if (!sim->m_multithreaded)
+				break; //> Simulation multithreading was disabled while on standby
+			stepID = sim->m_ccStepID;
+		}
+
+		// Process this worker's band of rows
+		int bands    = static_cast<int>(sim->m_availableThreads);
+		int bandRows = (sim->m_height + bands - 1) / bands;
+		int yBegin   = std::min(sim->m_height, static_cast<int>(band) * bandRows);
+		int yEnd     = std::min(sim->m_height, yBegin + bandRows);
+
+		unsigned int births = 0, deaths = 0, population = 0;
+		sim->stepRows(yBegin, yEnd, births, deaths, population);
+		sim->m_ccBirths    += births;
+		sim->m_ccDeaths    += deaths;
+		sim->m_ccCellCount += population;
+
+		// Notify step() once every band is done
+		std::unique_lock<std::mutex> lk(sim->m_ccGuard);
+		if (--sim->m_ccRemaining == 0)
+			sim->m_ccDone.notify_one();
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void BoundedSimulation::setMultithreadMode(bool enable)
+{
+	// Check if multithreading is available
+	if (enable)
+	{
+		m_multithreaded = (m_availableThreads > 1);
+		if (m_multithreaded && m_ccWorkers.empty())
+		{
+			// Create and start worker threads, one per band of rows
+			for (size_t i = 0; i < m_availableThreads; i++)
+				m_ccWorkers.push_back(std::thread(&ccStartWorker, this, i, m_ccStepID));
+		}
+	}
+	else
+	{
+		// Signal to close workers and join to main thread
+		{
+			std::unique_lock<std::mutex> lk(m_ccGuard);
+			m_multithreaded = false;
+		}
+		if (!m_ccWorkers.empty())
+		{
+			m_ccSync.notify_all();
+			for (std::thread& worker : m_ccWorkers)
+				worker.join();
+			m_ccWorkers.clear();
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool BoundedSimulation::wrapCoords(int& x, int& y) const
+{
+	if (x >= 0 && x < m_width && y >= 0 && y < m_height)
+		return true;
+
+	if (!m_wrap)
+		return false;
+
+	x %= m_width;
+	y %= m_height;
+	if (x < 0)
+		x += m_width;
+	if (y < 0)
+		y += m_height;
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void BoundedSimulation::setCell(int x, int y, bool alive)
+{
+	if (!this->wrapCoords(x, y))
+		return;
+
+	Word& w  = m_cells[y * m_rowWords + x / WORD_BITS];
+	Word bit = Word(1) << (x % WORD_BITS);
+
+	// Modify population count
+	if ((w & bit) != 0)
+	{
+		if (!alive)
+		{
+			w &= ~bit;
+			m_cellCount--;
+		}
+	}
+	else
+	{
+		if (alive)
+		{
+			w |= bit;
+			m_cellCount++;
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void BoundedSimulation::applyEdits()
+{
+	if (m_edits.empty())
+		return;
+
+	m_editBuffer.clear();
+	m_edits.take(m_editBuffer);
+	for (const CellEdit& edit : m_editBuffer)
+		this->setCell(edit.x, edit.y, edit.alive);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+std::shared_ptr<const BoundedSnapshot> BoundedSimulation::snapshot() const
+{
+	std::shared_ptr<BoundedSnapshot> snapshot(new BoundedSnapshot());
+	snapshot->m_width = m_width;
+	snapshot->m_height = m_height;
+	snapshot->m_wrap = m_wrap;
+	snapshot->m_rowWords = m_rowWords;
+	snapshot->m_generation = m_generation;
+	snapshot->m_population = m_cellCount;
+	snapshot->m_cells = m_cells;
+	return snapshot;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool BoundedSimulation::getCell(int x, int y) const
+{
+	if (!this->wrapCoords(x, y))
+		return false;
+
+	return ((m_cells[y * m_rowWords + x / WORD_BITS] >> (x % WORD_BITS)) & 1) != 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void BoundedSimulation::setRuleset(const Ruleset& ruleset)
+{
+	m_ruleset = ruleset;
+
+	// Only neighbour counts that change a cell's next state need to be evaluated
+	m_ruleTerms.clear();
+	for (int n = 0; n <= static_cast<int>(Ruleset::MAX_NEIGHBOURS); n++)
+	{
+		RuleTerm term = { n, m_ruleset.testBirth(n), m_ruleset.testSurvival(n) };
+		if (term.birth || term.survival)
+			m_ruleTerms.push_back(term);
+	}
+}
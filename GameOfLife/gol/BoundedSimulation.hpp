@@ -0,0 +1,230 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/BoundedSimulation.hpp
+//
+// class gol::BoundedSimulation
+// 
+// Handles the processing of the "Game Of Life" simulation in a bounded,
+// fixed-size universe, optionally with wrap-around (toroidal) edges.
+// Unlike gol::Simulation, there are no chunks: cells are stored in a
+// single contiguous grid, packed one bit per cell, and each step
+// evaluates 64 cells at a time with bitwise arithmetic. Rows are split
+// into bands which are processed in parallel by worker threads.
+// 
+
+#include "Universe.hpp"
+#include "Ruleset.hpp"
+#include "EditJournal.hpp"
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+
+namespace gol
+{
+
+class BoundedSnapshot;
+
+class BoundedSimulation : public Universe
+{
+public:
+	// Packed cell storage unit. Bit (x % WORD_BITS) of word (x / WORD_BITS) holds cell x of a row.
+	typedef uint64_t Word;
+	static const int WORD_BITS = 64;
+
+	// Universes with fewer rows than this are always stepped on the calling thread.
+	static const int MIN_MULTITHREADED_ROWS = 256;
+
+	// Smallest width or height. Narrower tori would count a cell's wrapped neighbours twice.
+	static const int MIN_SIZE = 3;
+
+	BoundedSimulation(int width, int height, bool wrap = true);
+	virtual ~BoundedSimulation();
+
+	// Resets the entire simulation.
+	// resetGeneration: Resets generation counter to zero.
+	virtual void reset(bool resetGeneration = true) override;
+
+	// Steps the simulation once. This will move on to the next generation of the simulation.
+	virtual void step() override;
+
+	// Set alive state for cell at position {x,y}.
+	// Positions outside of the universe wrap around if wrapping is enabled, otherwise they are ignored.
+	virtual void setCell(int x, int y, bool alive) override;
+
+	// Get alive state for cell at position {x,y}.
+	// Positions outside of the universe wrap around if wrapping is enabled, otherwise they are dead.
+	virtual bool getCell(int x, int y) const override;
+
+	// Get the current generation.
+	virtual unsigned int getGeneration() const override { return m_generation; }
+
+	// Get number of births for this generation.
+	virtual unsigned int getBirths() const override { return m_births; }
+
+	// Get number of deaths for this generation.
+	virtual unsigned int getDeaths() const override { return m_deaths; }
+
+	// Get the count of currently alive cells.
+	virtual unsigned int getPopulation() const override { return m_cellCount; }
+
+	// Get simulation rule-set.
+	virtual const Ruleset& getRuleset() const override { return m_ruleset; }
+
+	// Set simulation rule-set.
+	virtual void setRuleset(const Ruleset& ruleset) override;
+
+	// Enable or disable multithreading mode.
+	virtual void setMultithreadMode(bool enable) override;
+
+	// Get whether the simulation is multithreaded.
+	virtual bool isMultithreaded() const override { return m_multithreaded; }
+
+	// Get number of worker threads running.
+	// Returns 0 if multithreading mode is disabled.
+	virtual size_t getWorkerThreadCount() const override { return m_ccWorkers.size(); }
+
+	// Resize the universe. All cells are cleared and the generation counter is reset.
+	// Sizes below MIN_SIZE are raised to it.
+	void resize(int width, int height);
+
+	// Get width of the universe, in cells.
+	inline int getWidth() const { return m_width; }
+
+	// Get height of the universe, in cells.
+	inline int getHeight() const { return m_height; }
+
+	// Enable or disable wrap-around edges.
+	inline void setWrap(bool enable) { m_wrap = enable; }
+
+	// Get whether edges wrap around (toroidal universe).
+	inline bool isWrapping() const { return m_wrap; }
+
+	// Queue alive state for cell at position {x,y}, set before the next generation (or by applyEdits()).
+	// Unlike setCell(), this may be called from any thread, even while the simulation is being stepped.
+	inline void queueCell(int x, int y, bool alive) { m_edits.record(x, y, alive); }
+
+	// Queue a batch of cell edits, see queueCell().
+	inline void queueCells(std::vector<CellEdit>&& edits) { m_edits.record(std::move(edits)); }
+
+	// Apply queued edits in the order they were queued. Called by step() before each generation.
+	void applyEdits();
+
+	// Copy the cells of the universe into an immutable snapshot, which may be read from any thread.
+	// Must not be called while the simulation is being stepped or modified.
+	std::shared_ptr<const BoundedSnapshot> snapshot() const;
+
+	// Get number of words per packed row.
+	inline size_t getRowWords() const { return m_rowWords; }
+
+	// Get packed cell row y. Length is getRowWords(). Does not perform any safety checks.
+	inline const Word* getRow(int y) const { return &m_cells[y * m_rowWords]; }
+
+private:
+	int m_width;
+	int m_height;
+	bool m_wrap;
+	size_t m_rowWords;
+	Word m_lastWordMask;
+	std::vector<Word> m_cells;
+	std::vector<Word> m_nextCells;
+	std::vector<Word> m_deadRow;
+
+	unsigned int m_cellCount;
+	unsigned int m_births;
+	unsigned int m_deaths;
+	unsigned int m_generation;
+	Ruleset m_ruleset;
+	EditJournal m_edits;
+	std::vector<CellEdit> m_editBuffer; //> Edits being applied by applyEdits().
+
+	// Neighbour counts (0-8) which cause a birth, or let a cell survive.
+	struct RuleTerm { int neighbours; bool birth; bool survival; };
+	std::vector<RuleTerm> m_ruleTerms;
+
+	// Internal: Translate {x,y} to cell coordinates within the universe.
+	// Returns false if the position lies outside of a non-wrapping universe.
+	bool wrapCoords(int& x, int& y) const;
+
+	// Internal: Compute next generation for rows [yBegin, yEnd) into m_nextCells.
+	void stepRows(int yBegin, int yEnd, unsigned int& births, unsigned int& deaths, unsigned int& population);
+
+	///////////////////////
+	///// Concurrency /////
+	///////////////////////
+
+	bool m_multithreaded;
+	size_t m_availableThreads;
+	std::vector<std::thread> m_ccWorkers;
+	std::mutex m_ccGuard;
+	std::condition_variable m_ccSync;
+	std::condition_variable m_ccDone;
+	unsigned int m_ccStepID;
+	size_t m_ccRemaining;
+	std::atomic_uint m_ccCellCount;
+	std::atomic_uint m_ccBirths;
+	std::atomic_uint m_ccDeaths;
+	static void ccStartWorker(BoundedSimulation* sim, size_t band, unsigned int stepID);
+};
+
+// Immutable copy of the cells of a bounded universe, see BoundedSimulation::snapshot().
+class BoundedSnapshot
+{
+public:
+	// Get size of the universe, in cells.
+	inline int getWidth() const { return m_width; }
+	inline int getHeight() const { return m_height; }
+
+	// Get whether edges wrap around (toroidal universe).
+	inline bool isWrapping() const { return m_wrap; }
+
+	// Get the generation the snapshot was made at.
+	inline unsigned int getGeneration() const { return m_generation; }
+
+	// Get the count of alive cells.
+	inline unsigned int getPopulation() const { return m_population; }
+
+	// Get packed cell row y, see BoundedSimulation::getRow(). Does not perform any safety checks.
+	inline const BoundedSimulation::Word* getRow(int y) const { return &m_cells[y * m_rowWords]; }
+
+private:
+	friend class BoundedSimulation;
+
+	int m_width;
+	int m_height;
+	bool m_wrap;
+	size_t m_rowWords;
+	unsigned int m_generation;
+	unsigned int m_population;
+	std::vector<BoundedSimulation::Word> m_cells;
+};
+
+}
@@ -31,51 +31,135 @@
 #include "Chunk.hpp"
 #include "Simulation.hpp"
 #include "CellManipulation.hpp"
+#include "Snapshot.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <bitset>
+#include <cstring>
 
 using namespace gol;
 
 
-unsigned int Chunk::NEXT_UNIQUE_ID = 0;
+std::atomic<unsigned int> Chunk::NEXT_UNIQUE_ID(0);
+
+
+// Sparse mode: cells visited by the update in progress on this thread, so each is updated once.
+// A thread updates one chunk at a time, so chunks share this rather than each holding their own.
+struct SparseVisited
+{
+	std::bitset<Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE> cells;
+	unsigned short list[Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE] = {}; //> Indices of visited cells, to reset them.
+	size_t count = 0;
+};
+static thread_local SparseVisited sparseVisited;
+
+// Formats of compressed cells, stored in the first byte.
+static const unsigned char COMPRESS_RUNS = 0;   //> Alternating dead/alive run lengths (starting dead) as 7-bit varints.
+static const unsigned char COMPRESS_BITMAP = 1; //> One bit per cell, used when runs would take more space.
+
+// Read a run length of compressed runs at data[i], moving i past it.
+static inline size_t readCompressedRun(const std::vector<unsigned char>& data, size_t& i)
+{
+	size_t run = 0;
+	int shift = 0;
+	unsigned char b;
+	do
+	{
+		b = data[i++];
+		run |= static_cast<size_t>(b & 0x7F) << shift;
+		shift += 7;
+	} while ((b & 0x80) && i < data.size());
+	return run;
+}
+
+// Visit index of each alive cell in compressed cells, in ascending order.
+template<class F>
+static void forEachCompressedCell(const std::vector<unsigned char>& data, F fn)
+{
+	if (data.empty())
+		return;
+
+	if (data[0] == COMPRESS_BITMAP)
+	{
+		for (size_t i = 1; i < data.size(); i++)
+			for (size_t bit = 0; bit < 8; bit++)
+				if ((data[i] >> bit) & 1)
+					fn((i - 1) * 8 + bit);
+		return;
+	}
+
+	size_t idx = 0;
+	bool alive = false;
+	for (size_t i = 1; i < data.size(); alive = !alive)
+	{
+		const size_t run = readCompressedRun(data, i);
+		if (alive)
+			for (size_t k = 0; k < run; k++)
+				fn(idx + k);
+		idx += run;
+	}
+}
+
+// Get alive state of the cell at an index of compressed cells, decoding runs only up to it.
+static bool isCompressedCellAlive(const std::vector<unsigned char>& data, size_t target)
+{
+	if (data.empty())
+		return false;
+
+	if (data[0] == COMPRESS_BITMAP)
+	{
+		const size_t i = 1 + target / 8;
+		return i < data.size() && ((data[i] >> (target % 8)) & 1);
+	}
+
+	size_t idx = 0;
+	bool alive = false;
+	for (size_t i = 1; i < data.size(); alive = !alive)
+	{
+		idx += readCompressedRun(data, i);
+		if (target < idx)
+			return alive;
+	}
+	return false;
+}
 
 
 //////////////////////////////////////////////////////////////////////
 Chunk::Chunk(Simulation* sim, int col, int row)
-	: m_sim(sim)
-	, m_uid(NEXT_UNIQUE_ID++)
+	: m_uid(NEXT_UNIQUE_ID++)
+	, m_sim(sim)
 	, m_cells(nullptr)
 	, m_aliveCells(0)
+	, m_births(0)
+	, m_deaths(0)
+	, m_cellCoordsInvalid(false)
+	, m_densityVersion(0)
+	, m_inactivity(0)
+	, m_sleepSteps(0)
+	, m_version(0)
+	, m_borderChanged(false)
+	, m_sleepMode(Sleeping)
+	, m_representation(Sparse)
+	, m_pageSlot(-1)
+	, m_cellHash(0)
+	, m_cellCheck(0)
+	, m_stateHashCount(0)
+	, m_period(0)
+	, m_phase(0)
 	, m_column(col)
 	, m_row(row)
-	, m_sleepMode(Sleeping)
-	, m_inactivity(0)
 	, m_north(nullptr)
 	, m_east(nullptr)
 	, m_south(nullptr)
 	, m_west(nullptr)
-	, m_births(0)
-	, m_deaths(0)
-	, m_borderChanged(false)
-	, m_cellCoordsInvalid(false)
 {
+	std::fill(m_borderFlips, m_borderFlips + EDGE_COUNT, 0);
+
 	if (sim == nullptr)
 		return;
 
-	// Build cell graph
-	if ((m_cells = new char[CHUNK_SIZE * CHUNK_SIZE]) == nullptr)
-	{
-		std::cerr << "chunk could not allocate cell graph! out of memory? ("
-		          << "uid=" << m_uid << ", "
-		          << "column=" << m_column << ", "
-		          << "row=" << m_row << ")"
-		          << std::endl;
-	}
-
-	// Zero all cells
-	this->clear();
-
-	m_cellCoords.reserve(CHUNK_SIZE);
+	// Cell graph is allocated on the first birth, see allocateCells()
 
 	// Find and update neighbours of ourself
 	if (m_north = sim->getChunk(col, row - 1))
@@ -103,30 +187,372 @@ Chunk::~Chunk()
 		m_west->m_east   = nullptr;
 
 	// Destroy cell graph
+	this->releaseCells();
+
+	// Free slot in the backing file
+	if (this->isPaged())
+		m_sim->getChunkPager().release(m_pageSlot);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::allocateCells()
+{
+	if (m_cells != nullptr)
+		return;
+
+	// Build cell graph
+	if ((m_cells = new char[CHUNK_SIZE * CHUNK_SIZE]) == nullptr)
+	{
+		std::cerr << "chunk could not allocate cell graph! out of memory? ("
+		          << "uid=" << m_uid << ", "
+		          << "column=" << m_column << ", "
+		          << "row=" << m_row << ")"
+		          << std::endl;
+		return;
+	}
+
+	// Zero all cells
+	for (size_t i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++)
+		GOL_RESET_CELL(m_cells[i]);
+
+	m_cellCoords.reserve(CHUNK_SIZE);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::releaseCells()
+{
+	// Cells are expected to be dead, or compressed
 	if (m_cells != nullptr)
 	{
 		delete[] m_cells;
 		m_cells = nullptr;
 	}
+
+	std::vector<std::pair<int,int>>().swap(m_cellCoords);
+	m_cellCoordsInvalid = false;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::compressCells()
+{
+	if ((m_sleepMode != Sleeping && m_sleepMode != Periodic) || m_sleepSteps < COMPRESS_SLEEP_STEPS)
+		return;
+
+	if (m_sleepMode == Periodic && m_cells != nullptr)
+	{
+		// Recorded phases already hold every cell, the table is not needed while replaying them
+		this->releaseCells();
+		m_cellCoordsInvalid = true;
+		return;
+	}
+
+	if (m_cells == nullptr)
+	{
+		// Already compressed (or empty), drop the alive cell list if it was rebuilt since
+		if (m_cellCoords.capacity() > 0)
+		{
+			std::vector<std::pair<int,int>>().swap(m_cellCoords);
+			m_cellCoordsInvalid = true;
+		}
+		return;
+	}
+
+	CompressedCells compressed;
+	this->encodeCells(compressed);
+
+	// Share the buffer with identical chunks
+	m_compressed = m_sim->getChunkStore().intern(std::move(compressed));
+
+	this->releaseCells();
+	m_cellCoordsInvalid = true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::encodeCells(CompressedCells& out_compressed) const
+{
+	// Neighbouring chunks keep reading edges, keep them uncompressed
+	for (int edge = 0; edge < EDGE_COUNT; edge++)
+		out_compressed.edges[edge] = this->readEdge(edge);
+
+	// Encode run lengths of dead and alive cells
+	std::vector<unsigned char>& data = out_compressed.data;
+	data.clear();
+	data.push_back(COMPRESS_RUNS);
+	bool alive = false;
+	size_t run = 0;
+	for (size_t idx = 0; idx < CHUNK_SIZE * CHUNK_SIZE; idx++, run++)
+	{
+		if (GOL_IS_CELL_ALIVE(m_cells[idx]) == alive)
+			continue;
+		for (; run >= 0x80; run >>= 7)
+			data.push_back(static_cast<unsigned char>(run & 0x7F) | 0x80);
+		data.push_back(static_cast<unsigned char>(run));
+		alive = !alive;
+		run = 0;
+	}
+	if (alive)
+	{
+		// Trailing dead run is implied, trailing alive run is not
+		for (; run >= 0x80; run >>= 7)
+			data.push_back(static_cast<unsigned char>(run & 0x7F) | 0x80);
+		data.push_back(static_cast<unsigned char>(run));
+	}
+
+	// Busy patterns pack better as a bitmap
+	const size_t BITMAP_BYTES = 1 + CHUNK_SIZE * CHUNK_SIZE / 8;
+	if (data.size() > BITMAP_BYTES)
+	{
+		data.assign(BITMAP_BYTES, 0);
+		data[0] = COMPRESS_BITMAP;
+		for (size_t idx = 0; idx < CHUNK_SIZE * CHUNK_SIZE; idx++)
+			if (GOL_IS_CELL_ALIVE(m_cells[idx]))
+				data[1 + idx / 8] |= static_cast<unsigned char>(1 << (idx % 8));
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::pageOut()
+{
+	if (m_sleepMode != Sleeping || this->isPaged())
+		return;
+
+	CompressedCells compressed;
+	if (m_compressed != nullptr)
+		compressed = *m_compressed;
+	else if (m_cells != nullptr)
+		this->encodeCells(compressed);
+	else
+		return;
+
+	// Keep cells in memory if they could not be written
+	int64_t slot = m_sim->getChunkPager().pageOut(compressed.data);
+	if (slot < 0)
+		return;
+
+	std::copy(compressed.edges, compressed.edges + EDGE_COUNT, m_pagedEdges);
+	m_pageSlot = slot;
+	m_compressed.reset();
+	this->releaseCells();
+	std::vector<std::pair<int,int>>().swap(m_cellCoords);
+	m_cellCoordsInvalid = true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Chunk::decompressCells()
+{
+	const int size = static_cast<int>(CHUNK_SIZE);
+
+	m_sleepSteps = 0;
+
+	if (!this->isCompressed())
+		return true;
+
+	// Page cells back in from the backing file first, the slot is kept if they could not be read
+	std::vector<unsigned char> paged;
+	if (this->isPaged() && !m_sim->getChunkPager().pageIn(m_pageSlot, paged))
+		return false;
+
+	const uint64_t* phaseCells = this->getPhaseCells();
+	this->allocateCells();
+	if (m_cells == nullptr)
+		return false;
+
+	if (phaseCells != nullptr)
+	{
+		// Cells of the current phase
+		for (int y = 0; y < size; y++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				if ((phaseCells[y] >> x) & 1)
+				{
+					char& cell = m_cells[cellCoords2Index(x, y)];
+					GOL_SET_CELL_ALIVE(cell, true);
+					GOL_SET_CELL_ALIVE_NEXTGEN(cell, true);
+				}
+			}
+		}
+	}
+	else
+	{
+		auto restoreCell = [this](size_t idx) {
+			GOL_SET_CELL_ALIVE(m_cells[idx], true);
+			GOL_SET_CELL_ALIVE_NEXTGEN(m_cells[idx], true);
+		};
+		if (this->isPaged())
+		{
+			forEachCompressedCell(paged, restoreCell);
+			m_pageSlot = -1;
+		}
+		else
+		{
+			// Copy out of the shared buffer, the chunk owns its cells again
+			forEachCompressedCell(m_compressed->data, restoreCell);
+			m_compressed.reset();
+		}
+	}
+	m_cellCoordsInvalid = true;
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::checkCompressedPhase()
+{
+	if (this->getPhaseCells() == nullptr)
+		return;
+
+	uint64_t halo[HALO_WORDS];
+	this->readHalo(halo);
+	if (!std::equal(halo, halo + HALO_WORDS, m_phases[m_phase].halo))
+		this->decompressCells();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Chunk::getCompressedCell(int x, int y) const
+{
+	const uint64_t* phaseCells = this->getPhaseCells();
+	if (phaseCells != nullptr)
+		return (phaseCells[y] >> x) & 1;
+
+	const int last = CHUNK_SIZE - 1;
+	const uint64_t* edges = this->getCompressedEdges();
+	if (y == 0)
+		return (edges[EdgeNorth] >> x) & 1;
+	if (y == last)
+		return (edges[EdgeSouth] >> x) & 1;
+	if (x == 0)
+		return (edges[EdgeWest] >> y) & 1;
+	if (x == last)
+		return (edges[EdgeEast] >> y) & 1;
+
+	std::vector<unsigned char> buffer;
+	const std::vector<unsigned char>* data = this->getCompressedData(buffer);
+	if (data == nullptr)
+		return false;
+
+	return isCompressedCellAlive(*data, cellCoords2Index(x, y));
+}
+
+
+//////////////////////////////////////////////////////////////////////
+const std::vector<unsigned char>* Chunk::getCompressedData(std::vector<unsigned char>& buffer) const
+{
+	if (m_compressed != nullptr)
+		return &m_compressed->data;
+	if (!this->isPaged())
+		return nullptr;
+
+	// Read without paging in, the chunk is still sleeping
+	m_sim->getChunkPager().read(m_pageSlot, buffer);
+	return &buffer;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+uint64_t Chunk::readEdge(int edge) const
+{
+	const int size = static_cast<int>(CHUNK_SIZE);
+	const int last = size - 1;
+	uint64_t bits = 0;
+
+	const uint64_t* phaseCells = this->getPhaseCells();
+	if (phaseCells != nullptr)
+	{
+		if (edge == EdgeNorth)
+			return phaseCells[0];
+		if (edge == EdgeSouth)
+			return phaseCells[last];
+		for (int i = 0; i < size; i++)
+			bits |= ((phaseCells[i] >> (edge == EdgeWest ? 0 : last)) & 1) << i;
+		return bits;
+	}
+
+	if (m_cells == nullptr)
+		return this->isCompressed() ? this->getCompressedEdges()[edge] : 0;
+
+	for (int i = 0; i < size; i++)
+	{
+		size_t idx;
+		switch (edge)
+		{
+		case EdgeNorth: idx = cellCoords2Index(i, 0);    break;
+		case EdgeSouth: idx = cellCoords2Index(i, last); break;
+		case EdgeWest:  idx = cellCoords2Index(0, i);    break;
+		default:        idx = cellCoords2Index(last, i); break;
+		}
+		if (GOL_IS_CELL_ALIVE(m_cells[idx]))
+			bits |= uint64_t(1) << i;
+	}
+	return bits;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+size_t Chunk::getResidentBytes() const
+{
+	size_t bytes = m_cellCoords.capacity() * sizeof(std::pair<int,int>);
+	if (m_cells != nullptr)
+		bytes += CHUNK_SIZE * CHUNK_SIZE + m_phases.capacity() * sizeof(PeriodicPhase);
+	return bytes;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+size_t Chunk::getCompressedBytes() const
+{
+	if (this->getPhaseCells() != nullptr)
+		return m_phases.capacity() * sizeof(PeriodicPhase);
+	return 0;
 }
 
 
 //////////////////////////////////////////////////////////////////////
 void Chunk::clear()
 {
+	m_version++;
+
+	if (this->isCompressed())
+	{
+		m_compressed.reset();
+		if (this->isPaged())
+			m_sim->getChunkPager().release(m_pageSlot);
+		m_pageSlot = -1;
+		m_cellCoordsInvalid = true;
+	}
+
 	if (m_cells == nullptr)
+	{
+		m_aliveCells = 0;
+		m_cellHash = 0;
+		m_cellCheck = 0;
+		std::vector<PeriodicPhase>().swap(m_phases);
+		this->resetPeriodicity();
 		return;
+	}
 
 	for (size_t i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++)
 		GOL_RESET_CELL(m_cells[i]);
 
 	m_aliveCells = 0;
+	m_cellHash = 0;
+	m_cellCheck = 0;
+	this->resetPeriodicity();
 }
 
 
 //////////////////////////////////////////////////////////////////////
 void Chunk::updateCellStates()
 {
+	const int size = static_cast<int>(CHUNK_SIZE);
+
 	if (!this->isValid())
 		return;
 
@@ -136,17 +562,76 @@ void Chunk::updateCellStates()
 	// Determines if border cells have changed since last update
 	bool borderChanged = false;
 
-	if (m_sleepMode != Sleeping)
+	// Hash current state, and look for oscillating patterns
+	uint64_t halo[HALO_WORDS];
+	uint64_t stateHash = 0;
+	uint64_t stateCheck = 0;
+	if (m_sleepMode == Sleeping)
+		this->resetPeriodicity();
+	else if (m_sleepMode != Periodic)
+	{
+		this->readHalo(halo);
+		this->getStateHash(halo, stateHash, stateCheck);
+		this->checkPeriodicity(halo, stateHash);
+	}
+
+	if (m_sleepMode == Periodic)
+	{
+		// Performance optimization
+		// Replay the cached phase instead of visiting any cells
+		if (this->updatePeriodicCellStates(births, deaths, borderChanged))
+		{
+			m_borderChanged = borderChanged;
+			m_births = births;
+			m_deaths = deaths;
+			return;
+		}
+
+		// Bordering cells no longer match the cycle, fully wake up
+		this->resetPeriodicity();
+		m_sleepMode = Awake;
+		this->readHalo(halo);
+		this->getStateHash(halo, stateHash, stateCheck);
+	}
+
+	if (m_sleepMode != Sleeping && (m_representation == Sparse || m_cells == nullptr))
+	{
+		// Performance optimization
+		// Only visit cells which may change when the chunk is sparsely populated
+		this->updateSparseCellStates(births, deaths, borderChanged);
+	}
+	else if (m_sleepMode != Sleeping)
 	{
+		// Performance optimization
+		// Fully awake dense chunks may have been in the same state as another chunk before,
+		// look up the changes that state leads to instead of visiting every cell
+		ChunkMemo& memo = m_sim->getChunkMemo();
+		static thread_local Transition memoTransition;
+		bool memoize = (m_sleepMode == Awake && memo.isEnabled());
+		if (memoize)
+		{
+			if (memo.lookup(stateHash, stateCheck, memoTransition))
+			{
+				for (unsigned short idx : memoTransition.changedCells)
+					this->flipCellNextGen(idx);
+
+				m_borderChanged = memoTransition.borderChanged;
+				m_births = memoTransition.births;
+				m_deaths = memoTransition.deaths;
+				return;
+			}
+			memoTransition.changedCells.clear();
+		}
+
 		const Ruleset& ruleset = this->getSimulation()->getRuleset();
 		size_t idx = 0;
 
-		for (int y = 0; y < CHUNK_SIZE; y++)
+		for (int y = 0; y < size; y++)
 		{
 			// True if cell borders east/west
 			bool yEdge = (y == 0 || y == CHUNK_SIZE - 1);
 
-			for (int x = 0; x < CHUNK_SIZE; x++, idx++)
+			for (int x = 0; x < size; x++, idx++)
 			{
 				// True if cell borders north/south
 				bool xEdge = (x == 0 || x == CHUNK_SIZE - 1);
@@ -185,8 +670,10 @@ void Chunk::updateCellStates()
 					if (!ruleset.testSurvival(neighbours))
 					{
 						// Died
-						GOL_SET_CELL_ALIVE_NEXTGEN(cell, false);
+						this->flipCellNextGen(idx);
 						deaths++;
+						if (memoize)
+							memoTransition.changedCells.push_back(static_cast<unsigned short>(idx));
 
 						// Set borderChanged true if a border cell changed
 						borderChanged = borderChanged || xEdge || yEdge;
@@ -198,8 +685,10 @@ void Chunk::updateCellStates()
 					if (ruleset.testBirth(neighbours))
 					{
 						// Born
-						GOL_SET_CELL_ALIVE_NEXTGEN(cell, true);
+						this->flipCellNextGen(idx);
 						births++;
+						if (memoize)
+							memoTransition.changedCells.push_back(static_cast<unsigned short>(idx));
 
 						// Set borderChanged true if a border cell changed
 						borderChanged = borderChanged || xEdge || yEdge;
@@ -207,6 +696,14 @@ void Chunk::updateCellStates()
 				}
 			} // for x
 		} // for y
+
+		if (memoize)
+		{
+			memoTransition.births = births;
+			memoTransition.deaths = deaths;
+			memoTransition.borderChanged = borderChanged;
+			memo.insert(stateHash, stateCheck, memoTransition);
+		}
 	} // if (m_sleepMode != Sleeping)
 
 	m_borderChanged = borderChanged;
@@ -216,13 +713,101 @@ void Chunk::updateCellStates()
 	m_deaths = deaths;
 }
 
+//////////////////////////////////////////////////////////////////////
+inline void Chunk::flipCellNextGen(size_t idx)
+{
+	const size_t x = idx % CHUNK_SIZE;
+	const size_t y = idx / CHUNK_SIZE;
+	if (x == 0)
+		m_borderFlips[EdgeWest] |= uint64_t(1) << y;
+	else if (x == CHUNK_SIZE - 1)
+		m_borderFlips[EdgeEast] |= uint64_t(1) << y;
+	else if (y == 0)
+		m_borderFlips[EdgeNorth] |= uint64_t(1) << x;
+	else if (y == CHUNK_SIZE - 1)
+		m_borderFlips[EdgeSouth] |= uint64_t(1) << x;
+	else
+		GOL_SET_CELL_ALIVE_NEXTGEN(m_cells[idx], !GOL_IS_CELL_ALIVE(m_cells[idx]));
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::applyBorderFlips()
+{
+	const int last = static_cast<int>(CHUNK_SIZE) - 1;
+	for (int edge = 0; edge < EDGE_COUNT; edge++)
+	{
+		uint64_t flips = m_borderFlips[edge];
+		for (int i = 0; flips != 0; i++, flips >>= 1)
+		{
+			if ((flips & 1) == 0)
+				continue;
+
+			size_t idx;
+			switch (edge)
+			{
+			case EdgeNorth: idx = cellCoords2Index(i, 0);    break;
+			case EdgeSouth: idx = cellCoords2Index(i, last); break;
+			case EdgeWest:  idx = cellCoords2Index(0, i);    break;
+			default:        idx = cellCoords2Index(last, i); break;
+			}
+			GOL_SET_CELL_ALIVE_NEXTGEN(m_cells[idx], !GOL_IS_CELL_ALIVE(m_cells[idx]));
+		}
+		m_borderFlips[edge] = 0;
+	}
+}
+
+
 //////////////////////////////////////////////////////////////////////
 void Chunk::applyCellStates()
 {
+	const int size = static_cast<int>(CHUNK_SIZE);
+
 	if (!this->isValid())
 		return;
 
 	if (m_births > 0 || m_deaths > 0)
+		m_version++;
+
+	this->applyBorderFlips();
+
+	if (m_sleepMode == Periodic)
+	{
+		// Population may or may not have changed...
+		m_aliveCells += m_births;
+		m_aliveCells -= m_deaths;
+
+		// Step cells that changed going to the next phase, stay periodic
+		this->applySparseCellStates(m_phases[m_phase].changedCells);
+		m_phase = (m_phase + 1) % m_period;
+		m_sleepSteps++;
+
+		this->checkInactivity();
+		return;
+	}
+	else if ((m_births > 0 || m_deaths > 0) && (m_representation == Sparse || m_cells == nullptr))
+	{
+		// Population has changed...
+		m_aliveCells += m_births;
+		m_aliveCells -= m_deaths;
+
+		// First births, allocate cell storage now
+		// Cells could not be marked as born while updating, as neighbouring chunks may have been reading them
+		if (m_cells == nullptr)
+		{
+			this->allocateCells();
+			for (unsigned short idx : m_sparseChangedCells)
+				GOL_SET_CELL_ALIVE_NEXTGEN(m_cells[idx], true);
+		}
+
+		// Only step cells that changed
+		this->applySparseCellStates(m_sparseChangedCells);
+		m_sparseChangedCells.clear();
+
+		// Fully awake for next step
+		m_sleepMode = Awake;
+	}
+	else if (m_births > 0 || m_deaths > 0)
 	{
 		// Population has changed...
 		m_aliveCells += m_births;
@@ -232,11 +817,16 @@ void Chunk::applyCellStates()
 
 		// Update all cells to their next generation states
 		size_t idx = 0;
-		for (int y = 0; y < CHUNK_SIZE; y++)
+		for (int y = 0; y < size; y++)
 		{
-			for (int x = 0; x < CHUNK_SIZE; x++, idx++)
+			for (int x = 0; x < size; x++, idx++)
 			{
 				char& cell = m_cells[idx];
+				if (GOL_IS_CELL_ALIVE(cell) != GOL_IS_CELL_ALIVE_NEXTGEN(cell))
+				{
+					m_cellHash ^= hashCell(idx);
+					m_cellCheck ^= hashCell(idx, CHECK_SEED);
+				}
 				if (GOL_STEP_CELL(cell))
 					m_cellCoords.emplace_back(x, y);
 			}
@@ -275,41 +865,486 @@ void Chunk::applyCellStates()
 			m_sleepMode = Sleeping;
 	}
 
+	// Count steps spent sleeping, cells are needed again once woken up
+	// Chunks whose cells could not be paged back in sleep on rather than lose them
+	if (m_sleepMode != Sleeping && !this->decompressCells())
+		m_sleepMode = Sleeping;
+	if (m_sleepMode == Sleeping)
+		m_sleepSteps++;
+
+	// Switch representation when population crosses thresholds
+	// Thresholds are spaced apart to avoid switching back and forth on small changes
+	if (m_representation == Dense && m_aliveCells <= SPARSE_ENTER_POPULATION)
+		m_representation = Sparse;
+	else if (m_representation == Sparse && m_aliveCells > SPARSE_EXIT_POPULATION)
+		m_representation = Dense;
+
+	// Empty chunks with nothing happening around them do not need cell storage
+	if (m_aliveCells == 0 && m_sleepMode == Sleeping && m_cells != nullptr)
+		this->releaseCells();
+
 	this->checkInactivity();
 }
 
 
 //////////////////////////////////////////////////////////////////////
-void Chunk::setCell(int x, int y, bool alive)
+void Chunk::updateSparseCellStates(int& births, int& deaths, bool& borderChanged)
 {
-	if (m_cells == nullptr)
+	const int size = static_cast<int>(CHUNK_SIZE);
+
+	m_sparseChangedCells.clear();
+
+	// Alive cells and their neighbours
+	// When BorderOnly, interior cells are unchanged and can be skipped
+	const bool borderOnly = (m_sleepMode == BorderOnly);
+	for (const std::pair<int, int>& xy : this->getCellCoords())
+	{
+		for (int y = std::max(0, xy.second - 1); y <= std::min<int>(CHUNK_SIZE - 1, xy.second + 1); y++)
+		{
+			bool yEdge = (y == 0 || y == CHUNK_SIZE - 1);
+			for (int x = std::max(0, xy.first - 1); x <= std::min<int>(CHUNK_SIZE - 1, xy.first + 1); x++)
+			{
+				bool xEdge = (x == 0 || x == CHUNK_SIZE - 1);
+				if (borderOnly && !xEdge && !yEdge)
+					continue;
+				this->updateSparseCell(x, y, births, deaths, borderChanged);
+			}
+		}
+	}
+
+	// Border cells next to populated neighbour chunks
+	const int last = CHUNK_SIZE - 1;
+	const Chunk* c;
+	if (m_north && m_north->m_aliveCells != 0)
+		for (int x = 0; x < size; x++)
+			this->updateSparseCell(x, 0, births, deaths, borderChanged);
+	if (m_south && m_south->m_aliveCells != 0)
+		for (int x = 0; x < size; x++)
+			this->updateSparseCell(x, last, births, deaths, borderChanged);
+	if (m_west && m_west->m_aliveCells != 0)
+		for (int y = 0; y < size; y++)
+			this->updateSparseCell(0, y, births, deaths, borderChanged);
+	if (m_east && m_east->m_aliveCells != 0)
+		for (int y = 0; y < size; y++)
+			this->updateSparseCell(last, y, births, deaths, borderChanged);
+	if ((c = this->getNeighbour(NorthWest)) && c->m_aliveCells != 0)
+		this->updateSparseCell(0, 0, births, deaths, borderChanged);
+	if ((c = this->getNeighbour(NorthEast)) && c->m_aliveCells != 0)
+		this->updateSparseCell(last, 0, births, deaths, borderChanged);
+	if ((c = this->getNeighbour(SouthWest)) && c->m_aliveCells != 0)
+		this->updateSparseCell(0, last, births, deaths, borderChanged);
+	if ((c = this->getNeighbour(SouthEast)) && c->m_aliveCells != 0)
+		this->updateSparseCell(last, last, births, deaths, borderChanged);
+
+	// Reset visited cells for next update
+	SparseVisited& visited = sparseVisited;
+	for (size_t i = 0; i < visited.count; i++)
+		visited.cells.reset(visited.list[i]);
+	visited.count = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::updateSparseCell(int x, int y, int& births, int& deaths, bool& borderChanged)
+{
+	size_t idx = cellCoords2Index(x, y);
+
+	// Visit each cell only once
+	SparseVisited& visited = sparseVisited;
+	if (visited.cells.test(idx))
 		return;
+	visited.cells.set(idx);
+	visited.list[visited.count++] = static_cast<unsigned short>(idx);
+
+	bool edge = (x == 0 || y == 0 || x == CHUNK_SIZE - 1 || y == CHUNK_SIZE - 1);
+	int neighbours;
 
-	if (x < 0 || x >= CHUNK_SIZE)
-		x %= CHUNK_SIZE;
-	if (y < 0 || y >= CHUNK_SIZE)
-		y %= CHUNK_SIZE;
+	if (edge)
+	{
+		// Cell borders another chunk...
+		neighbours = this->countActiveNeighbourCells(x, y);
+	}
+	else
+	{
+		neighbours = (GOL_IS_CELL_ALIVE(m_cells[idx -  1 - CHUNK_SIZE]) ? 1 : 0) +
+		             (GOL_IS_CELL_ALIVE(m_cells[idx -  1])              ? 1 : 0) +
+		             (GOL_IS_CELL_ALIVE(m_cells[idx -  1 + CHUNK_SIZE]) ? 1 : 0) +
+		             (GOL_IS_CELL_ALIVE(m_cells[idx -      CHUNK_SIZE]) ? 1 : 0) +
+		             (GOL_IS_CELL_ALIVE(m_cells[idx +      CHUNK_SIZE]) ? 1 : 0) +
+		             (GOL_IS_CELL_ALIVE(m_cells[idx +  1 - CHUNK_SIZE]) ? 1 : 0) +
+		             (GOL_IS_CELL_ALIVE(m_cells[idx +  1])              ? 1 : 0) +
+		             (GOL_IS_CELL_ALIVE(m_cells[idx +  1 + CHUNK_SIZE]) ? 1 : 0);
+	}
 
-	char& cell = m_cells[cellCoords2Index(x, y)];
+	const Ruleset& ruleset = this->getSimulation()->getRuleset();
+
+	if (m_cells == nullptr)
+	{
+		// No cell storage yet, every cell is dead
+		// The birth is only recorded, storage is allocated once it is applied
+		if (!ruleset.testBirth(neighbours))
+			return;
+
+		// Born
+		births++;
+		m_sparseChangedCells.push_back(static_cast<unsigned short>(idx));
+		borderChanged = borderChanged || edge;
+		return;
+	}
+
+	char& cell = m_cells[idx];
 
-	// Modify active cell counts for this chunk
 	if (GOL_IS_CELL_ALIVE(cell))
 	{
-		if (!alive)
+		if (ruleset.testSurvival(neighbours))
+			return;
+
+		// Died
+		this->flipCellNextGen(idx);
+		deaths++;
+	}
+	else
+	{
+		if (!ruleset.testBirth(neighbours))
+			return;
+
+		// Born
+		this->flipCellNextGen(idx);
+		births++;
+	}
+
+	m_sparseChangedCells.push_back(static_cast<unsigned short>(idx));
+	borderChanged = borderChanged || edge;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::applySparseCellStates(const std::vector<unsigned short>& changedCells)
+{
+	if (m_cells == nullptr)
+	{
+		// Compressed chunk in periodic sleep, cells are read from the next phase
+		for (unsigned short idx : changedCells)
 		{
-			m_aliveCells--;
-			m_sleepMode = Awake;
+			m_cellHash ^= hashCell(idx);
+			m_cellCheck ^= hashCell(idx, CHECK_SEED);
+		}
+		if (!changedCells.empty())
 			m_cellCoordsInvalid = true;
+		return;
+	}
+
+	// Make sure alive cell list is up to date before patching it
+	this->getCellCoords();
+
+	// Step changed cells to their next generation states
+	for (unsigned short idx : changedCells)
+	{
+		GOL_STEP_CELL(m_cells[idx]);
+		m_cellHash ^= hashCell(idx);
+		m_cellCheck ^= hashCell(idx, CHECK_SEED);
+	}
+
+	// Drop cells that died from the alive cell list, then add cells that were born
+	size_t n = 0;
+	for (size_t i = 0; i < m_cellCoords.size(); i++)
+	{
+		const std::pair<int, int>& xy = m_cellCoords[i];
+		if (GOL_IS_CELL_ALIVE(m_cells[cellCoords2Index(xy.first, xy.second)]))
+			m_cellCoords[n++] = xy;
+	}
+	m_cellCoords.resize(n);
+
+	for (unsigned short idx : changedCells)
+	{
+		if (GOL_IS_CELL_ALIVE(m_cells[idx]))
+		{
+			int x, y;
+			cellIndex2Coords(idx, x, y);
+			m_cellCoords.emplace_back(x, y);
 		}
 	}
-	else
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::checkPeriodicity(const uint64_t halo[HALO_WORDS], uint64_t stateHash)
+{
+	const int size = static_cast<int>(CHUNK_SIZE);
+
+	if (m_period == 0)
 	{
-		if (alive)
+		// Not yet periodic, record this generation's state hash
+		const unsigned int HISTORY = MAX_PERIOD * 2;
+		if (!m_stateHashes)
+			m_stateHashes.reset(new uint64_t[HISTORY]);
+		m_stateHashes[m_stateHashCount % HISTORY] = stateHash;
+		m_stateHashCount++;
+
+		// Find shortest period where the last two cycles match
+		unsigned int period = 0;
+		for (unsigned int p = 1; p <= MAX_PERIOD && 2 * p <= m_stateHashCount; p++)
 		{
-			m_aliveCells++;
-			m_sleepMode = Awake;
-			m_cellCoordsInvalid = true;
+			bool repeats = true;
+			for (unsigned int i = 0; i < p && repeats; i++)
+			{
+				unsigned int gen = m_stateHashCount - 1 - i;
+				repeats = (m_stateHashes[gen % HISTORY] == m_stateHashes[(gen - p) % HISTORY]);
+			}
+			if (repeats)
+			{
+				period = p;
+				break;
+			}
+		}
+
+		// Period 1 is a still life, which is already handled by Sleeping
+		if (period < 2)
+			return;
+
+		// Likely periodic, record phases over the next cycle
+		m_period = period;
+		m_stateHashes.reset();
+		m_phases.reserve(period);
+	}
+
+	if (m_phases.size() < m_period)
+	{
+		// Record current generation as the next phase
+		m_phases.emplace_back();
+		PeriodicPhase& phase = m_phases.back();
+		this->packCells(phase.cells);
+		for (size_t i = 0; i < HALO_WORDS; i++)
+			phase.halo[i] = halo[i];
+		return;
+	}
+
+	// One full cycle has been recorded, confirm the first phase has come around again
+	const PeriodicPhase& first = m_phases.front();
+	uint64_t cells[CHUNK_SIZE];
+	this->packCells(cells);
+	if (!std::equal(halo, halo + HALO_WORDS, first.halo) || !std::equal(cells, cells + CHUNK_SIZE, first.cells))
+	{
+		this->resetPeriodicity();
+		return;
+	}
+
+	// If every phase is identical the chunk is really still, leave it to the regular sleep modes so it can be freed
+	bool still = true;
+	for (unsigned int p = 1; p < m_period && still; p++)
+	{
+		still = std::equal(first.cells, first.cells + CHUNK_SIZE, m_phases[p].cells)
+			&& std::equal(first.halo, first.halo + HALO_WORDS, m_phases[p].halo);
+	}
+	if (still)
+	{
+		this->resetPeriodicity();
+		return;
+	}
+
+	// Precompute which cells change between each phase and the next
+	for (unsigned int p = 0; p < m_period; p++)
+	{
+		PeriodicPhase& phase = m_phases[p];
+		const PeriodicPhase& next = m_phases[(p + 1) % m_period];
+		phase.births = 0;
+		phase.deaths = 0;
+		phase.borderChanged = false;
+		for (int y = 0; y < size; y++)
+		{
+			uint64_t changed = phase.cells[y] ^ next.cells[y];
+			for (int x = 0; changed != 0; x++, changed >>= 1)
+			{
+				if ((changed & 1) == 0)
+					continue;
+				phase.changedCells.push_back(static_cast<unsigned short>(cellCoords2Index(x, y)));
+				if ((next.cells[y] >> x) & 1)
+					phase.births++;
+				else
+					phase.deaths++;
+				phase.borderChanged = phase.borderChanged || x == 0 || y == 0 || x == CHUNK_SIZE - 1 || y == CHUNK_SIZE - 1;
+			}
+		}
+	}
+
+	m_phase = 0;
+	m_sleepMode = Periodic;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Chunk::updatePeriodicCellStates(int& births, int& deaths, bool& borderChanged)
+{
+	const PeriodicPhase& phase = m_phases[m_phase];
+
+	// Cycle only holds while bordering cells follow it too
+	// (Compressed chunks have been checked already, see checkCompressedPhase())
+	if (m_cells != nullptr)
+	{
+		uint64_t halo[HALO_WORDS];
+		this->readHalo(halo);
+		if (!std::equal(halo, halo + HALO_WORDS, phase.halo))
+			return false;
+
+		for (unsigned short idx : phase.changedCells)
+			this->flipCellNextGen(idx);
+	}
+
+	births = phase.births;
+	deaths = phase.deaths;
+	borderChanged = phase.borderChanged;
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::resetPeriodicity()
+{
+	// Compressed cells are held by the recorded phases, restore them first
+	if (this->getPhaseCells() != nullptr && !this->decompressCells())
+		return;
+
+	m_stateHashes.reset();
+	m_stateHashCount = 0;
+	m_period = 0;
+	m_phase = 0;
+	if (!m_phases.empty())
+		std::vector<PeriodicPhase>().swap(m_phases);
+	if (m_sleepMode == Periodic)
+		m_sleepMode = Awake;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::readHalo(uint64_t out_halo[HALO_WORDS]) const
+{
+	const int last = CHUNK_SIZE - 1;
+	const Chunk* c;
+	out_halo[0] = m_north ? m_north->readEdge(EdgeSouth) : 0;
+	out_halo[1] = m_south ? m_south->readEdge(EdgeNorth) : 0;
+	out_halo[2] = m_west  ? m_west->readEdge(EdgeEast)   : 0;
+	out_halo[3] = m_east  ? m_east->readEdge(EdgeWest)   : 0;
+	out_halo[4] = 0;
+	if ((c = this->getNeighbour(NorthWest)) && c->getCell(last, last))
+		out_halo[4] |= 0x1;
+	if ((c = this->getNeighbour(NorthEast)) && c->getCell(0, last))
+		out_halo[4] |= 0x2;
+	if ((c = this->getNeighbour(SouthWest)) && c->getCell(last, 0))
+		out_halo[4] |= 0x4;
+	if ((c = this->getNeighbour(SouthEast)) && c->getCell(0, 0))
+		out_halo[4] |= 0x8;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::packCells(uint64_t out_cells[CHUNK_SIZE]) const
+{
+	const int size = static_cast<int>(CHUNK_SIZE);
+
+	if (const uint64_t* phaseCells = this->getPhaseCells())
+	{
+		std::copy(phaseCells, phaseCells + CHUNK_SIZE, out_cells);
+		return;
+	}
+	if (m_cells == nullptr)
+	{
+		std::vector<unsigned char> buffer;
+		if (const std::vector<unsigned char>* data = this->getCompressedData(buffer))
+			unpackCells(*data, out_cells);
+		else
+			std::fill(out_cells, out_cells + CHUNK_SIZE, 0);
+		return;
+	}
+
+	// Gather the alive flags of 8 cells at a time: multiplying moves bit 0 of each (little-endian) byte into the top byte
+	static_assert(GOL_FLAG_ALIVE == 0x1, "alive flags are gathered from bit 0 of each cell");
+	const uint64_t ALIVE_FLAGS = 0x0101010101010101;
+	const uint64_t GATHER = 0x0102040810204080;
+	const char* cells = m_cells;
+	for (int y = 0; y < size; y++)
+	{
+		uint64_t row = 0;
+		for (int x = 0; x < size; x += 8, cells += 8)
+		{
+			uint64_t flags;
+			std::memcpy(&flags, cells, sizeof(flags));
+			row |= (((flags & ALIVE_FLAGS) * GATHER) >> 56) << x;
 		}
+		out_cells[y] = row;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::getStateHash(const uint64_t halo[HALO_WORDS], uint64_t& out_hash, uint64_t& out_check) const
+{
+	out_hash = m_cellHash;
+	out_check = m_cellCheck;
+	for (size_t i = 0; i < HALO_WORDS; i++)
+	{
+		out_hash ^= hashCell(halo[i] + hashCell(CHUNK_SIZE * CHUNK_SIZE + i));
+		out_check ^= hashCell(halo[i] + hashCell(CHUNK_SIZE * CHUNK_SIZE + i, CHECK_SEED), CHECK_SEED);
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+uint64_t Chunk::getPositionalHash() const
+{
+	if (m_aliveCells == 0)
+		return 0;
+	uint64_t position = (static_cast<uint64_t>(static_cast<uint32_t>(m_column)) << 32) | static_cast<uint32_t>(m_row);
+	return hashCell(m_cellHash ^ hashCell(position, CHECK_SEED));
+}
+
+
+//////////////////////////////////////////////////////////////////////
+uint64_t Chunk::hashCell(uint64_t idx, uint64_t seed)
+{
+	// splitmix64 finalizer
+	uint64_t z = (idx + 1) * 0x9E3779B97F4A7C15ull + seed;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::setCell(int x, int y, bool alive)
+{
+	// Dead cells of chunks without storage are already dead
+	if (!this->decompressCells())
+		return;
+	if (m_cells == nullptr && !alive)
+		return;
+	this->allocateCells();
+	if (m_cells == nullptr)
+		return;
+
+	// Wrap coordinates into the chunk, negative ones from its far edge
+	const int size = static_cast<int>(CHUNK_SIZE);
+	if (x < 0 || x >= size)
+		x = (x % size + size) % size;
+	if (y < 0 || y >= size)
+		y = (y % size + size) % size;
+
+	size_t idx = cellCoords2Index(x, y);
+	char& cell = m_cells[idx];
+
+	// Modify active cell counts for this chunk
+	if (GOL_IS_CELL_ALIVE(cell) != alive)
+	{
+		if (alive)
+			m_aliveCells++;
+		else
+			m_aliveCells--;
+
+		m_cellHash ^= hashCell(idx);
+		m_cellCheck ^= hashCell(idx, CHECK_SEED);
+		m_sleepMode = Awake;
+		m_cellCoordsInvalid = true;
+		m_version++;
+		this->resetPeriodicity();
 	}
 
 	// Set cell states
@@ -319,15 +1354,72 @@ void Chunk::setCell(int x, int y, bool alive)
 
 
 //////////////////////////////////////////////////////////////////////
-bool Chunk::getCell(int x, int y) const
+bool Chunk::setCells(const uint64_t cells[CHUNK_SIZE])
 {
+	const int size = static_cast<int>(CHUNK_SIZE);
+	uint64_t current[CHUNK_SIZE];
+	this->packCells(current);
+
+	uint64_t changed = 0;
+	for (int y = 0; y < size; y++)
+		changed |= current[y] ^ cells[y];
+	if (changed == 0)
+		return false;
+
+	if (!this->decompressCells())
+		return false;
+	this->allocateCells();
 	if (m_cells == nullptr)
 		return false;
 
-	if (x < 0 || x >= CHUNK_SIZE)
-		x %= CHUNK_SIZE;
-	if (y < 0 || y >= CHUNK_SIZE)
-		y %= CHUNK_SIZE;
+	// Only visit cells which change, a row at a time
+	const uint64_t borderColumns = (uint64_t(1) << (CHUNK_SIZE - 1)) | 1;
+	bool borderChanged = (current[0] != cells[0] || current[CHUNK_SIZE - 1] != cells[CHUNK_SIZE - 1]);
+	for (int y = 0; y < size; y++)
+	{
+		uint64_t diff = current[y] ^ cells[y];
+		borderChanged = borderChanged || (diff & borderColumns) != 0;
+		for (int x = 0; diff != 0; x++, diff >>= 1)
+		{
+			if ((diff & 1) == 0)
+				continue;
+
+			const size_t idx = cellCoords2Index(x, y);
+			const bool alive = ((cells[y] >> x) & 1) != 0;
+			if (alive)
+				m_aliveCells++;
+			else
+				m_aliveCells--;
+			m_cellHash ^= hashCell(idx);
+			m_cellCheck ^= hashCell(idx, CHECK_SEED);
+			GOL_SET_CELL_ALIVE(m_cells[idx], alive);
+			GOL_SET_CELL_ALIVE_NEXTGEN(m_cells[idx], alive);
+		}
+	}
+
+	m_sleepMode = Awake;
+	m_cellCoordsInvalid = true;
+	m_version++;
+	this->resetPeriodicity();
+	return borderChanged;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Chunk::getCell(int x, int y) const
+{
+	if (m_cells == nullptr && !this->isCompressed())
+		return false;
+
+	// Wrap coordinates into the chunk, negative ones from its far edge
+	const int size = static_cast<int>(CHUNK_SIZE);
+	if (x < 0 || x >= size)
+		x = (x % size + size) % size;
+	if (y < 0 || y >= size)
+		y = (y % size + size) % size;
+
+	if (m_cells == nullptr)
+		return this->getCompressedCell(x, y);
 	
 	return GOL_IS_CELL_ALIVE(m_cells[cellCoords2Index(x, y)]);
 }
@@ -336,6 +1428,7 @@ bool Chunk::getCell(int x, int y) const
 //////////////////////////////////////////////////////////////////////
 int Chunk::countActiveNeighbourCells(int x, int y)
 {
+	const int size = static_cast<int>(CHUNK_SIZE);
 	int neighbours = 0;
 
 	for (int ox = -1; ox <= 1; ox++)
@@ -353,16 +1446,16 @@ int Chunk::countActiveNeighbourCells(int x, int y)
 			{
 				if (ny < 0)
 					chunk = chunk->getNeighbour(NorthWest);
-				else if (ny >= CHUNK_SIZE)
+				else if (ny >= size)
 					chunk = chunk->getNeighbour(SouthWest);
 				else
 					chunk = chunk->getNeighbour(West);
 			}
-			else if (nx >= CHUNK_SIZE)
+			else if (nx >= size)
 			{
 				if (ny < 0)
 					chunk = chunk->getNeighbour(NorthEast);
-				else if (ny >= CHUNK_SIZE)
+				else if (ny >= size)
 					chunk = chunk->getNeighbour(SouthEast);
 				else
 					chunk = chunk->getNeighbour(East);
@@ -371,7 +1464,7 @@ int Chunk::countActiveNeighbourCells(int x, int y)
 			{
 				if (ny < 0)
 					chunk = chunk->getNeighbour(North);
-				else if (ny >= CHUNK_SIZE)
+				else if (ny >= size)
 					chunk = chunk->getNeighbour(South);
 			}
 
@@ -507,14 +1600,37 @@ const Chunk* Chunk::getNeighbour(ENeighbour direction) const
 //////////////////////////////////////////////////////////////////////
 const std::vector<std::pair<int, int>>& Chunk::getCellCoords() const
 {
+	const int size = static_cast<int>(CHUNK_SIZE);
+
 	if (m_cellCoordsInvalid)
 	{
 		m_cellCoords.clear();
 		m_cellCoordsInvalid = false;
+		if (const uint64_t* phaseCells = this->getPhaseCells())
+		{
+			// Read cells of the current phase, the chunk is still in periodic sleep
+			for (int y = 0; y < size; y++)
+				for (int x = 0; x < size; x++)
+					if ((phaseCells[y] >> x) & 1)
+						m_cellCoords.emplace_back(x, y);
+			return m_cellCoords;
+		}
+		if (m_cells == nullptr)
+		{
+			// Read compressed cells without decompressing, the chunk is still sleeping
+			std::vector<unsigned char> buffer;
+			if (const std::vector<unsigned char>* data = this->getCompressedData(buffer))
+				forEachCompressedCell(*data, [this](size_t idx) {
+					int x, y;
+					cellIndex2Coords(idx, x, y);
+					m_cellCoords.emplace_back(x, y);
+				});
+			return m_cellCoords;
+		}
 		size_t idx = 0;
-		for (int y = 0; y < CHUNK_SIZE; y++)
+		for (int y = 0; y < size; y++)
 		{
-			for (int x = 0; x < CHUNK_SIZE; x++, idx++)
+			for (int x = 0; x < size; x++, idx++)
 			{
 				if (GOL_IS_CELL_ALIVE(m_cells[idx]))
 					m_cellCoords.emplace_back(x, y);
@@ -522,4 +1638,96 @@ const std::vector<std::pair<int, int>>& Chunk::getCellCoords() const
 		}
 	}
 	return m_cellCoords;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+const unsigned char* Chunk::getDensity(int level) const
+{
+	if (level < 1 || level > DENSITY_LEVELS)
+		return nullptr;
+
+	if (m_density.empty() || m_densityVersion != m_version)
+	{
+		uint64_t cells[CHUNK_SIZE];
+		this->packCells(cells);
+		m_density.resize(DENSITY_BYTES);
+		buildDensity(cells, m_density.data());
+		m_densityVersion = m_version;
+	}
+
+	return &m_density[getDensityOffset(level)];
+}
+
+
+//////////////////////////////////////////////////////////////////////
+size_t Chunk::getDensityOffset(int level)
+{
+	size_t offset = 0;
+	for (int l = 1; l < level; l++)
+		offset += (CHUNK_SIZE >> l) * (CHUNK_SIZE >> l);
+	return offset;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::buildDensity(const uint64_t cells[CHUNK_SIZE], unsigned char* out_density)
+{
+	// Count alive cells of 2x2 blocks from packed rows
+	const uint64_t EVEN_BITS = 0x5555555555555555ull;
+	unsigned short counts[(CHUNK_SIZE / 2) * (CHUNK_SIZE / 2)];
+	int side = CHUNK_SIZE / 2;
+	for (int y = 0; y < side; y++)
+	{
+		// Alive cells of each pair of cells in both rows, two bits per pair
+		uint64_t upper = (cells[y * 2] & EVEN_BITS) + ((cells[y * 2] >> 1) & EVEN_BITS);
+		uint64_t lower = (cells[y * 2 + 1] & EVEN_BITS) + ((cells[y * 2 + 1] >> 1) & EVEN_BITS);
+		for (int x = 0; x < side; x++)
+			counts[y * side + x] = static_cast<unsigned short>(((upper >> (x * 2)) & 3) + ((lower >> (x * 2)) & 3));
+	}
+
+	for (int l = 1; l <= DENSITY_LEVELS; l++)
+	{
+		if (l > 1)
+		{
+			// Sum 2x2 blocks of the level below, in place as each sum is stored before the blocks it was read from
+			int below = side;
+			side /= 2;
+			for (int y = 0; y < side; y++)
+				for (int x = 0; x < side; x++)
+					counts[y * side + x] = counts[(y * 2) * below + x * 2] + counts[(y * 2) * below + x * 2 + 1]
+						+ counts[(y * 2 + 1) * below + x * 2] + counts[(y * 2 + 1) * below + x * 2 + 1];
+		}
+
+		const unsigned int area = 1u << (l * 2);
+		unsigned char* density = out_density + getDensityOffset(l);
+		for (int i = 0; i < side * side; i++)
+			density[i] = (counts[i] == 0) ? 0 : static_cast<unsigned char>(32 + counts[i] * 223u / area);
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Chunk::unpackCells(const std::vector<unsigned char>& data, uint64_t out_cells[CHUNK_SIZE])
+{
+	std::fill(out_cells, out_cells + CHUNK_SIZE, 0);
+	forEachCompressedCell(data, [out_cells](size_t idx) {
+		out_cells[idx / CHUNK_SIZE] |= uint64_t(1) << (idx % CHUNK_SIZE);
+	});
+}
+
+
+//////////////////////////////////////////////////////////////////////
+std::shared_ptr<const ChunkSnapshot> Chunk::snapshot() const
+{
+	if (!m_snapshot || this->isSnapshotStale())
+		m_snapshot.reset(new ChunkSnapshot(*this));
+	return m_snapshot;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Chunk::isSnapshotStale() const
+{
+	return m_snapshot && (m_snapshot->getVersion() != m_version || m_snapshot->getSleepMode() != m_sleepMode);
 }
\ No newline at end of file
@@ -34,14 +34,20 @@
 // each cell it contains.
 // 
 
+#include "ChunkStore.hpp"
+
 #include <atomic>
 #include <vector>
+#include <memory>
+#include <cstdlib>
+#include <cstdint>
 
 
 namespace gol
 {
 
 class Simulation;
+class ChunkSnapshot;
 
 class Chunk
 {
@@ -59,6 +65,20 @@ public:
 
 		// updateCellStates() will do nothing.
 		Sleeping,
+
+		// updateCellStates() will replay cached phases of an oscillating pattern,
+		// as long as the cells bordering this chunk match the cached phase.
+		Periodic,
+	};
+
+	enum ERepresentation
+	{
+		// updateCellStates() will visit cells by scanning the full cell table.
+		Dense,
+
+		// updateCellStates() will only visit alive cells and their neighbours,
+		// as well as border cells next to populated neighbour chunks.
+		Sparse,
 	};
 
 	enum ENeighbour {
@@ -78,14 +98,43 @@ public:
 	// Chunk becomes marked for deletion after sleeping for this many steps.
 	static const size_t INACTIVITY_TIMEOUT = 100;
 
+	// Dense chunks become sparse when their population drops to this many cells or less.
+	static const unsigned int SPARSE_ENTER_POPULATION = 96;
+
+	// Sparse chunks become dense when their population rises above this many cells.
+	static const unsigned int SPARSE_EXIT_POPULATION = 192;
+
+	// Longest period of oscillation detected for periodic sleep.
+	static const unsigned int MAX_PERIOD = 15;
+
+	// Chunks sleeping (or in periodic sleep) for this many steps are compressed by compressCells().
+	static const unsigned int COMPRESS_SLEEP_STEPS = 1000;
+
+	// How a chunk state steps to the next generation.
+	struct Transition
+	{
+		std::vector<unsigned short> changedCells; //> Cells that toggle going to the next generation.
+		unsigned int births;
+		unsigned int deaths;
+		bool borderChanged;
+	};
+
 	// Returns true if this chunk is valid and active.
 	inline bool isValid() const {
-		return (m_sim != nullptr) && (m_cells != nullptr);
+		return (m_sim != nullptr);
 	}
 
+	// Returns true if cell storage is allocated.
+	// Storage is only allocated on the first birth, until then all cells are dead.
+	inline bool hasCellStorage() const { return m_cells != nullptr; }
+
 	// Set cell state at chunk-local coordinates {x,y}.
 	void setCell(int x, int y, bool alive);
 
+	// Set cell states of the whole chunk from bitmasks, one per row (bit x of row y).
+	// Returns true if any border cell changed.
+	bool setCells(const uint64_t cells[CHUNK_SIZE]);
+
 	// Get cell state at chunk-local coordinates {x,y}.
 	bool getCell(int x, int y) const;
 
@@ -117,6 +166,12 @@ public:
 	// Get the current mode of sleep.
 	inline ESleepMode getSleepMode() const { return m_sleepMode; }
 
+	// Get how cells are visited when updating.
+	inline ERepresentation getRepresentation() const { return m_representation; }
+
+	// Get period of oscillation when in Periodic sleep mode. Returns 0 otherwise.
+	inline unsigned int getPeriod() const { return (m_sleepMode == Periodic) ? m_period : 0; }
+
 	// Get parent simulator.
 	inline const Simulation* getSimulation() const { return m_sim; }
 
@@ -129,16 +184,70 @@ public:
 	// Get unique chunk ID.
 	inline unsigned int getUniqueID() const { return m_uid; }
 
-	// Get raw cell data table. Length is CHUNK_SIZE * CHUNK_SIZE. Can be nullptr if it allocation was unsuccessful.
+	// Get count of changes to cells. Anything built from the cells is out of date once this changes.
+	inline unsigned int getVersion() const { return m_version; }
+
+	// Returns true if cells are held compressed, see compressCells().
+	inline bool isCompressed() const { return (m_compressed != nullptr) || this->isPaged() || (this->getPhaseCells() != nullptr); }
+
+	// Returns true if compressed cells are paged out to the simulation's backing file, see pageOut().
+	inline bool isPaged() const { return m_pageSlot >= 0; }
+
+	// Get bytes used by uncompressed cell storage, including the alive cell coordinate list.
+	size_t getResidentBytes() const;
+
+	// Get bytes used by compressed cell storage owned by this chunk.
+	// Buffers shared through the simulation's ChunkStore are not counted.
+	size_t getCompressedBytes() const;
+
+	// Get raw cell data table. Length is CHUNK_SIZE * CHUNK_SIZE. Can be nullptr if the chunk has no cell storage (or it is compressed).
 	inline const char* getRawCellData() const { return m_cells; }
 
 	// Get {x,y} chunk-local coords for each alive cell.
 	const std::vector<std::pair<int,int>>& getCellCoords() const;
 
+	// Number of density levels, see getDensity().
+	static const int DENSITY_LEVELS = 6;
+
+	// Get density of alive cells in blocks of 2^level cells per side, for level 1 to DENSITY_LEVELS.
+	// Row-major, CHUNK_SIZE >> level blocks per side. Empty blocks are 0, others range from 32 to 255
+	// by their fraction of alive cells, so lone cells stay visible. Rebuilt only after cells have changed.
+	const unsigned char* getDensity(int level) const;
+
+	// Bytes of every density level together, see buildDensity().
+	static const size_t DENSITY_BYTES = 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2 + 1;
+
+	// Get offset of a density level within every density level together, see buildDensity().
+	static size_t getDensityOffset(int level);
+
+	// Build every density level (see getDensity()) of cells held as bitmasks, one per row (bit x of row y).
+	// Levels are stored one after another from level 1, out_density must be DENSITY_BYTES long.
+	static void buildDensity(const uint64_t cells[CHUNK_SIZE], unsigned char* out_density);
+
+	// Read compressed cells (see compressCells()) into bitmasks, one per row (bit x of row y).
+	static void unpackCells(const std::vector<unsigned char>& data, uint64_t out_cells[CHUNK_SIZE]);
+
+	// Compress cell storage if the chunk has been sleeping for COMPRESS_SLEEP_STEPS.
+	// Sleeping chunks are run-length encoded. Chunks in periodic sleep drop their cell table,
+	// as the recorded phases hold the same cells.
+	// Cells are decompressed again when the chunk wakes up or is modified.
+	void compressCells();
+
+	// Move cells of a sleeping chunk to the simulation's backing file, compressing them first if needed.
+	// Edges are kept in memory for neighbouring chunks. Cells are paged in again when the chunk wakes
+	// up or is modified, and read from the file without paging in otherwise.
+	void pageOut();
+
+	// Decompress a compressed chunk in periodic sleep if bordering cells no longer match its cycle.
+	// Must be called before updating any chunk, as neighbouring chunks read cells while updating.
+	void checkCompressedPhase();
+
 private:
 	friend Simulation;
+	friend ChunkSnapshot;
+	friend class ChunkBenchmark; //> Kernel micro-benchmarks, see Benchmark/ChunkBenchmark.cpp.
 
-	static unsigned int NEXT_UNIQUE_ID;
+	static std::atomic<unsigned int> NEXT_UNIQUE_ID; //> Shared by every simulation, which may be stepped on different threads.
 	const unsigned int m_uid;
 
 	// Internal: Safely counts neighbouring cells, including from neighbouring chunks.
@@ -147,6 +256,92 @@ private:
 	// Internal: Update inactivity state of this chunk.
 	void checkInactivity();
 
+	// Internal: Mark a cell to change state next generation, while updating.
+	// Neighbouring chunks read border cells while updating, so their changes are held back until applyCellStates().
+	void flipCellNextGen(size_t idx);
+
+	// Internal: Apply border cell changes held back by flipCellNextGen().
+	void applyBorderFlips();
+
+	// Internal: Allocate and zero cell storage, if not already allocated.
+	void allocateCells();
+
+	// Internal: Free cell storage. All cells must be dead.
+	void releaseCells();
+
+	// Internal: Restore cell storage from its compressed form, if compressed.
+	// Returns false if cells could not be restored, the chunk is then left compressed.
+	bool decompressCells();
+
+	// Internal: Get alive state of a cell from the compressed form.
+	bool getCompressedCell(int x, int y) const;
+
+	// Internal: Encode cell storage, see compressCells().
+	void encodeCells(CompressedCells& out_compressed) const;
+
+	// Internal: Get compressed cell data, read into the buffer provided if paged out.
+	// Returns nullptr if cells are not compressed (or phase compressed).
+	const std::vector<unsigned char>* getCompressedData(std::vector<unsigned char>& buffer) const;
+
+	// Internal: Get edges of compressed cells, see readEdge().
+	inline const uint64_t* getCompressedEdges() const { return m_compressed ? m_compressed->edges : m_pagedEdges; }
+
+	// Internal: Get cells of the current phase, one bitmask per row, if this chunk is in periodic sleep
+	// without a cell table. Returns nullptr otherwise.
+	inline const uint64_t* getPhaseCells() const {
+		return (m_cells == nullptr && m_sleepMode == Periodic) ? m_phases[m_phase].cells : nullptr;
+	}
+
+	// Internal: Read the alive states of cells along one edge of this chunk into a bitmask.
+	// Edges are {north row, south row, west column, east column}.
+	enum { EdgeNorth, EdgeSouth, EdgeWest, EdgeEast, EDGE_COUNT };
+	uint64_t readEdge(int edge) const;
+
+	// Internal: Update next generation cell states, only visiting cells that may change.
+	void updateSparseCellStates(int& births, int& deaths, bool& borderChanged);
+
+	// Internal: Update next generation state of a single cell visited by updateSparseCellStates().
+	void updateSparseCell(int x, int y, int& births, int& deaths, bool& borderChanged);
+
+	// Internal: Apply next generation states of changed cells only.
+	void applySparseCellStates(const std::vector<unsigned short>& changedCells);
+
+	// Internal: Read the alive states of cells bordering this chunk (the halo) into bitmasks.
+	// {north row, south row, west column, east column, corners (NW,NE,SW,SE)}
+	static const size_t HALO_WORDS = 5;
+	void readHalo(uint64_t out_halo[HALO_WORDS]) const;
+
+	// Internal: Track chunk state, and enter Periodic sleep mode once a repeating cycle is confirmed.
+	void checkPeriodicity(const uint64_t halo[HALO_WORDS], uint64_t stateHash);
+
+	// Internal: Update next generation cell states from the cached phase.
+	// Returns false if bordering cells have been disturbed, meaning the chunk must be updated normally.
+	bool updatePeriodicCellStates(int& births, int& deaths, bool& borderChanged);
+
+	// Internal: Stop tracking or replaying periodic states.
+	void resetPeriodicity();
+
+	// Internal: Read the alive states of cells in this chunk into bitmasks, one per row.
+	void packCells(uint64_t out_cells[CHUNK_SIZE]) const;
+
+	// Internal: Get immutable snapshot of this chunk, see Simulation::snapshot().
+	// The previous snapshot is returned while cells and sleep mode are unchanged.
+	std::shared_ptr<const ChunkSnapshot> snapshot() const;
+
+	// Internal: Returns true if cells or sleep mode changed since the last snapshot().
+	bool isSnapshotStale() const;
+
+	// Internal: Hash the alive states of cells in this chunk and its halo.
+	// out_check is an independent hash, used along with out_hash to identify chunk states.
+	void getStateHash(const uint64_t halo[HALO_WORDS], uint64_t& out_hash, uint64_t& out_check) const;
+
+	// Internal: Hash of alive cells, which also depends on the position of this chunk. Zero if there are no alive cells.
+	uint64_t getPositionalHash() const;
+
+	// Internal: Zobrist hash component for a single alive cell. Each seed gives an independent hash.
+	static const uint64_t CHECK_SEED = 0xD1B54A32D192ED03ull;
+	static uint64_t hashCell(uint64_t idx, uint64_t seed = 0);
+
 	// Internal: Translate local {x,y} cell coordinates to cell index. Does not perform any safety checks.
 	inline static size_t cellCoords2Index(int x, int y) { return y * CHUNK_SIZE + x; }
 
@@ -166,9 +361,49 @@ private:
 	mutable bool m_cellCoordsInvalid;
 	mutable std::vector<std::pair<int,int>> m_cellCoords;
 
+	mutable std::vector<unsigned char> m_density; //> Every density level, see getDensity().
+	mutable unsigned int m_densityVersion;        //> getVersion() the density levels were built from.
+
+	// Latest snapshot of this chunk, reused by Simulation::snapshot() until cells or sleep mode change.
+	mutable std::shared_ptr<const ChunkSnapshot> m_snapshot;
+
 	unsigned int m_inactivity;
+	unsigned int m_sleepSteps; //> Steps spent sleeping or in periodic sleep.
+	unsigned int m_version;    //> Incremented each time cells change.
 	bool m_borderChanged;
+	uint64_t m_borderFlips[EDGE_COUNT]; //> Border cells changing next generation, see flipCellNextGen().
 	ESleepMode m_sleepMode;
+	ERepresentation m_representation;
+
+	// Sparse mode: cells which will change next generation.
+	// (Cells visited by an update are tracked per thread, see updateSparseCell().)
+	std::vector<unsigned short> m_sparseChangedCells;
+
+	// Compressed cells, see compressCells(). Shared with identical chunks through the simulation's ChunkStore.
+	ChunkStore::Handle m_compressed;
+
+	// Paged out cells: slot in the simulation's ChunkPager (or -1), and edges kept in memory.
+	int64_t m_pageSlot;
+	uint64_t m_pagedEdges[EDGE_COUNT];
+
+	// Hashes of alive cells, maintained incrementally as cells change.
+	uint64_t m_cellHash;
+	uint64_t m_cellCheck;
+
+	// Periodic sleep: hashes of this chunk and its halo over the last MAX_PERIOD * 2 generations.
+	// Only allocated while looking for a period, see checkPeriodicity().
+	std::unique_ptr<uint64_t[]> m_stateHashes;
+	unsigned int m_stateHashCount;
+
+	// Periodic sleep: recorded phases of the detected cycle.
+	struct PeriodicPhase : Transition
+	{
+		uint64_t cells[CHUNK_SIZE];
+		uint64_t halo[HALO_WORDS];
+	};
+	std::vector<PeriodicPhase> m_phases;
+	unsigned int m_period;
+	unsigned int m_phase;
 
 	int m_column;
 	int m_row;
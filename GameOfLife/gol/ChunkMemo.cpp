@@ -0,0 +1,180 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/ChunkMemo.cpp
+// 
+// Implements class gol::ChunkMemo
+// 
+
+#include "ChunkMemo.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace gol;
+
+
+//////////////////////////////////////////////////////////////////////
+ChunkMemo::ChunkMemo(size_t capacity)
+	: m_capacity(0)
+	, m_shardCapacity(0)
+	, m_hits(0)
+	, m_misses(0)
+	, m_evictions(0)
+{
+	this->setCapacity(capacity);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void ChunkMemo::setCapacity(size_t capacity)
+{
+	this->clear();
+	m_capacity = capacity;
+	m_shardCapacity = (capacity + SHARD_COUNT - 1) / SHARD_COUNT;
+
+	for (Shard& shard : m_shards)
+	{
+		std::unique_lock<std::mutex> lk(shard.guard);
+		shard.seen.assign(m_shardCapacity, 0);
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void ChunkMemo::clear()
+{
+	for (Shard& shard : m_shards)
+	{
+		std::unique_lock<std::mutex> lk(shard.guard);
+		shard.entries.clear();
+		shard.index.clear();
+		std::fill(shard.seen.begin(), shard.seen.end(), 0);
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void ChunkMemo::resetCounters()
+{
+	m_hits = 0;
+	m_misses = 0;
+	m_evictions = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool ChunkMemo::lookup(uint64_t hash, uint64_t check, Chunk::Transition& out_transition)
+{
+	Shard& shard = this->getShard(hash);
+	std::unique_lock<std::mutex> lk(shard.guard);
+
+	auto it = shard.index.find(hash);
+	if (it != shard.index.end())
+	{
+		// Both hashes must match, a state is identified by 128 bits
+		if (it->second->check == check)
+		{
+			out_transition = it->second->transition;
+
+			// Mark as most recently used
+			shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+			m_hits.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	m_misses.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void ChunkMemo::insert(uint64_t hash, uint64_t check, const Chunk::Transition& transition)
+{
+	if (m_shardCapacity == 0)
+		return;
+
+	Shard& shard = this->getShard(hash);
+	std::unique_lock<std::mutex> lk(shard.guard);
+
+	auto it = shard.index.find(hash);
+	if (it == shard.index.end())
+	{
+		// Only admit states seen before
+		// (hash / SHARD_COUNT, as the low bits all map to this shard)
+		uint64_t& seen = shard.seen[(hash / SHARD_COUNT) % shard.seen.size()];
+		if (seen != hash)
+		{
+			seen = hash;
+			return;
+		}
+	}
+
+	if (it != shard.index.end())
+	{
+		// Replace transition with same hash
+		shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+	}
+	else if (shard.entries.size() >= m_shardCapacity)
+	{
+		// Full, reuse least recently used entry
+		shard.index.erase(shard.entries.back().hash);
+		shard.entries.splice(shard.entries.begin(), shard.entries, std::prev(shard.entries.end()));
+		shard.index[hash] = shard.entries.begin();
+		m_evictions.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		shard.entries.emplace_front();
+		shard.index[hash] = shard.entries.begin();
+	}
+
+	Entry& entry = shard.entries.front();
+	entry.hash = hash;
+	entry.check = check;
+	entry.transition = transition;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+size_t ChunkMemo::getSize() const
+{
+	size_t size = 0;
+	for (const Shard& shard : m_shards)
+	{
+		std::unique_lock<std::mutex> lk(shard.guard);
+		size += shard.entries.size();
+	}
+	return size;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+float ChunkMemo::getHitRate() const
+{
+	uint64_t hits = m_hits;
+	uint64_t total = hits + m_misses;
+	return (total > 0) ? static_cast<float>(hits) / total : 0.f;
+}
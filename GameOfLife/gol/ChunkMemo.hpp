@@ -0,0 +1,126 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/ChunkMemo.hpp
+//
+// class gol::ChunkMemo
+// 
+// Bounded cache of chunk transitions, keyed by a 128-bit hash of a chunk's
+// cells and its halo (the cells bordering it). Settled universes tend to contain many chunks with
+// identical contents (blocks, beehives, blinkers...), so a chunk whose
+// state has been seen before can reuse the cached changes instead of
+// evaluating every cell. A transition is only cached once its state has
+// been seen twice, so that one-off states do not push out useful ones.
+// Least recently used entries are evicted once the cache is full. The cache is split into shards, each with its own lock,
+// so that worker threads rarely contend with each other.
+// 
+
+#include "Chunk.hpp"
+#include <unordered_map>
+#include <list>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+
+namespace gol
+{
+
+class ChunkMemo
+{
+public:
+	// capacity: Maximum number of cached transitions. Zero disables the cache.
+	ChunkMemo(size_t capacity = 0);
+
+	// Number of independently locked parts of the cache.
+	static const size_t SHARD_COUNT = 16;
+
+	// Set maximum number of cached transitions. Zero disables the cache.
+	// This will clear all cached transitions.
+	void setCapacity(size_t capacity);
+
+	// Get maximum number of cached transitions.
+	inline size_t getCapacity() const { return m_capacity; }
+
+	// Returns true if transitions are being cached.
+	inline bool isEnabled() const { return m_capacity > 0; }
+
+	// Remove all cached transitions. Counters are not reset.
+	void clear();
+
+	// Reset hit, miss and eviction counters.
+	void resetCounters();
+
+	// Look up the transition from the chunk state identified by {hash,check}.
+	// If found, it is copied into out_transition and true is returned.
+	bool lookup(uint64_t hash, uint64_t check, Chunk::Transition& out_transition);
+
+	// Cache the transition from the chunk state identified by {hash,check}.
+	// The transition is ignored if this state has not been seen recently.
+	void insert(uint64_t hash, uint64_t check, const Chunk::Transition& transition);
+
+	// Get number of cached transitions.
+	size_t getSize() const;
+
+	// Get number of successful lookups.
+	inline uint64_t getHits() const { return m_hits; }
+
+	// Get number of unsuccessful lookups.
+	inline uint64_t getMisses() const { return m_misses; }
+
+	// Get number of transitions evicted to make room for new ones.
+	inline uint64_t getEvictions() const { return m_evictions; }
+
+	// Get ratio of successful lookups to all lookups, between 0 and 1.
+	float getHitRate() const;
+
+private:
+	struct Entry
+	{
+		uint64_t hash;
+		uint64_t check;
+		Chunk::Transition transition;
+	};
+
+	struct Shard
+	{
+		mutable std::mutex guard;
+		std::list<Entry> entries; //> Most recently used first.
+		std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+		std::vector<uint64_t> seen; //> Hashes of states seen once, indexed by hash.
+	};
+
+	Shard& getShard(uint64_t hash) { return m_shards[hash % SHARD_COUNT]; }
+
+	Shard m_shards[SHARD_COUNT];
+	size_t m_capacity;
+	size_t m_shardCapacity;
+	std::atomic<uint64_t> m_hits;
+	std::atomic<uint64_t> m_misses;
+	std::atomic<uint64_t> m_evictions;
+};
+
+}
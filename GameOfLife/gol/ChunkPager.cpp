@@ -0,0 +1,186 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/ChunkPager.cpp
+// 
+// Implements class gol::ChunkPager
+// 
+
+#include "ChunkPager.hpp"
+
+#include <iostream>
+
+using namespace gol;
+
+
+//////////////////////////////////////////////////////////////////////
+ChunkPager::ChunkPager()
+	: m_file(nullptr)
+	, m_slotCount(0)
+	, m_pagedCount(0)
+	, m_pageIns(0)
+	, m_pageOuts(0)
+{
+}
+
+
+//////////////////////////////////////////////////////////////////////
+ChunkPager::~ChunkPager()
+{
+	// Temporary file is removed once closed
+	if (m_file != nullptr)
+		std::fclose(m_file);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+int64_t ChunkPager::pageOut(const std::vector<unsigned char>& data)
+{
+	if (data.size() > MAX_DATA_BYTES)
+		return -1;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Backing file is only made once something is paged out
+	if (m_file == nullptr && (m_file = std::tmpfile()) == nullptr)
+	{
+		std::cerr << "chunk pager could not create backing file!" << std::endl;
+		return -1;
+	}
+
+	int64_t slot;
+	if (!m_freeSlots.empty())
+		slot = m_freeSlots.back();
+	else
+		slot = static_cast<int64_t>(m_slotCount);
+
+	unsigned char header[2] = {
+		static_cast<unsigned char>(data.size() & 0xFF),
+		static_cast<unsigned char>(data.size() >> 8)
+	};
+	if (!this->seekSlot(slot) ||
+	    std::fwrite(header, 1, 2, m_file) != 2 ||
+	    std::fwrite(data.data(), 1, data.size(), m_file) != data.size())
+	{
+		std::cerr << "chunk pager could not write slot " << slot << "! out of disk space?" << std::endl;
+		return -1;
+	}
+
+	if (!m_freeSlots.empty())
+		m_freeSlots.pop_back();
+	else
+		m_slotCount++;
+	m_pagedCount++;
+	m_pageOuts++;
+	return slot;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool ChunkPager::pageIn(int64_t slot, std::vector<unsigned char>& out_data)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Slot stays in use if it could not be read, the chunk keeps it
+	if (!this->readSlot(slot, out_data))
+		return false;
+
+	m_freeSlots.push_back(slot);
+	m_pagedCount--;
+	m_pageIns++;
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool ChunkPager::read(int64_t slot, std::vector<unsigned char>& out_data) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return this->readSlot(slot, out_data);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void ChunkPager::release(int64_t slot)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_freeSlots.push_back(slot);
+	m_pagedCount--;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void ChunkPager::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Start over with a new, empty file
+	if (m_file != nullptr)
+	{
+		std::fclose(m_file);
+		m_file = nullptr;
+	}
+	m_freeSlots.clear();
+	m_slotCount = 0;
+	m_pagedCount = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool ChunkPager::seekSlot(int64_t slot) const
+{
+	// long is 32-bit on Windows, std::fseek can't reach past 2 GiB there
+	const int64_t offset = slot * static_cast<int64_t>(SLOT_BYTES);
+#ifdef _MSC_VER
+	return _fseeki64(m_file, offset, SEEK_SET) == 0;
+#else
+	return fseeko(m_file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool ChunkPager::readSlot(int64_t slot, std::vector<unsigned char>& out_data) const
+{
+	out_data.clear();
+	if (m_file == nullptr || slot < 0 || static_cast<size_t>(slot) >= m_slotCount)
+		return false;
+
+	unsigned char header[2];
+	if (!this->seekSlot(slot) ||
+	    std::fread(header, 1, 2, m_file) != 2)
+	{
+		std::cerr << "chunk pager could not read slot " << slot << "!" << std::endl;
+		return false;
+	}
+
+	out_data.resize(header[0] | (size_t(header[1]) << 8));
+	if (out_data.size() > MAX_DATA_BYTES || std::fread(out_data.data(), 1, out_data.size(), m_file) != out_data.size())
+	{
+		std::cerr << "chunk pager could not read slot " << slot << "!" << std::endl;
+		out_data.clear();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/ChunkPager.hpp
+//
+// class gol::ChunkPager
+// 
+// Backing file for compressed cells of chunks which are paged out to keep
+// the simulation within its memory budget. The file is a temporary file
+// split into equal slots, one per paged chunk. Slots are reused once
+// their chunk is paged back in. Safe to use from multiple threads.
+// 
+
+#include "Chunk.hpp"
+
+#include <vector>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+
+
+namespace gol
+{
+
+class ChunkPager
+{
+public:
+	// Largest compressed cell data stored in a slot: format byte followed by a bitmap.
+	static const size_t MAX_DATA_BYTES = 1 + Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE / 8;
+
+	ChunkPager();
+	~ChunkPager();
+
+	// Write compressed cell data to a free slot. Returns the slot, or -1 if it could not be written.
+	int64_t pageOut(const std::vector<unsigned char>& data);
+
+	// Read compressed cell data back, and free its slot. Returns false if it could not be read, the slot is then kept.
+	bool pageIn(int64_t slot, std::vector<unsigned char>& out_data);
+
+	// Read compressed cell data without freeing its slot. Returns false if it could not be read.
+	bool read(int64_t slot, std::vector<unsigned char>& out_data) const;
+
+	// Free slot without reading it.
+	void release(int64_t slot);
+
+	// Free all slots and truncate the backing file.
+	void clear();
+
+	// Get the count of slots in use.
+	inline size_t getPagedCount() const { return m_pagedCount; }
+
+	// Get size of the backing file in bytes.
+	inline uint64_t getFileBytes() const { return static_cast<uint64_t>(m_slotCount) * SLOT_BYTES; }
+
+	// Get the count of chunks paged in/out since the simulation was created.
+	inline unsigned long long getPageIns() const { return m_pageIns; }
+	inline unsigned long long getPageOuts() const { return m_pageOuts; }
+
+private:
+	// Slots hold a 2 byte data length followed by the data.
+	static const size_t SLOT_BYTES = 2 + MAX_DATA_BYTES;
+
+	// Internal: Seek to the start of a slot, with 64-bit offsets so the file can grow past 2 GiB.
+	// Must be called with the mutex locked. Returns false on failure.
+	bool seekSlot(int64_t slot) const;
+
+	// Internal: Read a slot. Must be called with the mutex locked.
+	bool readSlot(int64_t slot, std::vector<unsigned char>& out_data) const;
+
+	mutable std::mutex m_mutex;
+	std::FILE* m_file;
+	std::vector<int64_t> m_freeSlots;
+	size_t m_slotCount;
+	size_t m_pagedCount;
+	unsigned long long m_pageIns;
+	unsigned long long m_pageOuts;
+};
+
+}
@@ -0,0 +1,119 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/ChunkStore.cpp
+// 
+// Implements class gol::ChunkStore
+// 
+
+#include "ChunkStore.hpp"
+
+#include <algorithm>
+
+using namespace gol;
+
+
+//////////////////////////////////////////////////////////////////////
+ChunkStore::ChunkStore()
+	: m_size(0)
+	, m_uniqueBytes(0)
+	, m_referencedBytes(0)
+{
+}
+
+
+//////////////////////////////////////////////////////////////////////
+ChunkStore::Handle ChunkStore::intern(CompressedCells&& cells)
+{
+	cells.data.shrink_to_fit();
+	Handle handle = std::make_shared<const CompressedCells>(std::move(cells));
+
+	// Share the stored buffer if there is one, otherwise store this one
+	return *m_buffers.insert(handle).first;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void ChunkStore::collect(const UseCounts& uses)
+{
+	m_uniqueBytes = 0;
+	m_referencedBytes = 0;
+	for (auto it = m_buffers.begin(); it != m_buffers.end();)
+	{
+		// No chunk is using it, snapshots holding it keep their own reference
+		auto itUses = uses.find(it->get());
+		if (itUses == uses.end() || itUses->second == 0)
+		{
+			it = m_buffers.erase(it);
+			continue;
+		}
+
+		size_t bytes = sizeof(CompressedCells) + (*it)->data.capacity();
+		m_uniqueBytes += bytes;
+		m_referencedBytes += bytes * itUses->second;
+		it++;
+	}
+	m_size = m_buffers.size();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void ChunkStore::clear()
+{
+	m_buffers.clear();
+	m_size = 0;
+	m_uniqueBytes = 0;
+	m_referencedBytes = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+float ChunkStore::getDedupRatio() const
+{
+	if (m_uniqueBytes == 0)
+		return 1.f;
+	return static_cast<float>(m_referencedBytes) / m_uniqueBytes;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+size_t ChunkStore::HandleHash::operator()(const Handle& cells) const
+{
+	// FNV-1a over edges and data
+	uint64_t h = 0xCBF29CE484222325ull;
+	auto mix = [&h](unsigned char b) { h = (h ^ b) * 0x100000001B3ull; };
+	for (uint64_t edge : cells->edges)
+		for (int i = 0; i < 8; i++)
+			mix(static_cast<unsigned char>(edge >> (i * 8)));
+	for (unsigned char b : cells->data)
+		mix(b);
+	return static_cast<size_t>(h);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool ChunkStore::HandleEqual::operator()(const Handle& a, const Handle& b) const
+{
+	return std::equal(a->edges, a->edges + 4, b->edges) && a->data == b->data;
+}
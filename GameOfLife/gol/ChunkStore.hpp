@@ -0,0 +1,108 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/ChunkStore.hpp
+//
+// class gol::ChunkStore
+// 
+// Hash-consed storage for compressed chunk cells. Settled universes tend to
+// contain many chunks with identical contents (a lone block, a beehive...),
+// so identical compressed chunks share one immutable buffer instead of each
+// holding a copy. A chunk makes its own private cell table from the shared
+// buffer once it has to change (copy-on-write), dropping its reference.
+// Buffers are only added while no chunk is being updated, but references may
+// be dropped from any thread. Buffers no chunk uses are removed by
+// collect(), even if snapshots still hold them.
+// 
+
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+
+namespace gol
+{
+
+// Cells of a chunk in compressed form.
+struct CompressedCells
+{
+	uint64_t edges[4];               //> Cells along each edge, kept uncompressed as neighbouring chunks read them.
+	std::vector<unsigned char> data; //> Format byte, followed by run lengths or a bitmap.
+};
+
+class ChunkStore
+{
+public:
+	typedef std::shared_ptr<const CompressedCells> Handle;
+
+	// Count of chunks using each buffer.
+	typedef std::unordered_map<const CompressedCells*, size_t> UseCounts;
+
+	ChunkStore();
+
+	// Get shared buffer holding the cells given, adding it if no identical buffer is stored.
+	// Must not be called while chunks are being updated.
+	Handle intern(CompressedCells&& cells);
+
+	// Remove buffers no longer used by any chunk, and update statistics.
+	// uses: Chunks using each buffer. Other holders of a buffer (such as snapshots) are not counted.
+	// Must not be called while chunks are being updated.
+	void collect(const UseCounts& uses);
+
+	// Remove all buffers. Chunks keep the buffers they are using.
+	void clear();
+
+	// Get number of distinct buffers, as of the last collect().
+	inline size_t getSize() const { return m_size; }
+
+	// Get bytes used by distinct buffers, as of the last collect().
+	inline size_t getUniqueBytes() const { return m_uniqueBytes; }
+
+	// Get bytes that would be used if every chunk held its own copy, as of the last collect().
+	inline size_t getReferencedBytes() const { return m_referencedBytes; }
+
+	// Get ratio of referenced bytes to unique bytes (1 means nothing is shared), as of the last collect().
+	float getDedupRatio() const;
+
+private:
+	struct HandleHash
+	{
+		size_t operator()(const Handle& cells) const;
+	};
+	struct HandleEqual
+	{
+		bool operator()(const Handle& a, const Handle& b) const;
+	};
+
+	std::unordered_set<Handle, HandleHash, HandleEqual> m_buffers;
+	size_t m_size;
+	size_t m_uniqueBytes;
+	size_t m_referencedBytes;
+};
+
+}
@@ -0,0 +1,118 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/EditJournal.cpp
+// 
+// Implements class gol::EditJournal
+// 
+
+#include "EditJournal.hpp"
+#include <utility>
+
+
+namespace gol
+{
+
+//////////////////////////////////////////////////////////////////////
+EditJournal::EditJournal()
+	: m_head(nullptr)
+{
+}
+
+
+//////////////////////////////////////////////////////////////////////
+EditJournal::~EditJournal()
+{
+	this->clear();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void EditJournal::record(int x, int y, bool alive)
+{
+	Batch* batch = new Batch();
+	batch->edits.push_back({ x, y, alive });
+	this->push(batch);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void EditJournal::record(std::vector<CellEdit>&& edits)
+{
+	if (edits.empty())
+		return;
+
+	Batch* batch = new Batch();
+	batch->edits = std::move(edits);
+	this->push(batch);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void EditJournal::push(Batch* batch)
+{
+	batch->next = m_head.load(std::memory_order_relaxed);
+	while (!m_head.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed))
+		;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void EditJournal::take(std::vector<CellEdit>& out_edits)
+{
+	Batch* batch = m_head.exchange(nullptr, std::memory_order_acquire);
+
+	// Batches are linked latest first, reverse them into recorded order
+	Batch* ordered = nullptr;
+	while (batch)
+	{
+		Batch* next = batch->next;
+		batch->next = ordered;
+		ordered = batch;
+		batch = next;
+	}
+
+	while (ordered)
+	{
+		Batch* next = ordered->next;
+		out_edits.insert(out_edits.end(), ordered->edits.begin(), ordered->edits.end());
+		delete ordered;
+		ordered = next;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void EditJournal::clear()
+{
+	Batch* batch = m_head.exchange(nullptr, std::memory_order_acquire);
+	while (batch)
+	{
+		Batch* next = batch->next;
+		delete batch;
+		batch = next;
+	}
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// gol/EditJournal.hpp
+//
+// class gol::EditJournal
+// 
+// Cell edits waiting to be applied to a simulation. Any number of threads
+// may record edits without locking, while the simulation is being stepped;
+// the simulation takes them all between generations and applies them in
+// the order they were recorded (see Simulation::applyEdits()).
+// 
+
+#include <atomic>
+#include <vector>
+
+
+namespace gol
+{
+
+// Alive state to set for a cell.
+struct CellEdit
+{
+	int x;
+	int y;
+	bool alive;
+};
+
+class EditJournal
+{
+public:
+	EditJournal();
+	~EditJournal();
+
+	EditJournal(const EditJournal&) = delete;
+	EditJournal& operator=(const EditJournal&) = delete;
+
+	// Record an edit. Safe to call from any thread.
+	void record(int x, int y, bool alive);
+
+	// Record a batch of edits, kept together in order. Safe to call from any thread.
+	void record(std::vector<CellEdit>&& edits);
+
+	// Returns true if no edits are waiting.
+	inline bool empty() const { return m_head.load(std::memory_order_acquire) == nullptr; }
+
+	// Take every edit waiting, appending them to the vector given in the order they were recorded.
+	// Only one thread may take edits at a time.
+	void take(std::vector<CellEdit>& out_edits);
+
+	// Drop every edit waiting.
+	void clear();
+
+private:
+	struct Batch
+	{
+		std::vector<CellEdit> edits;
+		Batch* next; //> Batch recorded before this one.
+	};
+
+	std::atomic<Batch*> m_head; //> Latest batch recorded.
+
+	// Internal: Push a batch onto m_head.
+	void push(Batch* batch);
+};
+
+}
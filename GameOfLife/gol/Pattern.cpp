@@ -0,0 +1,313 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/Pattern.cpp
+// 
+// Implements class gol::Pattern
+// 
+
+#include "Pattern.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <limits>
+#include <cctype>
+
+using namespace gol;
+
+
+// Coordinates of cells in a pattern, and the runs of RLE, must stay below this
+static const int MAX_COORD = std::numeric_limits<int>::max();
+
+
+// Remove whitespace from both ends of a line.
+static std::string trim(const std::string& line)
+{
+	size_t first = line.find_first_not_of(" \t\r\n");
+	if (first == std::string::npos)
+		return std::string();
+	size_t last = line.find_last_not_of(" \t\r\n");
+	return line.substr(first, last - first + 1);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+Pattern::Pattern()
+	: m_width(0)
+	, m_height(0)
+	, m_stride(0)
+	, m_cellCount(0)
+{
+
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Pattern::load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cerr << "could not open pattern file " << path << "!" << std::endl;
+		return false;
+	}
+
+	if (!this->parse(file))
+	{
+		std::cerr << "could not parse pattern file " << path << "!" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Pattern::parse(std::istream& in)
+{
+	m_name.clear();
+	m_rule.clear();
+
+	// Comments come first, RLE with '#' and plaintext with '!'
+	std::string line;
+	while (std::getline(in, line))
+	{
+		line = trim(line);
+		if (line.empty())
+			continue;
+
+		if (line[0] == '#' || line[0] == '!')
+		{
+			// Names are given as "#N name" or "!Name: name"
+			if (line.compare(0, 2, "#N") == 0)
+				m_name = trim(line.substr(2));
+			else if (line.compare(0, 6, "!Name:") == 0)
+				m_name = trim(line.substr(6));
+			continue;
+		}
+		break;
+	}
+
+	std::vector<CellSpan> spans;
+	bool parsed;
+	if (line.empty())
+		parsed = false;
+	else if (line[0] == 'x' && line.find('=') != std::string::npos)
+		parsed = this->parseRLE(line, in, spans);
+	else
+		parsed = this->parsePlaintext(line, in, spans);
+
+	this->setSpans(parsed ? spans : std::vector<CellSpan>());
+	return parsed;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Pattern::parseRLE(const std::string& header, std::istream& in, std::vector<CellSpan>& out_spans)
+{
+	// Header is "x = m, y = n, rule = B3/S23", only the rule is needed
+	size_t iRule = header.find("rule");
+	if (iRule != std::string::npos)
+	{
+		size_t iValue = header.find('=', iRule);
+		if (iValue != std::string::npos)
+			m_rule = trim(header.substr(iValue + 1, header.find(',', iValue) - iValue - 1));
+	}
+
+	int x = 0;
+	int y = 0;
+	int run = 0;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		for (char c : line)
+		{
+			if (std::isdigit(static_cast<unsigned char>(c)))
+			{
+				if (run > (MAX_COORD - (c - '0')) / 10)
+					return false; // error - run count too large
+				run = run * 10 + (c - '0');
+				continue;
+			}
+
+			const int count = (run > 0) ? run : 1;
+			run = 0;
+			if (c == 'b' || c == '.')
+			{
+				if (count > MAX_COORD - x)
+					return false; // error - row too wide
+				x += count;
+			}
+			else if (c == '$')
+			{
+				if (count > MAX_COORD - y)
+					return false; // error - too many rows
+				x = 0;
+				y += count;
+			}
+			else if (c == '!')
+			{
+				return true;
+			}
+			else if (std::isalpha(static_cast<unsigned char>(c)))
+			{
+				if (count > MAX_COORD - x)
+					return false; // error - row too wide
+
+				// Every state besides dead is alive
+				if (!out_spans.empty() && out_spans.back().y == y && out_spans.back().x + out_spans.back().length == x)
+					out_spans.back().length += count;
+				else
+					out_spans.push_back({ x, y, count });
+				x += count;
+			}
+			else if (!std::isspace(static_cast<unsigned char>(c)))
+			{
+				return false; // error - unexpected character
+			}
+		}
+	}
+
+	// Missing '!' at the end is tolerated
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Pattern::parsePlaintext(const std::string& first, std::istream& in, std::vector<CellSpan>& out_spans)
+{
+	std::string line = first;
+	int y = 0;
+	do
+	{
+		if (!line.empty() && line[0] == '!')
+			continue;
+
+		for (int x = 0; x < static_cast<int>(line.size()); x++)
+		{
+			const char c = line[x];
+			if (c == 'O' || c == '*')
+			{
+				if (!out_spans.empty() && out_spans.back().y == y && out_spans.back().x + out_spans.back().length == x)
+					out_spans.back().length++;
+				else
+					out_spans.push_back({ x, y, 1 });
+			}
+			else if (c != '.' && !std::isspace(static_cast<unsigned char>(c)))
+			{
+				return false; // error - unexpected character
+			}
+		}
+		y++;
+	}
+	while (std::getline(in, line));
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Pattern::setSpans(const std::vector<CellSpan>& spans)
+{
+	int width = 0;
+	int height = 0;
+	size_t cellCount = 0;
+	for (const CellSpan& span : spans)
+	{
+		width = std::max(width, span.x + span.length);
+		height = std::max(height, span.y + 1);
+		cellCount += span.length;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_stride = 0;
+	m_cellCount = cellCount;
+	m_bitmap.clear();
+	m_spans = spans;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Pattern::randomize(int width, int height, float density, uint64_t seed)
+{
+	m_name.clear();
+	m_rule.clear();
+	m_width = std::max(width, 0);
+	m_height = std::max(height, 0);
+	m_stride = (static_cast<size_t>(m_width) + 63) / 64;
+	m_cellCount = 0;
+	m_bitmap.assign(m_stride * m_height, 0);
+	m_spans.clear();
+
+	std::mt19937_64 rng(seed);
+	std::bernoulli_distribution alive(std::min(std::max(density, 0.f), 1.f));
+	for (int y = 0; y < m_height; y++)
+	{
+		uint64_t* row = &m_bitmap[m_stride * y];
+		for (int x = 0; x < m_width; x++)
+		{
+			if (alive(rng))
+			{
+				row[x / 64] |= uint64_t(1) << (x % 64);
+				m_cellCount++;
+			}
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Pattern::place(Simulation& sim, int x, int y) const
+{
+	if (m_cellCount == 0)
+		return;
+
+	if (!m_spans.empty())
+		sim.stampCells(m_spans, x, y, Simulation::StampOr);
+	else
+		sim.stampCells(m_bitmap.data(), m_width, m_height, m_stride, x, y, Simulation::StampOr);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Pattern::getCell(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+		return false;
+
+	if (m_bitmap.empty())
+	{
+		// Spans are in reading order, find the last one starting at or before the cell
+		auto it = std::upper_bound(m_spans.begin(), m_spans.end(), CellSpan{ x, y, 0 }, [](const CellSpan& a, const CellSpan& b) {
+			return (a.y != b.y) ? (a.y < b.y) : (a.x < b.x);
+		});
+		if (it == m_spans.begin())
+			return false;
+		--it;
+		return it->y == y && x < it->x + it->length;
+	}
+	return ((m_bitmap[m_stride * y + x / 64] >> (x % 64)) & 1) != 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/Pattern.hpp
+//
+// class gol::Pattern
+// 
+// A rectangle of cells to place into a simulation, read from a pattern
+// file (RLE or plaintext) or filled with a random soup. Patterns read from
+// files keep their runs of alive cells, so large sparse patterns stay
+// small. Random soups are kept as a bitmap, one bit per cell, rows of
+// 64-bit words as used by Simulation::stampCells().
+// 
+
+#include "Simulation.hpp"
+#include <string>
+#include <istream>
+#include <vector>
+#include <cstdint>
+
+
+namespace gol
+{
+
+class Pattern
+{
+public:
+	Pattern();
+
+	// Load a pattern file in RLE (.rle) or plaintext (.cells) format.
+	// Returns true if the file was read and parsed successfully.
+	bool load(const std::string& path);
+
+	// Parse a pattern from RLE or plaintext formatted text. The format is detected from its header.
+	// Returns true if parsed successfully.
+	bool parse(std::istream& in);
+
+	// Fill a width by height rectangle with random cells, each alive with the probability given by density.
+	// The same seed always gives the same soup.
+	void randomize(int width, int height, float density, uint64_t seed);
+
+	// Set alive cells of the pattern in the simulation, with its top-left corner at {x,y}.
+	void place(Simulation& sim, int x, int y) const;
+
+	// Get alive state of cell at {x,y}, relative to the top-left corner of the pattern.
+	bool getCell(int x, int y) const;
+
+	// Get width of the pattern in cells.
+	inline int getWidth() const { return m_width; }
+
+	// Get height of the pattern in cells.
+	inline int getHeight() const { return m_height; }
+
+	// Get number of alive cells in the pattern.
+	inline size_t getCellCount() const { return m_cellCount; }
+
+	// Get name of the pattern, from the file's comments. Empty if not named.
+	inline const std::string& getName() const { return m_name; }
+
+	// Get rule-string given in the pattern file. Empty if not given.
+	inline const std::string& getRule() const { return m_rule; }
+
+	// Get runs of alive cells of a pattern read from a file, in reading order. Empty for random soups.
+	inline const std::vector<CellSpan>& getSpans() const { return m_spans; }
+
+	// Get bitmap of a random soup's cells, with getStride() words per row. Empty for patterns read from files.
+	inline const uint64_t* getBitmap() const { return m_bitmap.data(); }
+
+	// Get number of 64-bit words per row of the bitmap.
+	inline size_t getStride() const { return m_stride; }
+
+private:
+	std::string m_name;
+	std::string m_rule;
+	int m_width;
+	int m_height;
+	size_t m_stride;
+	size_t m_cellCount;
+	std::vector<uint64_t> m_bitmap;  //> Cells of a random soup.
+	std::vector<CellSpan> m_spans;   //> Cells of a pattern read from a file.
+
+	// Internal: Parse RLE lines, starting with the header line.
+	bool parseRLE(const std::string& header, std::istream& in, std::vector<CellSpan>& out_spans);
+
+	// Internal: Parse plaintext lines, starting with the first row of cells.
+	bool parsePlaintext(const std::string& first, std::istream& in, std::vector<CellSpan>& out_spans);
+
+	// Internal: Set the pattern's cells to the spans of alive cells given, in reading order.
+	void setSpans(const std::vector<CellSpan>& spans);
+};
+
+}
@@ -0,0 +1,203 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/PopulationPyramid.cpp
+// 
+// Implements class gol::PopulationPyramid
+// 
+
+#include "PopulationPyramid.hpp"
+
+#include <algorithm>
+
+using namespace gol;
+
+
+//////////////////////////////////////////////////////////////////////
+PopulationPyramid::PopulationPyramid()
+	: m_levels(LEVELS)
+	, m_total(0)
+{
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void PopulationPyramid::add(int column, int row, int delta)
+{
+	if (delta == 0)
+		return;
+
+	for (int level = 0; level < LEVELS; level++)
+	{
+		auto& map = m_levels[level];
+		const uint64_t key = toKey(toLevel(column, level), toLevel(row, level));
+		auto it = map.find(key);
+		const unsigned int before = (it != map.end()) ? it->second : 0;
+		const unsigned int after = static_cast<unsigned int>(static_cast<int>(before) + delta);
+
+		if (after == 0)
+		{
+			if (it != map.end())
+				map.erase(it);
+		}
+		else if (it != map.end())
+		{
+			it->second = after;
+		}
+		else
+		{
+			map.emplace(key, after);
+		}
+
+		if (level == 0 && (before == 0) != (after == 0))
+		{
+			// Chunk became populated or empty, update extent
+			const int change = (after != 0) ? 1 : -1;
+			if ((m_columns[column] += change) == 0)
+				m_columns.erase(column);
+			if ((m_rows[row] += change) == 0)
+				m_rows.erase(row);
+		}
+	}
+
+	m_total = static_cast<unsigned int>(static_cast<int>(m_total) + delta);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void PopulationPyramid::clear()
+{
+	for (auto& map : m_levels)
+		map.clear();
+	m_columns.clear();
+	m_rows.clear();
+	m_total = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+unsigned int PopulationPyramid::getPopulation(int level, int column, int row) const
+{
+	if (level < 0 || level >= LEVELS)
+		return 0;
+
+	const auto& map = m_levels[level];
+	auto it = map.find(toKey(column, row));
+	return (it != map.end()) ? it->second : 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+unsigned int PopulationPyramid::getRegionPopulation(int left, int top, int right, int bottom) const
+{
+	if (left > right || top > bottom)
+		return 0;
+
+	// Start from the top level regions overlapping the bounds
+	const int level = LEVELS - 1;
+	unsigned int population = 0;
+	for (int row = toLevel(top, level); row <= toLevel(bottom, level); row++)
+		for (int column = toLevel(left, level); column <= toLevel(right, level); column++)
+			population += this->queryRegion(level, column, row, left, top, right, bottom);
+	return population;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void PopulationPyramid::forEachRegionIn(int level, int left, int top, int right, int bottom, const std::function<void(int, int, unsigned int)>& fn) const
+{
+	if (left > right || top > bottom || level < 0 || level >= LEVELS)
+		return;
+
+	const auto& map = m_levels[level];
+	const int colLeft = toLevel(left, level);
+	const int colRight = toLevel(right, level);
+	const int rowTop = toLevel(top, level);
+	const int rowBottom = toLevel(bottom, level);
+	const uint64_t count = static_cast<uint64_t>(colRight - colLeft + 1) * static_cast<uint64_t>(rowBottom - rowTop + 1);
+
+	if (count > map.size())
+	{
+		for (const auto& it : map)
+		{
+			const int column = static_cast<int32_t>(it.first >> 32);
+			const int row = static_cast<int32_t>(it.first & 0xFFFFFFFF);
+			if (column >= colLeft && column <= colRight && row >= rowTop && row <= rowBottom)
+				fn(column, row, it.second);
+		}
+		return;
+	}
+
+	for (int row = rowTop; row <= rowBottom; row++)
+	{
+		for (int column = colLeft; column <= colRight; column++)
+		{
+			auto it = map.find(toKey(column, row));
+			if (it != map.end())
+				fn(column, row, it->second);
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool PopulationPyramid::getBounds(int& out_left, int& out_top, int& out_right, int& out_bottom) const
+{
+	if (m_columns.empty())
+		return false;
+
+	out_left   = m_columns.begin()->first;
+	out_right  = m_columns.rbegin()->first;
+	out_top    = m_rows.begin()->first;
+	out_bottom = m_rows.rbegin()->first;
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+unsigned int PopulationPyramid::queryRegion(int level, int column, int row, int left, int top, int right, int bottom) const
+{
+	const unsigned int population = this->getPopulation(level, column, row);
+	if (population == 0)
+		return 0;
+
+	// Chunks spanned by this region
+	const int64_t span = int64_t(1) << (level * 2);
+	const int64_t regionLeft   = column * span;
+	const int64_t regionTop    = row * span;
+	const int64_t regionRight  = regionLeft + span - 1;
+	const int64_t regionBottom = regionTop + span - 1;
+
+	if (regionRight < left || regionLeft > right || regionBottom < top || regionTop > bottom)
+		return 0;
+	if (regionLeft >= left && regionRight <= right && regionTop >= top && regionBottom <= bottom)
+		return population;
+
+	// Partially covered, sum the 4x4 regions below
+	unsigned int sum = 0;
+	for (int y = 0; y < 4; y++)
+		for (int x = 0; x < 4; x++)
+			sum += this->queryRegion(level - 1, column * 4 + x, row * 4 + y, left, top, right, bottom);
+	return sum;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/PopulationPyramid.hpp
+//
+// class gol::PopulationPyramid
+// 
+// Populations of chunks, summed into regions of 4x4 chunks, then regions
+// of 4x4 of those, and so on. Kept up to date as chunk populations change,
+// so the populated extent of the universe and the population of large
+// regions are known without visiting every chunk.
+// 
+
+#include <unordered_map>
+#include <vector>
+#include <map>
+#include <functional>
+#include <cstdint>
+
+
+namespace gol
+{
+
+class PopulationPyramid
+{
+public:
+	// Number of levels. Level 0 holds chunks, each level above holds regions of 4x4 regions below.
+	// Top level regions span 4^12 chunks, which covers every chunk position.
+	static const int LEVELS = 13;
+
+	PopulationPyramid();
+
+	// Add to population of chunk at {column,row}. Delta may be negative.
+	void add(int column, int row, int delta);
+
+	// Remove all populations.
+	void clear();
+
+	// Get population of a region at the level given. Region {column,row} spans 4^level chunks per side.
+	unsigned int getPopulation(int level, int column, int row) const;
+
+	// Get population of chunks within the bounds given (inclusive, in chunk coordinates).
+	unsigned int getRegionPopulation(int left, int top, int right, int bottom) const;
+
+	// Call fn with {column,row} and population of each populated region at the level given, overlapping the bounds given
+	// (inclusive, in chunk coordinates). Visits every populated region of the level instead of every position within the bounds
+	// when there are fewer of those.
+	void forEachRegionIn(int level, int left, int top, int right, int bottom, const std::function<void(int, int, unsigned int)>& fn) const;
+
+	// Get bounds of populated chunks (inclusive, in chunk coordinates).
+	// Returns false if no chunk is populated.
+	bool getBounds(int& out_left, int& out_top, int& out_right, int& out_bottom) const;
+
+	// Get total population.
+	inline unsigned int getTotal() const { return m_total; }
+
+private:
+	// Internal: Get region coordinate at the level given, containing chunk coordinate v.
+	static inline int toLevel(int v, int level) {
+		// Floor division by 4^level, also for negative coordinates
+		return (v >= 0) ? (v >> (level * 2)) : ~((~v) >> (level * 2));
+	}
+
+	// Internal: Get map key of a region.
+	static inline uint64_t toKey(int column, int row) {
+		return (static_cast<uint64_t>(static_cast<uint32_t>(column)) << 32) | static_cast<uint32_t>(row);
+	}
+
+	// Internal: Sum populations of region {column,row} at the level given, within the bounds given.
+	unsigned int queryRegion(int level, int column, int row, int left, int top, int right, int bottom) const;
+
+	std::vector<std::unordered_map<uint64_t, unsigned int>> m_levels;
+	std::map<int, unsigned int> m_columns; //> Populated chunks per column.
+	std::map<int, unsigned int> m_rows;    //> Populated chunks per row.
+	unsigned int m_total;
+};
+
+}
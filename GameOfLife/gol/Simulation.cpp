@@ -31,24 +31,134 @@
 #include "Simulation.hpp"
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <set>
+#include <bitset>
+#include <array>
+#include <map>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 
 using namespace gol;
 
 
+// Get key of the index block holding chunk {col,row}.
+static inline uint64_t chunkIndexKey(int col, int row)
+{
+	const int BLOCK = Simulation::INDEX_BLOCK_SIZE;
+	int x = (col < 0) ? (col + 1) / BLOCK - 1 : col / BLOCK;
+	int y = (row < 0) ? (row + 1) / BLOCK - 1 : row / BLOCK;
+	return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+
+// Get mask of bits [first,last) of a 64-bit word, clamped to the word.
+static inline uint64_t bitRange(int first, int last)
+{
+	first = std::max(first, 0);
+	last = std::min(last, 64);
+	if (first >= last)
+		return 0;
+	const uint64_t below = (last == 64) ? ~uint64_t(0) : (uint64_t(1) << last) - 1;
+	return below & (~uint64_t(0) << first);
+}
+
+
+// Get index of the lowest set bit of a 64-bit word, which must not be 0.
+static inline int lowestBit(uint64_t bits)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, bits);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctzll(bits);
+#endif
+}
+
+
+// Get 64 cells of a bitmap row from cell "first" on (which may be negative), cells outside the row being dead.
+static inline uint64_t readBitmapRow(const uint64_t* row, int width, int first)
+{
+	const int word = (first < 0) ? (first + 1) / 64 - 1 : first / 64;
+	const int shift = first - word * 64;
+	const int words = (width + 63) / 64;
+	const uint64_t low = (word >= 0 && word < words) ? row[word] : 0;
+	const uint64_t high = (word + 1 >= 0 && word + 1 < words) ? row[word + 1] : 0;
+	const uint64_t bits = (shift == 0) ? low : (low >> shift) | (high << (64 - shift));
+	return bits & bitRange(-first, width - first);
+}
+
+
+// Set 64 cells of a bitmap row from cell "first" on (which may be negative) alive, where bits are set.
+// Cells outside the row are ignored.
+static inline void writeBitmapRow(uint64_t* row, int width, int first, uint64_t bits)
+{
+	bits &= bitRange(-first, width - first);
+	if (bits == 0)
+		return;
+
+	const int word = (first < 0) ? (first + 1) / 64 - 1 : first / 64;
+	const int shift = first - word * 64;
+	const int words = (width + 63) / 64;
+	if (word >= 0 && word < words)
+		row[word] |= bits << shift;
+	if (shift != 0 && word + 1 >= 0 && word + 1 < words)
+		row[word + 1] |= bits >> (64 - shift);
+}
+
+
+// Get rows of a chunk within an area of width*height cells, given the chunk's top left cell relative to the area.
+static inline void areaRows(int chunkX, int chunkY, int width, int height, uint64_t out_area[Chunk::CHUNK_SIZE])
+{
+	const uint64_t columns = bitRange(-chunkX, width - chunkX);
+	for (int i = 0; i < static_cast<int>(Chunk::CHUNK_SIZE); i++)
+		out_area[i] = (chunkY + i >= 0 && chunkY + i < height) ? columns : 0;
+}
+
+
 //////////////////////////////////////////////////////////////////////
 Simulation::Simulation()
-	: m_generation(0)
-	, m_chunkCount(0)
+	: m_chunkCount(0)
+	, m_sparseChunkCount(0)
+	, m_denseChunkCount(0)
+	, m_periodicChunkCount(0)
+	, m_allocatedChunkCount(0)
+	, m_compressedChunkCount(0)
+	, m_residentCellBytes(0)
+	, m_compressedCellBytes(0)
 	, m_cellCount(0)
+	, m_births(0)
+	, m_deaths(0)
+	, m_generation(0)
 	, m_ruleset(Ruleset::GameOfLife)
+	, m_memoryBudget(0)
+	, m_boundsValid(false)
+	, m_boundsEmpty(true)
+	, m_boundsLeft(0)
+	, m_boundsTop(0)
+	, m_boundsRight(0)
+	, m_boundsBottom(0)
+	, m_worldHash(0)
+	, m_worldHashes(MAX_WORLD_PERIOD)
+	, m_worldHashCount(0)
+	, m_worldCandidate(0)
+	, m_worldMatches(0)
+	, m_worldPeriod(0)
+	, m_escapeTracking(true)
+	, m_escapeeCellCount(0)
+	, m_escapeeBirths(0)
+	, m_escapeeDeaths(0)
 	, m_multithreaded(true)
 	, m_availableThreads(std::thread::hardware_concurrency())
 	, m_ccWorking(0)
-	, m_ccCellCount(0)
-	, m_births(0)
-	, m_deaths(0)
 	, m_ccTask(CCTask_Update)
+	, m_ccCellCount(0)
 {
 	// Initialize multithreaded mode
 	this->setMultithreadMode(m_multithreaded);
@@ -74,7 +184,36 @@ void Simulation::reset(bool resetGeneration)
 		for (auto itRow : itCol.second)
 			delete itRow.second;
 	m_chunks.clear();
+	m_chunkIndex.clear();
 	m_chunkCount = 0;
+	m_cellCount = 0;
+	m_births = 0;
+	m_deaths = 0;
+	m_sparseChunkCount = 0;
+	m_denseChunkCount = 0;
+	m_periodicChunkCount = 0;
+	m_allocatedChunkCount = 0;
+	m_compressedChunkCount = 0;
+	m_residentCellBytes = 0;
+	m_compressedCellBytes = 0;
+	m_chunkStore.clear();
+	m_compressedUses.clear();
+	m_chunkPager.clear();
+	m_pyramid.clear();
+	m_boundsValid = false;
+	m_snapshotBlocks.reset();
+	m_snapshotChanges.clear();
+	m_edits.clear();
+	m_profile.clear();
+
+	m_escapees.clear();
+	m_spaceships.clear();
+	m_escapeeCellCount = 0;
+	m_escapeeBirths = 0;
+	m_escapeeDeaths = 0;
+
+	m_worldHash = 0;
+	this->resetWorldPeriod(true);
 
 	if (resetGeneration)
 		m_generation = 0;
@@ -84,14 +223,66 @@ void Simulation::reset(bool resetGeneration)
 //////////////////////////////////////////////////////////////////////
 void Simulation::step()
 {
+	// Time each phase, from the end of the previous one
+	StepProfile::Clock::time_point phaseStart = StepProfile::Clock::now();
+	auto endPhase = [this, &phaseStart](StepProfile::EPhase phase) {
+		const StepProfile::Clock::time_point now = StepProfile::Clock::now();
+		m_stepSample.phases[phase] += StepProfile::seconds(phaseStart, now);
+		phaseStart = now;
+	};
+	m_stepSample.clear(m_ccWorkers.size());
+
+	// Set cells edited since the last generation
+	this->applyEdits();
+	endPhase(StepProfile::Edits);
+
+	// Return escaped spaceships about to meet other cells
+	this->checkEscapees();
+	endPhase(StepProfile::Escapees);
+
 	// Check if new chunks need to be made
 	this->checkForNewChunks();
+	endPhase(StepProfile::NewChunks);
+
+	// Chunks sleeping for a long time are compressed every so often
+	// Buffers no longer used by any chunk are dropped at the same time
+	if (m_generation % COMPRESS_CHECK_INTERVAL == 0)
+	{
+		m_compressedUses.clear();
+		for (auto itCol : m_chunks)
+		{
+			for (auto itRow : itCol.second)
+			{
+				Chunk* chunk = itRow.second;
+				chunk->compressCells();
+				if (chunk->m_compressed != nullptr)
+					m_compressedUses[chunk->m_compressed.get()]++;
+			}
+		}
+		m_chunkStore.collect(m_compressedUses);
+		this->enforceMemoryBudget();
+	}
+
+	// Compressed chunks in periodic sleep are decompressed if their cycle is disturbed
+	// This is done before updating, as neighbouring chunks read their cells while updating
+	for (auto itCol : m_chunks)
+		for (auto itRow : itCol.second)
+			itRow.second->checkCompressedPhase();
+	endPhase(StepProfile::Compress);
 
 	if (m_multithreaded)
 	{
 		m_ccCellCount = 0;
 		m_ccBirths    = 0;
 		m_ccDeaths    = 0;
+		m_ccSparseChunks = 0;
+		m_ccDenseChunks  = 0;
+		m_ccPeriodicChunks = 0;
+		m_ccAllocatedChunks = 0;
+		m_ccCompressedChunks = 0;
+		m_ccResidentCellBytes = 0;
+		m_ccCompressedCellBytes = 0;
+		m_ccWorldHash = 0;
 
 		for (const auto task : { CCTask_Update, CCTask_Apply })
 		{
@@ -116,6 +307,7 @@ void Simulation::step()
 			m_ccSync.notify_all();
 
 			// Yield while workers finish up
+			const StepProfile::Clock::time_point waitStart = StepProfile::Clock::now();
 			while (m_ccWorking > 0 || !m_ccQueue.empty())
 			{
 				if (m_ccWorking == 0) //> Sanity check
@@ -123,11 +315,41 @@ void Simulation::step()
 
 				std::this_thread::yield();
 			}
+			m_stepSample.barrier += StepProfile::seconds(waitStart, StepProfile::Clock::now());
+
+			if (task == CCTask_Update)
+				endPhase(StepProfile::Update);
+		}
+
+		// Collect what workers measured, they are all waiting now
+		for (size_t i = 0; i < m_ccWorkers.size(); i++)
+		{
+			CCWorkerProfile& profile = m_ccProfiles[i];
+			m_stepSample.workerBusy[i] = profile.busyNanoseconds.exchange(0, std::memory_order_relaxed) * 1e-9f;
+			for (size_t mode = 0; mode < StepProfile::SLEEP_MODES; mode++)
+				m_stepSample.chunks[mode] += profile.chunks[mode].exchange(0, std::memory_order_relaxed);
 		}
 
 		m_cellCount = m_ccCellCount;
 		m_births    = m_ccBirths;
 		m_deaths    = m_ccDeaths;
+		m_sparseChunkCount = m_ccSparseChunks;
+		m_denseChunkCount  = m_ccDenseChunks;
+		m_periodicChunkCount = m_ccPeriodicChunks;
+		m_allocatedChunkCount = m_ccAllocatedChunks;
+		m_compressedChunkCount = m_ccCompressedChunks;
+		m_residentCellBytes = m_ccResidentCellBytes;
+		m_compressedCellBytes = m_ccCompressedCellBytes + m_chunkStore.getUniqueBytes();
+		m_worldHash ^= m_ccWorldHash;
+
+		// Update population pyramid and snapshot changes with chunks that changed
+		Chunk* chunk;
+		while (m_ccChanged.pop(chunk))
+		{
+			if (chunk->getBirths() > 0 || chunk->getDeaths() > 0)
+				m_pyramid.add(chunk->m_column, chunk->m_row, static_cast<int>(chunk->getBirths()) - static_cast<int>(chunk->getDeaths()));
+			this->snapshotChanged(chunk);
+		}
 	}
 	else // Single-threaded
 	{
@@ -138,6 +360,7 @@ void Simulation::step()
 		{
 			for (auto itRow : itCol.second)
 			{
+				m_stepSample.chunks[itRow.second->getSleepMode()]++;
 				itRow.second->updateCellStates();
 				births += itRow.second->getBirths();
 				deaths += itRow.second->getDeaths();
@@ -145,30 +368,294 @@ void Simulation::step()
 		}
 		m_births = births;
 		m_deaths = deaths;
+		endPhase(StepProfile::Update);
 
 		// Apply new cell states
 		int cellCount = 0;
+		int sparseChunks = 0;
+		int denseChunks = 0;
+		int periodicChunks = 0;
+		int allocatedChunks = 0;
+		int compressedChunks = 0;
+		size_t residentBytes = 0;
+		size_t compressedBytes = 0;
 		for (auto itCol : m_chunks)
 		{
 			for (auto itRow : itCol.second)
 			{
+				// Replace hash of chunks that changed in the world hash
+				const bool changed = (itRow.second->getBirths() > 0 || itRow.second->getDeaths() > 0);
+				const uint64_t hash = changed ? itRow.second->getPositionalHash() : 0;
 				itRow.second->applyCellStates();
+				if (changed)
+				{
+					m_worldHash ^= hash ^ itRow.second->getPositionalHash();
+					m_pyramid.add(itRow.second->m_column, itRow.second->m_row,
+						static_cast<int>(itRow.second->getBirths()) - static_cast<int>(itRow.second->getDeaths()));
+				}
+				if (itRow.second->isSnapshotStale())
+					this->snapshotChanged(itRow.second);
 				cellCount += itRow.second->getAliveCells();
+				if (itRow.second->getRepresentation() == Chunk::Sparse)
+					sparseChunks++;
+				else
+					denseChunks++;
+				if (itRow.second->getSleepMode() == Chunk::Periodic)
+					periodicChunks++;
+				if (itRow.second->hasCellStorage())
+					allocatedChunks++;
+				if (itRow.second->isCompressed())
+					compressedChunks++;
+				residentBytes += itRow.second->getResidentBytes();
+				compressedBytes += itRow.second->getCompressedBytes();
 			}
 		}
 		m_cellCount = cellCount;
+		m_sparseChunkCount = sparseChunks;
+		m_denseChunkCount = denseChunks;
+		m_periodicChunkCount = periodicChunks;
+		m_allocatedChunkCount = allocatedChunks;
+		m_compressedChunkCount = compressedChunks;
+		m_residentCellBytes = residentBytes;
+		m_compressedCellBytes = compressedBytes + m_chunkStore.getUniqueBytes();
 	}
+	endPhase(StepProfile::Apply);
 
 	// Check for chunks to be deleted
 	this->freeInactiveChunks();
+	endPhase(StepProfile::Free);
 
 	m_generation++;
+
+	// Escaped spaceships step along their known phases
+	this->countEscapees();
+
+	if (m_escapeTracking && m_generation % ESCAPE_CHECK_INTERVAL == 0)
+		this->findEscapees();
+	endPhase(StepProfile::Escapees);
+
+	this->checkWorldPeriod();
+	m_boundsValid = false;
+	endPhase(StepProfile::Period);
+
+	m_profile.record(m_stepSample);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::fastForward(unsigned int generations)
+{
+	generations = std::min(generations, std::numeric_limits<unsigned int>::max() - m_generation);
+	while (generations > 0)
+	{
+		unsigned int cycle = 1;
+		unsigned int skip = 0;
+		if (this->isStable())
+		{
+			cycle = this->getCycleLength(m_worldPeriod);
+			skip = std::min(generations, this->getEscapeeHorizon()) / cycle * cycle;
+		}
+
+		if (skip > 0)
+		{
+			// Chunks are the same after whole cycles, only escaped spaceships move on
+			m_generation += skip;
+			generations -= skip;
+			this->countEscapees();
+			m_boundsValid = false;
+		}
+		else
+		{
+			// Step a cycle at a time until escaped spaceships are clear again
+			for (unsigned int i = std::min(generations, cycle); i > 0; i--, generations--)
+				this->step();
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::checkWorldPeriod()
+{
+	// Record world hash, forgetting the one recorded MAX_WORLD_PERIOD generations ago
+	unsigned long long idx = m_worldHashCount++;
+	uint64_t& slot = m_worldHashes[idx % MAX_WORLD_PERIOD];
+	if (idx >= MAX_WORLD_PERIOD)
+	{
+		auto it = m_worldHashSeen.find(slot);
+		if (it != m_worldHashSeen.end() && it->second == idx - MAX_WORLD_PERIOD)
+			m_worldHashSeen.erase(it);
+	}
+	slot = m_worldHash;
+
+	// Period is the distance to the last time the world was in this state
+	unsigned int period = 0;
+	auto it = m_worldHashSeen.find(m_worldHash);
+	if (it != m_worldHashSeen.end())
+	{
+		period = static_cast<unsigned int>(idx - it->second);
+		it->second = idx;
+	}
+	else
+	{
+		m_worldHashSeen.emplace(m_worldHash, idx);
+	}
+
+	if (period == 0 || period != m_worldCandidate)
+	{
+		this->resetWorldPeriod();
+		m_worldCandidate = period;
+		if (period == 0)
+			return;
+	}
+
+	// Track bounds of alive chunks over the cycle, escaped spaceships must stay clear of them
+	for (auto itCol : m_chunks)
+	{
+		for (auto itRow : itCol.second)
+		{
+			if (itRow.second->m_aliveCells == 0)
+				continue;
+			if (m_worldLeft > m_worldRight)
+			{
+				m_worldLeft = m_worldRight = itCol.first;
+				m_worldTop = m_worldBottom = itRow.first;
+			}
+			m_worldLeft   = std::min(m_worldLeft, itCol.first);
+			m_worldRight  = std::max(m_worldRight, itCol.first);
+			m_worldTop    = std::min(m_worldTop, itRow.first);
+			m_worldBottom = std::max(m_worldBottom, itRow.first);
+		}
+	}
+
+	// Escape searches must also repeat before the whole simulation does
+	if (m_worldPeriod == 0 && ++m_worldMatches >= this->getCycleLength(period))
+		m_worldPeriod = period;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::resetWorldPeriod(bool clearHistory)
+{
+	m_worldCandidate = 0;
+	m_worldMatches = 0;
+	m_worldPeriod = 0;
+	m_worldLeft = m_worldTop = 0;
+	m_worldRight = m_worldBottom = -1;
+
+	if (clearHistory)
+	{
+		m_worldHashSeen.clear();
+		m_worldHashCount = 0;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+unsigned int Simulation::getCycleLength(unsigned int period) const
+{
+	if (!m_escapeTracking)
+		return period;
+	return period / std::gcd(period, ESCAPE_CHECK_INTERVAL) * ESCAPE_CHECK_INTERVAL;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+unsigned int Simulation::getEscapeeHorizon() const
+{
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+
+	// Escaped spaceship as a box moving at constant speed, loose enough to contain every phase
+	struct Mover { double left, top, right, bottom, vx, vy; };
+	static thread_local std::vector<Mover> movers;
+	movers.clear();
+	for (const Escapee& escapee : m_escapees)
+	{
+		unsigned int phase;
+		int x, y;
+		this->getEscapeeState(escapee, phase, x, y);
+		const Spaceship& ship = m_spaceships[escapee.ship];
+		Mover m;
+		m.left = m.top = std::numeric_limits<double>::infinity();
+		m.right = m.bottom = -m.left;
+		for (unsigned int i = 0; i < ship.getPeriod(); i++)
+		{
+			const Spaceship::Phase& shape = ship.getPhase(i);
+			m.left   = std::min(m.left, static_cast<double>(shape.left));
+			m.top    = std::min(m.top, static_cast<double>(shape.top));
+			m.right  = std::max(m.right, static_cast<double>(shape.right));
+			m.bottom = std::max(m.bottom, static_cast<double>(shape.bottom));
+		}
+		const double slackX = std::abs(ship.getDX()) * 2 + ESCAPE_MARGIN;
+		const double slackY = std::abs(ship.getDY()) * 2 + ESCAPE_MARGIN;
+		m.left   += x - slackX;
+		m.top    += y - slackY;
+		m.right  += x + slackX;
+		m.bottom += y + slackY;
+		m.vx = static_cast<double>(ship.getDX()) / ship.getPeriod();
+		m.vy = static_cast<double>(ship.getDY()) / ship.getPeriod();
+		movers.push_back(m);
+	}
+
+	// Find when a moving box first overlaps a still box, if ever
+	auto meet = [](const Mover& m, double vx, double vy, double l, double t, double r, double b) {
+		double tmin = 0.0;
+		double tmax = std::numeric_limits<double>::infinity();
+		const double axes[2][5] = {
+			{ m.left, m.right, vx, l, r },
+			{ m.top, m.bottom, vy, t, b },
+		};
+		for (const double* axis : axes)
+		{
+			if (axis[2] == 0.0)
+			{
+				if (axis[1] < axis[3] || axis[0] > axis[4])
+					return tmax;
+				continue;
+			}
+			double t0 = (axis[3] - axis[1]) / axis[2];
+			double t1 = (axis[4] - axis[0]) / axis[2];
+			tmin = std::max(tmin, std::min(t0, t1));
+			tmax = std::min(tmax, std::max(t0, t1));
+		}
+		return (tmin <= tmax) ? tmin : std::numeric_limits<double>::infinity();
+	};
+
+	double horizon = std::numeric_limits<double>::infinity();
+	for (size_t i = 0; i < movers.size(); i++)
+	{
+		const Mover& a = movers[i];
+
+		// Alive chunks over the cycle
+		if (m_worldLeft <= m_worldRight)
+		{
+			horizon = std::min(horizon, meet(a, a.vx, a.vy,
+				m_worldLeft * CHUNK_SIZE, m_worldTop * CHUNK_SIZE,
+				(m_worldRight + 1) * CHUNK_SIZE - 1, (m_worldBottom + 1) * CHUNK_SIZE - 1));
+		}
+
+		// Other escaped spaceships, relative to each other
+		for (size_t j = i + 1; j < movers.size(); j++)
+		{
+			const Mover& b = movers[j];
+			horizon = std::min(horizon, meet(a, a.vx - b.vx, a.vy - b.vy, b.left, b.top, b.right, b.bottom));
+		}
+	}
+
+	if (horizon >= std::numeric_limits<unsigned int>::max())
+		return std::numeric_limits<unsigned int>::max();
+	return static_cast<unsigned int>(horizon);
 }
 
 
 //////////////////////////////////////////////////////////////////////
-void Simulation::ccStartWorker(Simulation* sim)
+void Simulation::ccStartWorker(Simulation* sim, size_t index)
 {
+	// Measured locally while busy, handed over before waiting again
+	CCWorkerProfile& profile = sim->m_ccProfiles[index];
+	StepProfile::Clock::time_point busySince = StepProfile::Clock::now();
+	unsigned int chunks[StepProfile::SLEEP_MODES] = { 0 };
+
 	Chunk* chunk;
 	sim->m_ccWorking++;
 	while (sim->m_multithreaded)
@@ -176,12 +663,22 @@ void Simulation::ccStartWorker(Simulation* sim)
 		// Wait for workload
 		if (sim->m_ccQueue.empty())
 		{
+			const auto busy = StepProfile::Clock::now() - busySince;
+			profile.busyNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count(), std::memory_order_relaxed);
+			for (size_t mode = 0; mode < StepProfile::SLEEP_MODES; mode++)
+			{
+				if (chunks[mode] > 0)
+					profile.chunks[mode].fetch_add(chunks[mode], std::memory_order_relaxed);
+				chunks[mode] = 0;
+			}
+
 			std::unique_lock<std::mutex> lk(sim->m_ccGuard);
 			sim->m_ccWorking--;
 			sim->m_ccSync.wait(lk);
 			if (!sim->m_multithreaded)
 				break; //> Simulation multithreading was disabled while on standby
 			sim->m_ccWorking++;
+			busySince = StepProfile::Clock::now();
 		}
 
 		// Process next chunk in queue
@@ -191,17 +688,38 @@ void Simulation::ccStartWorker(Simulation* sim)
 			{
 			case CCTask_Update:
 				// Update cell states for next generation
+				chunks[chunk->getSleepMode()]++;
 				chunk->updateCellStates();
 				sim->m_ccBirths += chunk->getBirths();
 				sim->m_ccDeaths += chunk->getDeaths();
 				break;
 
 			case CCTask_Apply:
-				// Apply new cell states
+			{
+				// Apply new cell states, replacing hash of chunks that changed in the world hash
+				const bool changed = (chunk->getBirths() > 0 || chunk->getDeaths() > 0);
+				const uint64_t hash = changed ? chunk->getPositionalHash() : 0;
 				chunk->applyCellStates();
+				if (changed)
+					sim->m_ccWorldHash ^= hash ^ chunk->getPositionalHash();
+				if (changed || chunk->isSnapshotStale())
+					sim->m_ccChanged.push(chunk);
 				sim->m_ccCellCount += chunk->getAliveCells();
+				if (chunk->getRepresentation() == Chunk::Sparse)
+					sim->m_ccSparseChunks++;
+				else
+					sim->m_ccDenseChunks++;
+				if (chunk->getSleepMode() == Chunk::Periodic)
+					sim->m_ccPeriodicChunks++;
+				if (chunk->hasCellStorage())
+					sim->m_ccAllocatedChunks++;
+				if (chunk->isCompressed())
+					sim->m_ccCompressedChunks++;
+				sim->m_ccResidentCellBytes += chunk->getResidentBytes();
+				sim->m_ccCompressedCellBytes += chunk->getCompressedBytes();
 				break;
 			}
+			}
 		}
 	}
 }
@@ -216,9 +734,17 @@ void Simulation::setMultithreadMode(bool enable)
 		m_multithreaded = (m_availableThreads > 1);
 		if (m_multithreaded && m_ccWorkers.empty())
 		{
+			m_ccProfiles.reset(new CCWorkerProfile[m_availableThreads]);
+			for (size_t i = 0; i < m_availableThreads; i++)
+			{
+				m_ccProfiles[i].busyNanoseconds = 0;
+				for (std::atomic<unsigned int>& chunks : m_ccProfiles[i].chunks)
+					chunks = 0;
+			}
+
 			// Create and start worker threads
 			for (size_t i = 0; i < m_availableThreads; i++)
-				m_ccWorkers.push_back(std::thread(&ccStartWorker, this));
+				m_ccWorkers.push_back(std::thread(&ccStartWorker, this, i));
 		}
 	}
 	else
@@ -236,8 +762,390 @@ void Simulation::setMultithreadMode(bool enable)
 }
 
 
+//////////////////////////////////////////////////////////////////////
+void Simulation::setThreadCount(size_t threads)
+{
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+
+	this->setMultithreadMode(false);
+	m_availableThreads = threads;
+	this->setMultithreadMode(threads > 1);
+}
+
+
 //////////////////////////////////////////////////////////////////////
 void Simulation::setCell(int x, int y, bool alive)
+{
+	this->restoreEscapeesNear(x, y, x, y);
+	this->setChunkCell(x, y, alive);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::applyEdits()
+{
+	if (m_edits.empty())
+		return;
+
+	m_editBuffer.clear();
+	m_edits.take(m_editBuffer);
+
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	auto chunkCoord = [CHUNK_SIZE](int v) { return (v < 0) ? (v + 1) / CHUNK_SIZE - 1 : v / CHUNK_SIZE; };
+
+	// Group edits by chunk, each chunk's edits staying in the order they were made
+	std::stable_sort(m_editBuffer.begin(), m_editBuffer.end(), [&chunkCoord](const CellEdit& a, const CellEdit& b) {
+		const int colA = chunkCoord(a.x);
+		const int colB = chunkCoord(b.x);
+		if (colA != colB)
+			return colA < colB;
+		return chunkCoord(a.y) < chunkCoord(b.y);
+	});
+
+	for (size_t first = 0, last; first < m_editBuffer.size(); first = last)
+	{
+		const int col = chunkCoord(m_editBuffer[first].x);
+		const int row = chunkCoord(m_editBuffer[first].y);
+
+		// Find edits of this chunk and their bounds
+		bool births = false;
+		int left = m_editBuffer[first].x, right = left;
+		int top = m_editBuffer[first].y, bottom = top;
+		for (last = first; last < m_editBuffer.size(); last++)
+		{
+			const CellEdit& edit = m_editBuffer[last];
+			if (chunkCoord(edit.x) != col || chunkCoord(edit.y) != row)
+				break;
+			births = births || edit.alive;
+			left = std::min(left, edit.x);
+			right = std::max(right, edit.x);
+			top = std::min(top, edit.y);
+			bottom = std::max(bottom, edit.y);
+		}
+
+		this->restoreEscapeesNear(left, top, right, bottom);
+
+		// Chunks are only created to hold alive cells
+		Chunk* chunk = births ? this->createChunk(col, row) : this->getChunk(col, row);
+		if (chunk == nullptr)
+			continue;
+
+		// Remove chunk population and hash from world population and hash, then reapply them after the edits
+		const unsigned int population = chunk->getAliveCells();
+		m_cellCount -= population;
+		m_worldHash ^= chunk->getPositionalHash();
+
+		bool border = false;
+		for (size_t i = first; i < last; i++)
+		{
+			const int x = m_editBuffer[i].x - col * CHUNK_SIZE;
+			const int y = m_editBuffer[i].y - row * CHUNK_SIZE;
+			chunk->setCell(x, y, m_editBuffer[i].alive);
+			border = border || x == 0 || y == 0 || x == CHUNK_SIZE - 1 || y == CHUNK_SIZE - 1;
+		}
+
+		m_cellCount += chunk->getAliveCells();
+		m_worldHash ^= chunk->getPositionalHash();
+		m_pyramid.add(col, row, static_cast<int>(chunk->getAliveCells()) - static_cast<int>(population));
+		this->snapshotChanged(chunk);
+
+		if (border)
+			this->wakeNeighbours(chunk);
+	}
+
+	m_boundsValid = false;
+	this->resetWorldPeriod();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::stampCells(const uint64_t* bitmap, int width, int height, size_t stride, int x, int y, EStampMode mode)
+{
+	if (bitmap == nullptr || width <= 0 || height <= 0)
+		return;
+
+	static_assert(Chunk::CHUNK_SIZE == 64, "chunk rows are stamped as 64-bit words");
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	auto chunkCoord = [CHUNK_SIZE](int v) { return (v < 0) ? (v + 1) / CHUNK_SIZE - 1 : v / CHUNK_SIZE; };
+
+	this->restoreEscapeesNear(x, y, x + width - 1, y + height - 1);
+
+	uint64_t bits[Chunk::CHUNK_SIZE];
+	uint64_t area[Chunk::CHUNK_SIZE];
+	for (int row = chunkCoord(y); row <= chunkCoord(y + height - 1); row++)
+	{
+		for (int col = chunkCoord(x); col <= chunkCoord(x + width - 1); col++)
+		{
+			// Top left cell of the chunk in the bitmap
+			const int chunkX = col * CHUNK_SIZE - x;
+			const int chunkY = row * CHUNK_SIZE - y;
+			areaRows(chunkX, chunkY, width, height, area);
+			for (int i = 0; i < CHUNK_SIZE; i++)
+				bits[i] = area[i] ? readBitmapRow(bitmap + (chunkY + i) * stride, width, chunkX) : 0;
+			this->stampChunk(col, row, bits, area, mode);
+		}
+	}
+
+	m_boundsValid = false;
+	this->resetWorldPeriod();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::stampCells(const std::vector<CellSpan>& spans, int x, int y, EStampMode mode)
+{
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	auto chunkCoord = [CHUNK_SIZE](int v) { return (v < 0) ? (v + 1) / CHUNK_SIZE - 1 : v / CHUNK_SIZE; };
+	auto chunkKey = [](int col, int row) { return (static_cast<uint64_t>(static_cast<uint32_t>(col)) << 32) | static_cast<uint32_t>(row); };
+
+	// Gather stamped cells of each chunk, and the bounds of the runs
+	std::unordered_map<uint64_t, std::array<uint64_t, Chunk::CHUNK_SIZE>> chunkBits;
+	int left = 0, top = 0, right = -1, bottom = -1;
+	for (const CellSpan& span : spans)
+	{
+		if (span.length <= 0)
+			continue;
+
+		int cellX = span.x + x;
+		const int cellY = span.y + y;
+		if (right < left)
+		{
+			left = cellX;
+			top = cellY;
+			right = cellX + span.length - 1;
+			bottom = cellY;
+		}
+		left = std::min(left, cellX);
+		top = std::min(top, cellY);
+		right = std::max(right, cellX + span.length - 1);
+		bottom = std::max(bottom, cellY);
+
+		// Split the run at chunk borders
+		const int row = chunkCoord(cellY);
+		for (int length = span.length; length > 0;)
+		{
+			const int col = chunkCoord(cellX);
+			const int localX = cellX - col * CHUNK_SIZE;
+			const int count = std::min(length, CHUNK_SIZE - localX);
+			chunkBits[chunkKey(col, row)][cellY - row * CHUNK_SIZE] |= bitRange(localX, localX + count);
+			cellX += count;
+			length -= count;
+		}
+	}
+	if (right < left)
+		return;
+
+	this->restoreEscapeesNear(left, top, right, bottom);
+
+	// Chunks without runs within the bounds are cleared too
+	if (mode == StampSet)
+	{
+		this->forEachChunkIn(left, top, right, bottom, [&](const Chunk* chunk) {
+			chunkBits[chunkKey(chunk->m_column, chunk->m_row)];
+		});
+	}
+
+	uint64_t area[Chunk::CHUNK_SIZE];
+	for (const auto& itChunk : chunkBits)
+	{
+		const int col = static_cast<int32_t>(itChunk.first >> 32);
+		const int row = static_cast<int32_t>(itChunk.first & 0xFFFFFFFF);
+		areaRows(col * CHUNK_SIZE - left, row * CHUNK_SIZE - top, right - left + 1, bottom - top + 1, area);
+		this->stampChunk(col, row, itChunk.second.data(), area, mode);
+	}
+
+	m_boundsValid = false;
+	this->resetWorldPeriod();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::readCells(int x, int y, int width, int height, uint64_t* out_bitmap, size_t stride) const
+{
+	if (out_bitmap == nullptr || width <= 0 || height <= 0)
+		return;
+
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	const size_t words = (width + 63) / 64;
+	for (int i = 0; i < height; i++)
+		std::fill(out_bitmap + i * stride, out_bitmap + i * stride + words, 0);
+
+	uint64_t cells[Chunk::CHUNK_SIZE];
+	this->forEachChunkIn(x, y, x + width - 1, y + height - 1, [&](const Chunk* chunk) {
+		if (chunk->m_aliveCells == 0)
+			return;
+
+		// Top left cell of the chunk in the bitmap
+		const int chunkX = chunk->m_column * CHUNK_SIZE - x;
+		const int chunkY = chunk->m_row * CHUNK_SIZE - y;
+		chunk->packCells(cells);
+		for (int i = std::max(0, -chunkY); i < CHUNK_SIZE && chunkY + i < height; i++)
+			writeBitmapRow(out_bitmap + (chunkY + i) * stride, width, chunkX, cells[i]);
+	});
+
+	// Escaped spaceships are not in any chunk
+	std::vector<std::pair<int, int>> escapeeCells;
+	this->getEscapeeCells(escapeeCells);
+	for (const std::pair<int, int>& xy : escapeeCells)
+	{
+		const int cellX = xy.first - x;
+		const int cellY = xy.second - y;
+		if (cellX >= 0 && cellX < width && cellY >= 0 && cellY < height)
+			out_bitmap[cellY * stride + cellX / 64] |= uint64_t(1) << (cellX % 64);
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::forEachSpanIn(int left, int top, int right, int bottom, const std::function<void(const CellSpan&)>& fn) const
+{
+	if (left > right || top > bottom)
+		return;
+
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	auto chunkCoord = [CHUNK_SIZE](int v) { return (v < 0) ? (v + 1) / CHUNK_SIZE - 1 : v / CHUNK_SIZE; };
+
+	// Populated chunks and cells of escaped spaceships within the bounds, from the top row down
+	std::vector<const Chunk*> chunks;
+	this->forEachChunkIn(left, top, right, bottom, [&chunks](const Chunk* chunk) {
+		if (chunk->m_aliveCells > 0)
+			chunks.push_back(chunk);
+	});
+	std::sort(chunks.begin(), chunks.end(), [](const Chunk* a, const Chunk* b) {
+		return (a->m_row != b->m_row) ? a->m_row < b->m_row : a->m_column < b->m_column;
+	});
+
+	std::vector<std::pair<int, int>> escapeeCells;
+	this->getEscapeeCells(escapeeCells);
+	escapeeCells.erase(std::remove_if(escapeeCells.begin(), escapeeCells.end(), [&](const std::pair<int, int>& xy) {
+		return xy.first < left || xy.first > right || xy.second < top || xy.second > bottom;
+	}), escapeeCells.end());
+	std::sort(escapeeCells.begin(), escapeeCells.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+		return a.second < b.second;
+	});
+
+	// Cells of one chunk row at a time, by column
+	std::map<int, std::array<uint64_t, Chunk::CHUNK_SIZE>> band;
+	size_t nextChunk = 0;
+	size_t nextEscapee = 0;
+	while (nextChunk < chunks.size() || nextEscapee < escapeeCells.size())
+	{
+		int row = std::numeric_limits<int>::max();
+		if (nextChunk < chunks.size())
+			row = chunks[nextChunk]->m_row;
+		if (nextEscapee < escapeeCells.size())
+			row = std::min(row, chunkCoord(escapeeCells[nextEscapee].second));
+		const int bandTop = row * CHUNK_SIZE;
+
+		band.clear();
+		for (; nextChunk < chunks.size() && chunks[nextChunk]->m_row == row; nextChunk++)
+			chunks[nextChunk]->packCells(band[chunks[nextChunk]->m_column].data());
+		for (; nextEscapee < escapeeCells.size() && chunkCoord(escapeeCells[nextEscapee].second) == row; nextEscapee++)
+		{
+			const std::pair<int, int>& xy = escapeeCells[nextEscapee];
+			const int col = chunkCoord(xy.first);
+			band[col][xy.second - bandTop] |= uint64_t(1) << (xy.first - col * CHUNK_SIZE);
+		}
+
+		// Runs of each row, joined across chunk borders
+		for (int y = std::max(top, bandTop); y <= std::min(bottom, bandTop + CHUNK_SIZE - 1); y++)
+		{
+			CellSpan span = { 0, y, 0 };
+			for (const auto& itChunk : band)
+			{
+				const int chunkX = itChunk.first * CHUNK_SIZE;
+				uint64_t bits = itChunk.second[y - bandTop] & bitRange(left - chunkX, right - chunkX + 1);
+				while (bits != 0)
+				{
+					// Run from the lowest alive cell to the next dead cell above it
+					const int start = lowestBit(bits);
+					const uint64_t dead = ~(bits >> start);
+					const int end = (dead == 0) ? CHUNK_SIZE : start + lowestBit(dead);
+					bits = (end >= CHUNK_SIZE) ? 0 : bits & (~uint64_t(0) << end);
+
+					if (span.length > 0 && span.x + span.length == chunkX + start)
+					{
+						span.length += end - start;
+					}
+					else
+					{
+						if (span.length > 0)
+							fn(span);
+						span.x = chunkX + start;
+						span.length = end - start;
+					}
+				}
+			}
+			if (span.length > 0)
+				fn(span);
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::stampChunk(int col, int row, const uint64_t bits[Chunk::CHUNK_SIZE], const uint64_t area[Chunk::CHUNK_SIZE], EStampMode mode)
+{
+	uint64_t stamped = 0;
+	for (size_t i = 0; i < Chunk::CHUNK_SIZE; i++)
+		stamped |= bits[i];
+	if (stamped == 0 && mode != StampSet)
+		return;
+
+	// Chunks are only created to hold alive cells
+	Chunk* chunk = (stamped != 0 && mode != StampClear) ? this->createChunk(col, row) : this->getChunk(col, row);
+	if (chunk == nullptr)
+		return;
+
+	uint64_t cells[Chunk::CHUNK_SIZE];
+	chunk->packCells(cells);
+	for (size_t i = 0; i < Chunk::CHUNK_SIZE; i++)
+	{
+		switch (mode)
+		{
+		case StampSet:   cells[i] = (cells[i] & ~area[i]) | bits[i]; break;
+		case StampOr:    cells[i] |= bits[i]; break;
+		case StampClear: cells[i] &= ~bits[i]; break;
+		case StampXor:   cells[i] ^= bits[i]; break;
+		}
+	}
+
+	// Remove chunk population and hash from world population and hash, then reapply them after stamping
+	const unsigned int population = chunk->getAliveCells();
+	m_cellCount -= population;
+	m_worldHash ^= chunk->getPositionalHash();
+	const bool border = chunk->setCells(cells);
+	m_cellCount += chunk->getAliveCells();
+	m_worldHash ^= chunk->getPositionalHash();
+	m_pyramid.add(col, row, static_cast<int>(chunk->getAliveCells()) - static_cast<int>(population));
+	this->snapshotChanged(chunk);
+
+	if (border)
+		this->wakeNeighbours(chunk);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::restoreEscapeesNear(int left, int top, int right, int bottom)
+{
+	for (size_t i = 0; i < m_escapees.size();)
+	{
+		unsigned int phase;
+		int ox, oy;
+		this->getEscapeeState(m_escapees[i], phase, ox, oy);
+		const Spaceship::Phase& shape = m_spaceships[m_escapees[i].ship].getPhase(phase);
+		if (right >= ox + shape.left - ESCAPE_MARGIN && left <= ox + shape.right + ESCAPE_MARGIN &&
+			bottom >= oy + shape.top - ESCAPE_MARGIN && top <= oy + shape.bottom + ESCAPE_MARGIN)
+			this->restoreEscapee(i);
+		else
+			i++;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::setChunkCell(int x, int y, bool alive)
 {
 	Chunk* chunk = this->getChunkAt(x, y, alive);
 	//^ "alive": only auto-create chunk if we're activating a cell
@@ -249,34 +1157,59 @@ void Simulation::setCell(int x, int y, bool alive)
 	x %= Chunk::CHUNK_SIZE;
 	y %= Chunk::CHUNK_SIZE;
 
-	// Remove current chunk population from world population, then
-	// reapply cell count after changing cell
-	m_cellCount -= chunk->getAliveCells();
+	// Remove current chunk population and hash from world population and hash, then
+	// reapply them after changing cell
+	const unsigned int population = chunk->getAliveCells();
+	m_cellCount -= population;
+	m_worldHash ^= chunk->getPositionalHash();
 	chunk->setCell(x, y, alive);
+	this->snapshotChanged(chunk);
 	m_cellCount += chunk->getAliveCells();
+	m_worldHash ^= chunk->getPositionalHash();
+	m_pyramid.add(chunk->m_column, chunk->m_row, static_cast<int>(chunk->getAliveCells()) - static_cast<int>(population));
+	m_boundsValid = false;
+	this->resetWorldPeriod();
 
 	if (x == 0 || y == 0 || x == Chunk::CHUNK_SIZE - 1 || y == Chunk::CHUNK_SIZE - 1)
+		this->wakeNeighbours(chunk);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::wakeNeighbours(const Chunk* chunk)
+{
+	// Border cell changed, create/update neighbour chunks to BorderOnly
+	for (int ox = -1; ox <= 1; ox++)
 	{
-		// Border cell changed, create/update neighbour chunks to BorderOnly
-		for (int ox = -1; ox <= 1; ox++)
+		for (int oy = -1; oy <= 1; oy++)
 		{
-			for (int oy = -1; oy <= 1; oy++)
+			if (ox == 0 && oy == 0)
+				continue;
+			Chunk* n = this->createChunk(chunk->m_column + ox, chunk->m_row + oy);
+			if (n && n->m_sleepMode == Chunk::Sleeping && n->decompressCells())
 			{
-				if (ox == 0 && oy == 0)
-					continue;
-				Chunk* n = this->createChunk(chunk->m_column + ox, chunk->m_row + oy);
-				if (n && n->m_sleepMode == Chunk::Sleeping)
-					n->m_sleepMode = Chunk::BorderOnly;
+				n->m_sleepMode = Chunk::BorderOnly;
+				this->snapshotChanged(n);
 			}
 		}
 	}
-
 }
 
 
 //////////////////////////////////////////////////////////////////////
 bool Simulation::getCell(int x, int y) const
 {
+	// Check escaped spaceships
+	for (const Escapee& escapee : m_escapees)
+	{
+		unsigned int phase;
+		int ox, oy;
+		this->getEscapeeState(escapee, phase, ox, oy);
+		const Spaceship::Phase& shape = m_spaceships[escapee.ship].getPhase(phase);
+		if (std::binary_search(shape.cells.begin(), shape.cells.end(), std::make_pair(x - ox, y - oy)))
+			return true;
+	}
+
 	const Chunk* chunk = this->getChunkAt(x, y);
 	
 	if (chunk == nullptr)
@@ -312,6 +1245,9 @@ Chunk* Simulation::createChunk(int col, int row)
 		// Create new chunk
 		chunk = new Chunk(this, col, row);
 		itMapRow = mapCol.emplace(row, chunk).first;
+		m_stepSample.chunksCreated++;
+		m_chunkIndex[chunkIndexKey(col, row)].push_back(chunk);
+		this->snapshotChanged(chunk);
 
 		m_chunkCount++;
 	}
@@ -438,14 +1374,23 @@ void Simulation::getAllChunks(std::vector<const Chunk*>& out_vec) const
 //////////////////////////////////////////////////////////////////////
 void Simulation::setRuleset(const Ruleset& ruleset)
 {
+	// Escaped spaceships may not be spaceships under the new rules
+	while (!m_escapees.empty())
+		this->restoreEscapee(m_escapees.size() - 1);
+	m_spaceships.clear();
+
 	m_ruleset = ruleset;
+
+	// Cached transitions and recorded world states were evaluated with the previous rules
+	m_chunkMemo.clear();
+	this->resetWorldPeriod(true);
 }
 
 
 //////////////////////////////////////////////////////////////////////
 void Simulation::checkForNewChunks()
 {
-	static std::vector<std::pair<int, int>> newColRows;
+	static thread_local std::vector<std::pair<int, int>> newColRows;
 
 	// Search for column-rows to be created
 	for (auto itCol : m_chunks)
@@ -497,10 +1442,20 @@ void Simulation::freeInactiveChunks()
 			Chunk* chunk = itRow->second;
 			if (chunk->m_inactivity > Chunk::INACTIVITY_TIMEOUT)
 			{
+				// Remove chunk from its index block
+				auto itBlock = m_chunkIndex.find(chunkIndexKey(chunk->m_column, chunk->m_row));
+				auto& block = itBlock->second;
+				*std::find(block.begin(), block.end(), chunk) = block.back();
+				block.pop_back();
+				if (block.empty())
+					m_chunkIndex.erase(itBlock);
+				this->snapshotChanged(chunk);
+
 				// Delete chunk, remove row from map
 				delete chunk;
 				itRow = itCol->second.erase(itRow);
 				m_chunkCount--;
+				m_stepSample.chunksFreed++;
 			}
 			else
 			{
@@ -515,3 +1470,700 @@ void Simulation::freeInactiveChunks()
 			itCol++;
 	}
 }
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::enforceMemoryBudget()
+{
+	if (m_memoryBudget == 0)
+		return;
+
+	// Sleeping chunks still holding cells in memory can be paged out
+	size_t usedBytes = m_chunkStore.getUniqueBytes();
+	std::vector<Chunk*> candidates;
+	for (auto itCol : m_chunks)
+	{
+		for (auto itRow : itCol.second)
+		{
+			Chunk* chunk = itRow.second;
+			usedBytes += chunk->getResidentBytes() + chunk->getCompressedBytes();
+			if (chunk->m_sleepMode == Chunk::Sleeping && (chunk->m_compressed != nullptr || chunk->m_cells != nullptr))
+				candidates.push_back(chunk);
+		}
+	}
+	if (usedBytes <= m_memoryBudget)
+		return;
+
+	// Least recently active first
+	std::sort(candidates.begin(), candidates.end(), [](const Chunk* a, const Chunk* b) {
+		return a->m_sleepSteps > b->m_sleepSteps;
+	});
+
+	for (Chunk* chunk : candidates)
+	{
+		if (usedBytes <= m_memoryBudget)
+			break;
+
+		// A shared buffer is only freed once every chunk using it is paged out
+		const CompressedCells* compressed = chunk->m_compressed.get();
+		size_t freedBytes = chunk->getResidentBytes();
+		if (compressed != nullptr)
+			freedBytes += (sizeof(CompressedCells) + compressed->data.capacity()) / std::max<size_t>(1, m_compressedUses[compressed]);
+
+		chunk->pageOut();
+		if (chunk->isPaged())
+		{
+			usedBytes -= std::min(usedBytes, freedBytes);
+			if (compressed != nullptr)
+				m_compressedUses[compressed]--;
+		}
+	}
+
+	// Drop shared buffers no chunk uses anymore
+	m_chunkStore.collect(m_compressedUses);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::getEscapeeCells(std::vector<std::pair<int,int>>& out_vec) const
+{
+	for (const Escapee& escapee : m_escapees)
+	{
+		unsigned int phase;
+		int x, y;
+		this->getEscapeeState(escapee, phase, x, y);
+		for (const std::pair<int, int>& xy : m_spaceships[escapee.ship].getPhase(phase).cells)
+			out_vec.emplace_back(x + xy.first, y + xy.second);
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::setEscapeTracking(bool enable)
+{
+	m_escapeTracking = enable;
+	if (!enable)
+	{
+		while (!m_escapees.empty())
+			this->restoreEscapee(m_escapees.size() - 1);
+		m_escapeeBirths = 0;
+		m_escapeeDeaths = 0;
+	}
+
+	// Cycle length depends on escape searches
+	this->resetWorldPeriod();
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::countEscapees()
+{
+	m_escapeeCellCount = 0;
+	m_escapeeBirths = 0;
+	m_escapeeDeaths = 0;
+	for (const Escapee& escapee : m_escapees)
+	{
+		unsigned int phase;
+		int x, y;
+		this->getEscapeeState(escapee, phase, x, y);
+		const Spaceship& ship = m_spaceships[escapee.ship];
+		const Spaceship::Phase& previous = ship.getPhase((phase + ship.getPeriod() - 1) % ship.getPeriod());
+		m_escapeeBirths += previous.births;
+		m_escapeeDeaths += previous.deaths;
+		m_escapeeCellCount += static_cast<unsigned int>(ship.getPhase(phase).cells.size());
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::findEscapees()
+{
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+
+	// Cells gathered around a candidate chunk extend this far past its edges
+	const int WINDOW = CHUNK_SIZE / 2;
+
+	// Chunks with this many alive cells or less may hold escaping spaceships
+	const unsigned int CANDIDATE_CELLS = static_cast<unsigned int>(Spaceship::MAX_CELLS) * 2;
+
+	static thread_local std::vector<Chunk*> liveChunks;
+	static thread_local std::vector<std::pair<int, int>> cells;
+	static thread_local std::vector<size_t> clusters;
+	static thread_local Spaceship::CellList cluster;
+	std::set<std::pair<int, int>> visited; //> First cell of clusters already checked
+
+	liveChunks.clear();
+	for (auto itCol : m_chunks)
+		for (auto itRow : itCol.second)
+			if (itRow.second->m_aliveCells > 0)
+				liveChunks.push_back(itRow.second);
+
+	for (size_t c = 0; c < liveChunks.size(); c++)
+	{
+		Chunk* candidate = liveChunks[c];
+		if (candidate->m_aliveCells == 0 || candidate->m_aliveCells > CANDIDATE_CELLS)
+			continue;
+
+		// Gather alive cells in and around the candidate chunk
+		int left   = candidate->m_column * CHUNK_SIZE - WINDOW;
+		int top    = candidate->m_row * CHUNK_SIZE - WINDOW;
+		int right  = (candidate->m_column + 1) * CHUNK_SIZE - 1 + WINDOW;
+		int bottom = (candidate->m_row + 1) * CHUNK_SIZE - 1 + WINDOW;
+		bool crowded = false;
+		cells.clear();
+		for (int col = candidate->m_column - 1; col <= candidate->m_column + 1 && !crowded; col++)
+		{
+			for (int row = candidate->m_row - 1; row <= candidate->m_row + 1 && !crowded; row++)
+			{
+				const Chunk* chunk = this->getChunk(col, row);
+				if (chunk == nullptr || chunk->m_aliveCells == 0)
+					continue;
+				for (const std::pair<int, int>& xy : chunk->getCellCoords())
+				{
+					int x = col * CHUNK_SIZE + xy.first;
+					int y = row * CHUNK_SIZE + xy.second;
+					if (x >= left && x <= right && y >= top && y <= bottom)
+						cells.emplace_back(x, y);
+				}
+				crowded = (cells.size() > CANDIDATE_CELLS * 4);
+			}
+		}
+		if (crowded)
+			continue;
+
+		// Group cells close enough to affect each other (within two cells) into clusters
+		clusters.resize(cells.size());
+		for (size_t i = 0; i < cells.size(); i++)
+			clusters[i] = i;
+		auto findRoot = [](size_t i) {
+			while (clusters[i] != i)
+				i = clusters[i] = clusters[clusters[i]];
+			return i;
+		};
+		for (size_t i = 0; i < cells.size(); i++)
+		{
+			for (size_t j = i + 1; j < cells.size(); j++)
+			{
+				if (std::abs(cells[i].first - cells[j].first) <= 2 && std::abs(cells[i].second - cells[j].second) <= 2)
+					clusters[findRoot(i)] = findRoot(j);
+			}
+		}
+
+		for (size_t i = 0; i < cells.size(); i++)
+		{
+			if (findRoot(i) != i)
+				continue;
+
+			cluster.clear();
+			for (size_t j = 0; j < cells.size(); j++)
+				if (findRoot(j) == i)
+					cluster.push_back(cells[j]);
+			if (cluster.size() > Spaceship::MAX_CELLS)
+				continue;
+			std::sort(cluster.begin(), cluster.end());
+
+			int cl = cluster.front().first;
+			int cr = cl;
+			int ct = cluster.front().second;
+			int cb = ct;
+			for (const std::pair<int, int>& xy : cluster)
+			{
+				cl = std::min(cl, xy.first);
+				cr = std::max(cr, xy.first);
+				ct = std::min(ct, xy.second);
+				cb = std::max(cb, xy.second);
+			}
+
+			// Surrounding cells must be known and clear
+			if (cl - ESCAPE_CLEARANCE < left || cr + ESCAPE_CLEARANCE > right || ct - ESCAPE_CLEARANCE < top || cb + ESCAPE_CLEARANCE > bottom)
+				continue;
+			if (!visited.insert(cluster.front()).second)
+				continue;
+			bool clear = true;
+			for (size_t j = 0; j < cells.size() && clear; j++)
+			{
+				clear = (findRoot(j) == i)
+					|| cells[j].first  < cl - ESCAPE_CLEARANCE || cells[j].first  > cr + ESCAPE_CLEARANCE
+					|| cells[j].second < ct - ESCAPE_CLEARANCE || cells[j].second > cb + ESCAPE_CLEARANCE;
+			}
+			if (!clear)
+				continue;
+
+			// Check known spaceships first, then evolve the cluster to see if it is a new one
+			Escapee escapee;
+			int phase = -1;
+			for (size_t s = 0; s < m_spaceships.size() && phase < 0; s++)
+			{
+				phase = m_spaceships[s].findPhase(cluster, escapee.x, escapee.y);
+				escapee.ship = s;
+			}
+			if (phase < 0)
+			{
+				Spaceship ship;
+				if (!Spaceship::identify(cluster, m_ruleset, ship, escapee.x, escapee.y))
+					continue;
+				phase = 0;
+				escapee.ship = m_spaceships.size();
+				m_spaceships.push_back(std::move(ship));
+			}
+			escapee.phase = static_cast<unsigned int>(phase);
+			escapee.generation = m_generation;
+
+			// Spaceship must not be heading towards any other alive cells
+			// Cells of nearby chunks are checked individually, further chunks are checked as a whole
+			const Spaceship& ship = m_spaceships[escapee.ship];
+			auto heading = [&](int l, int t, int r, int b) {
+				// Find when the moving bounds of the spaceship overlap the bounds given (with clearance), if ever
+				double tmin = 0.0;
+				double tmax = std::numeric_limits<double>::infinity();
+				const int axes[2][5] = {
+					{ cl, cr, ship.getDX(), l - ESCAPE_CLEARANCE, r + ESCAPE_CLEARANCE },
+					{ ct, cb, ship.getDY(), t - ESCAPE_CLEARANCE, b + ESCAPE_CLEARANCE },
+				};
+				for (const int* axis : axes)
+				{
+					if (axis[2] == 0)
+					{
+						if (axis[1] < axis[3] || axis[0] > axis[4])
+							return false;
+						continue;
+					}
+					double t0 = static_cast<double>(axis[3] - axis[1]) / axis[2];
+					double t1 = static_cast<double>(axis[4] - axis[0]) / axis[2];
+					tmin = std::max(tmin, std::min(t0, t1));
+					tmax = std::min(tmax, std::max(t0, t1));
+				}
+				return tmin <= tmax;
+			};
+
+			bool escaping = true;
+			for (size_t k = 0; k < liveChunks.size() && escaping; k++)
+			{
+				const Chunk* chunk = liveChunks[k];
+				int kl = chunk->m_column * CHUNK_SIZE;
+				int kt = chunk->m_row * CHUNK_SIZE;
+				if (std::abs(chunk->m_column - candidate->m_column) > 1 || std::abs(chunk->m_row - candidate->m_row) > 1)
+				{
+					escaping = !heading(kl, kt, kl + CHUNK_SIZE - 1, kt + CHUNK_SIZE - 1);
+					continue;
+				}
+
+				for (const std::pair<int, int>& xy : chunk->getCellCoords())
+				{
+					int x = kl + xy.first;
+					int y = kt + xy.second;
+					if (std::binary_search(cluster.begin(), cluster.end(), std::make_pair(x, y)))
+						continue;
+					if (heading(x, y, x, y))
+					{
+						escaping = false;
+						break;
+					}
+				}
+			}
+			if (!escaping)
+				continue;
+
+			// Remove spaceship from chunks, it is now tracked by its phase and position
+			for (const std::pair<int, int>& xy : cluster)
+				this->setChunkCell(xy.first, xy.second, false);
+			m_escapees.push_back(escapee);
+			m_escapeeCellCount += static_cast<unsigned int>(cluster.size());
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::checkEscapees()
+{
+	if (m_escapees.empty())
+		return;
+
+	struct Bounds { int left, top, right, bottom; };
+	static thread_local std::vector<Bounds> bounds;
+	static thread_local std::vector<bool> restore;
+	std::unordered_map<long long, std::vector<size_t>> buckets;
+
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	auto chunkCoord = [CHUNK_SIZE](int v) { return (v < 0) ? (v + 1) / CHUNK_SIZE - 1 : v / CHUNK_SIZE; };
+	auto bucketKey = [](int col, int row) { return static_cast<long long>((static_cast<unsigned long long>(static_cast<unsigned int>(col)) << 32) ^ static_cast<unsigned int>(row)); };
+
+	bounds.resize(m_escapees.size());
+	restore.assign(m_escapees.size(), false);
+	for (size_t i = 0; i < m_escapees.size(); i++)
+	{
+		unsigned int phase;
+		int x, y;
+		this->getEscapeeState(m_escapees[i], phase, x, y);
+		const Spaceship::Phase& shape = m_spaceships[m_escapees[i].ship].getPhase(phase);
+		Bounds& b = bounds[i];
+		b.left   = x + shape.left - ESCAPE_MARGIN;
+		b.top    = y + shape.top - ESCAPE_MARGIN;
+		b.right  = x + shape.right + ESCAPE_MARGIN;
+		b.bottom = y + shape.bottom + ESCAPE_MARGIN;
+
+		// Near cells in chunks
+		restore[i] = this->hasAliveCellsIn(b.left, b.top, b.right, b.bottom);
+
+		// Near other escaped spaceships, check those in this and neighbouring chunks
+		int col = chunkCoord(b.left);
+		int row = chunkCoord(b.top);
+		for (int ox = -1; ox <= 1; ox++)
+		{
+			for (int oy = -1; oy <= 1; oy++)
+			{
+				auto it = buckets.find(bucketKey(col + ox, row + oy));
+				if (it == buckets.end())
+					continue;
+				for (size_t j : it->second)
+				{
+					const Bounds& o = bounds[j];
+					if (b.left <= o.right - ESCAPE_MARGIN && b.right >= o.left + ESCAPE_MARGIN &&
+						b.top <= o.bottom - ESCAPE_MARGIN && b.bottom >= o.top + ESCAPE_MARGIN)
+					{
+						restore[i] = true;
+						restore[j] = true;
+					}
+				}
+			}
+		}
+		buckets[bucketKey(col, row)].push_back(i);
+	}
+
+	// Restore from the back, so indices of remaining escapees are unchanged
+	for (size_t i = m_escapees.size(); i-- > 0;)
+		if (restore[i])
+			this->restoreEscapee(i);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::restoreEscapee(size_t idx)
+{
+	Escapee escapee = m_escapees[idx];
+	m_escapees[idx] = m_escapees.back();
+	m_escapees.pop_back();
+
+	unsigned int phase;
+	int x, y;
+	this->getEscapeeState(escapee, phase, x, y);
+	const Spaceship::Phase& shape = m_spaceships[escapee.ship].getPhase(phase);
+	m_escapeeCellCount -= static_cast<unsigned int>(shape.cells.size());
+	for (const std::pair<int, int>& xy : shape.cells)
+		this->setChunkCell(x + xy.first, y + xy.second, true);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::getEscapeeState(const Escapee& escapee, unsigned int& out_phase, int& out_x, int& out_y) const
+{
+	m_spaceships[escapee.ship].advance(escapee.phase, escapee.x, escapee.y, m_generation - escapee.generation, out_phase, out_x, out_y);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::forEachChunkIn(int left, int top, int right, int bottom, const std::function<void(const Chunk*)>& fn) const
+{
+	if (left > right || top > bottom)
+		return;
+
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	auto chunkCoord = [CHUNK_SIZE](int v) { return (v < 0) ? (v + 1) / CHUNK_SIZE - 1 : v / CHUNK_SIZE; };
+	auto blockCoord = [](int v) { return (v < 0) ? (v + 1) / INDEX_BLOCK_SIZE - 1 : v / INDEX_BLOCK_SIZE; };
+	const int colLeft = chunkCoord(left);
+	const int colRight = chunkCoord(right);
+	const int rowTop = chunkCoord(top);
+	const int rowBottom = chunkCoord(bottom);
+
+	auto visitBlock = [&](const std::vector<Chunk*>& block) {
+		for (const Chunk* chunk : block)
+			if (chunk->m_column >= colLeft && chunk->m_column <= colRight && chunk->m_row >= rowTop && chunk->m_row <= rowBottom)
+				fn(chunk);
+	};
+
+	const int blockLeft = blockCoord(colLeft);
+	const int blockRight = blockCoord(colRight);
+	const int blockTop = blockCoord(rowTop);
+	const int blockBottom = blockCoord(rowBottom);
+	const uint64_t blockCount = static_cast<uint64_t>(blockRight - blockLeft + 1) * static_cast<uint64_t>(blockBottom - blockTop + 1);
+
+	if (blockCount > m_chunkIndex.size())
+	{
+		// Bounds span more blocks than there are, visit the blocks there are instead
+		for (const auto& itBlock : m_chunkIndex)
+		{
+			const Chunk* first = itBlock.second.front();
+			const int x = blockCoord(first->m_column);
+			const int y = blockCoord(first->m_row);
+			if (x >= blockLeft && x <= blockRight && y >= blockTop && y <= blockBottom)
+				visitBlock(itBlock.second);
+		}
+		return;
+	}
+
+	for (int y = blockTop; y <= blockBottom; y++)
+	{
+		for (int x = blockLeft; x <= blockRight; x++)
+		{
+			auto itBlock = m_chunkIndex.find(chunkIndexKey(x * INDEX_BLOCK_SIZE, y * INDEX_BLOCK_SIZE));
+			if (itBlock != m_chunkIndex.end())
+				visitBlock(itBlock->second);
+		}
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+std::shared_ptr<const Snapshot> Simulation::snapshot() const
+{
+	std::shared_ptr<Snapshot> snapshot(new Snapshot());
+	snapshot->m_generation = m_generation;
+	snapshot->m_population = this->getPopulation();
+	snapshot->m_chunkCount = m_chunkCount;
+	this->getEscapeeCells(snapshot->m_escapeeCells);
+
+	// Build a block of the snapshot from an index block
+	auto buildBlock = [](uint64_t key, const std::vector<Chunk*>& chunks) {
+		std::shared_ptr<Snapshot::Block> block(new Snapshot::Block());
+		block->column = static_cast<int32_t>(key >> 32);
+		block->row = static_cast<int32_t>(key & 0xFFFFFFFF);
+		block->population = 0;
+		block->chunks.reserve(chunks.size());
+		for (const Chunk* chunk : chunks)
+		{
+			block->chunks.push_back(chunk->snapshot());
+			block->population += chunk->getAliveCells();
+		}
+		return block;
+	};
+
+	if (!m_snapshotBlocks)
+	{
+		// First snapshot, every block is built
+		std::shared_ptr<Snapshot::BlockMap> blocks(new Snapshot::BlockMap());
+		blocks->reserve(m_chunkIndex.size());
+		for (const auto& itBlock : m_chunkIndex)
+			blocks->emplace(itBlock.first, buildBlock(itBlock.first, itBlock.second));
+		m_snapshotBlocks = std::move(blocks);
+	}
+	else if (!m_snapshotChanges.empty())
+	{
+		// Unchanged blocks are shared with the previous snapshot, changed blocks are rebuilt
+		std::shared_ptr<Snapshot::BlockMap> blocks(new Snapshot::BlockMap(*m_snapshotBlocks));
+		for (uint64_t key : m_snapshotChanges)
+		{
+			auto itBlock = m_chunkIndex.find(key);
+			if (itBlock != m_chunkIndex.end())
+				(*blocks)[key] = buildBlock(key, itBlock->second);
+			else
+				blocks->erase(key);
+		}
+		m_snapshotBlocks = std::move(blocks);
+	}
+	m_snapshotChanges.clear();
+
+	snapshot->m_blocks = m_snapshotBlocks;
+	return snapshot;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Simulation::snapshotChanged(const Chunk* chunk)
+{
+	// Nothing to track until the first snapshot
+	if (m_snapshotBlocks)
+		m_snapshotChanges.insert(chunkIndexKey(chunk->m_column, chunk->m_row));
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Simulation::getBounds(int& out_left, int& out_top, int& out_right, int& out_bottom) const
+{
+	if (!m_boundsValid)
+	{
+		const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+		m_boundsValid = true;
+		m_boundsEmpty = true;
+
+		auto include = [this](int left, int top, int right, int bottom) {
+			if (m_boundsEmpty)
+			{
+				m_boundsLeft = left;
+				m_boundsTop = top;
+				m_boundsRight = right;
+				m_boundsBottom = bottom;
+				m_boundsEmpty = false;
+				return;
+			}
+			m_boundsLeft = std::min(m_boundsLeft, left);
+			m_boundsTop = std::min(m_boundsTop, top);
+			m_boundsRight = std::max(m_boundsRight, right);
+			m_boundsBottom = std::max(m_boundsBottom, bottom);
+		};
+
+		// Cell bounds of a chunk
+		auto includeChunk = [&](const Chunk* chunk) {
+			if (chunk->m_aliveCells == 0)
+				return;
+			uint64_t rows[Chunk::CHUNK_SIZE];
+			chunk->packCells(rows);
+			uint64_t columns = 0;
+			int y0 = -1, y1 = -1;
+			for (int y = 0; y < CHUNK_SIZE; y++)
+			{
+				if (rows[y] == 0)
+					continue;
+				columns |= rows[y];
+				if (y0 < 0)
+					y0 = y;
+				y1 = y;
+			}
+			int x0 = 0, x1 = CHUNK_SIZE - 1;
+			while (((columns >> x0) & 1) == 0)
+				x0++;
+			while (((columns >> x1) & 1) == 0)
+				x1--;
+			const int x = chunk->m_column * CHUNK_SIZE;
+			const int y = chunk->m_row * CHUNK_SIZE;
+			include(x + x0, y + y0, x + x1, y + y1);
+		};
+
+		// Only chunks in the outermost populated columns and rows can hold the outermost cells
+		int left, top, right, bottom;
+		if (m_pyramid.getBounds(left, top, right, bottom))
+		{
+			for (int col : { left, right })
+			{
+				auto itCol = m_chunks.find(col);
+				if (itCol != m_chunks.end())
+					for (auto itRow : itCol->second)
+						includeChunk(itRow.second);
+			}
+			for (int col = left; col <= right; col++)
+			{
+				auto itCol = m_chunks.find(col);
+				if (itCol == m_chunks.end())
+					continue;
+				for (int row : { top, bottom })
+				{
+					auto itRow = itCol->second.find(row);
+					if (itRow != itCol->second.end())
+						includeChunk(itRow->second);
+				}
+			}
+		}
+
+		// Escaped spaceships lie outside of chunks
+		std::vector<std::pair<int, int>> cells;
+		this->getEscapeeCells(cells);
+		for (const auto& xy : cells)
+			include(xy.first, xy.second, xy.first, xy.second);
+	}
+
+	if (m_boundsEmpty)
+		return false;
+
+	out_left = m_boundsLeft;
+	out_top = m_boundsTop;
+	out_right = m_boundsRight;
+	out_bottom = m_boundsBottom;
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+unsigned int Simulation::getRegionPopulation(int left, int top, int right, int bottom) const
+{
+	if (left > right || top > bottom)
+		return 0;
+
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	auto chunkCoord = [CHUNK_SIZE](int v) { return (v < 0) ? (v + 1) / CHUNK_SIZE - 1 : v / CHUNK_SIZE; };
+	const int colLeft = chunkCoord(left);
+	const int colRight = chunkCoord(right);
+	const int rowTop = chunkCoord(top);
+	const int rowBottom = chunkCoord(bottom);
+
+	// Chunks wholly within the bounds are summed by the pyramid
+	const int innerLeft = (left == colLeft * CHUNK_SIZE) ? colLeft : colLeft + 1;
+	const int innerRight = (right == colRight * CHUNK_SIZE + CHUNK_SIZE - 1) ? colRight : colRight - 1;
+	const int innerTop = (top == rowTop * CHUNK_SIZE) ? rowTop : rowTop + 1;
+	const int innerBottom = (bottom == rowBottom * CHUNK_SIZE + CHUNK_SIZE - 1) ? rowBottom : rowBottom - 1;
+	unsigned int population = m_pyramid.getRegionPopulation(innerLeft, innerTop, innerRight, innerBottom);
+
+	// Cells of chunks partly within the bounds are counted
+	for (int row = rowTop; row <= rowBottom; row++)
+	{
+		const bool innerRow = (row >= innerTop && row <= innerBottom);
+		for (int col = colLeft; col <= colRight; col++)
+		{
+			if (innerRow && col >= innerLeft && col <= innerRight)
+			{
+				// Skip to the right edge
+				col = std::max(col, innerRight);
+				continue;
+			}
+			if (m_pyramid.getPopulation(0, col, row) == 0)
+				continue;
+			const Chunk* chunk = this->getChunk(col, row);
+			if (chunk == nullptr)
+				continue;
+
+			// Bounds local to this chunk
+			const int x0 = std::max(left, col * CHUNK_SIZE) - col * CHUNK_SIZE;
+			const int y0 = std::max(top, row * CHUNK_SIZE) - row * CHUNK_SIZE;
+			const int x1 = std::min(right, (col + 1) * CHUNK_SIZE - 1) - col * CHUNK_SIZE;
+			const int y1 = std::min(bottom, (row + 1) * CHUNK_SIZE - 1) - row * CHUNK_SIZE;
+			const uint64_t mask = ((x1 - x0 == CHUNK_SIZE - 1) ? ~uint64_t(0) : ((uint64_t(1) << (x1 - x0 + 1)) - 1)) << x0;
+
+			uint64_t rows[Chunk::CHUNK_SIZE];
+			chunk->packCells(rows);
+			for (int y = y0; y <= y1; y++)
+				population += static_cast<unsigned int>(std::bitset<64>(rows[y] & mask).count());
+		}
+	}
+
+	// Escaped spaceships lie outside of chunks
+	std::vector<std::pair<int, int>> cells;
+	this->getEscapeeCells(cells);
+	for (const auto& xy : cells)
+		if (xy.first >= left && xy.first <= right && xy.second >= top && xy.second <= bottom)
+			population++;
+
+	return population;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+bool Simulation::hasAliveCellsIn(int left, int top, int right, int bottom) const
+{
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	auto chunkCoord = [CHUNK_SIZE](int v) { return (v < 0) ? (v + 1) / CHUNK_SIZE - 1 : v / CHUNK_SIZE; };
+
+	uint64_t cells[Chunk::CHUNK_SIZE];
+	for (int col = chunkCoord(left); col <= chunkCoord(right); col++)
+	{
+		for (int row = chunkCoord(top); row <= chunkCoord(bottom); row++)
+		{
+			const Chunk* chunk = this->getChunk(col, row);
+			if (chunk == nullptr || chunk->m_aliveCells == 0)
+				continue;
+
+			// Bounds local to this chunk
+			int x0 = std::max(left, col * CHUNK_SIZE) - col * CHUNK_SIZE;
+			int y0 = std::max(top, row * CHUNK_SIZE) - row * CHUNK_SIZE;
+			int x1 = std::min(right, (col + 1) * CHUNK_SIZE - 1) - col * CHUNK_SIZE;
+			int y1 = std::min(bottom, (row + 1) * CHUNK_SIZE - 1) - row * CHUNK_SIZE;
+
+			// Unpack cells once (compressed chunks would decode them for every cell), then test rows against the columns in bounds
+			chunk->packCells(cells);
+			const uint64_t columns = (~uint64_t(0) >> (CHUNK_SIZE - 1 - (x1 - x0))) << x0;
+			for (int y = y0; y <= y1; y++)
+				if (cells[y] & columns)
+					return true;
+		}
+	}
+
+	return false;
+}
@@ -36,52 +36,217 @@
 // (including deltas), simulation rulesets, chunk count, generation, etc.
 // 
 
+#include "Universe.hpp"
 #include "Chunk.hpp"
+#include "ChunkMemo.hpp"
+#include "ChunkPager.hpp"
+#include "PopulationPyramid.hpp"
+#include "Snapshot.hpp"
+#include "EditJournal.hpp"
+#include "StepProfile.hpp"
+#include "Spaceship.hpp"
 #include "Ruleset.hpp"
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <thread>
 #include <atomic>
 #include <queue>
 #include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
 
 
 namespace gol
 {
 
-class Simulation
+// Horizontal run of alive cells, from {x,y} to {x+length-1,y}.
+struct CellSpan
+{
+	int x;
+	int y;
+	int length;
+};
+
+class Simulation : public Universe
 {
 public:
 	Simulation();
 	virtual ~Simulation();
 
+	// Generations between searches for escaping spaceships.
+	static const unsigned int ESCAPE_CHECK_INTERVAL = 32;
+
+	// Distance around a spaceship which must be clear of other cells for it to escape.
+	static const int ESCAPE_CLEARANCE = 4;
+
+	// Escaped spaceships are returned to the universe once other cells come within this distance.
+	static const int ESCAPE_MARGIN = 2;
+
+	// Generations between passes compressing chunks which have been sleeping for a long time.
+	static const unsigned int COMPRESS_CHECK_INTERVAL = 64;
+
+	// Chunks are indexed in square blocks of this many chunks per side, see forEachChunkIn().
+	static const int INDEX_BLOCK_SIZE = 16;
+
+	// Longest period of the whole universe detected by isStable().
+	static const unsigned int MAX_WORLD_PERIOD = 4096;
+
 	// Resets the entire simulation.
 	// resetGeneration: Resets generation counter to zero.
-	void reset(bool resetGeneration = true);
+	virtual void reset(bool resetGeneration = true) override;
 
 	// Steps the simulation once. This will move on to the next generation of the simulation.
-	void step();
+	virtual void step() override;
 
 	// Set alive state for cell at position {x,y}.
-	void setCell(int x, int y, bool alive);
+	virtual void setCell(int x, int y, bool alive) override;
 
 	// Get alive state for cell at position {x,y}.
-	bool getCell(int x, int y) const;
+	virtual bool getCell(int x, int y) const override;
+
+	// Queue alive state for cell at position {x,y}, set before the next generation (or by applyEdits()).
+	// Unlike setCell(), this may be called from any thread, even while the simulation is being stepped.
+	inline void queueCell(int x, int y, bool alive) { m_edits.record(x, y, alive); }
+
+	// Queue a batch of cell edits, see queueCell().
+	inline void queueCells(std::vector<CellEdit>&& edits) { m_edits.record(std::move(edits)); }
+
+	// Returns true if queued edits are waiting to be applied.
+	inline bool hasQueuedEdits() const { return !m_edits.empty(); }
+
+	// Apply queued edits, a chunk at a time. Called by step() before each generation.
+	void applyEdits();
+
+	// How stampCells() combines stamped cells with the cells already there.
+	enum EStampMode
+	{
+		// Cells within the stamped area become the stamped cells.
+		StampSet,
+
+		// Stamped cells become alive, other cells are left as they are.
+		StampOr,
+
+		// Stamped cells become dead, other cells are left as they are.
+		StampClear,
+
+		// Stamped cells are toggled, other cells are left as they are.
+		StampXor,
+	};
+
+	// Stamp a bitmap of width*height cells with its top left cell at {x,y}, a chunk at a time.
+	// Rows are "stride" 64-bit words apart, bit (i % 64) of word (i / 64) holding cell i of the row.
+	void stampCells(const uint64_t* bitmap, int width, int height, size_t stride, int x, int y, EStampMode mode);
+
+	// Stamp runs of alive cells offset by {x,y}, a chunk at a time. For StampSet, the stamped area is the bounds of the runs.
+	void stampCells(const std::vector<CellSpan>& spans, int x, int y, EStampMode mode);
+
+	// Read alive states of the width*height cells with the top left cell at {x,y} into a bitmap laid out as for stampCells(),
+	// a chunk row at a time. Cells of chunks which don't exist are dead.
+	void readCells(int x, int y, int width, int height, uint64_t* out_bitmap, size_t stride) const;
+
+	// Call fn with each run of alive cells within the bounds given (inclusive), row by row from the top left.
+	// Only populated chunks are visited, so this suits sparse regions better than readCells().
+	void forEachSpanIn(int left, int top, int right, int bottom, const std::function<void(const CellSpan&)>& fn) const;
 
 	// Get the current generation.
-	inline unsigned int getGeneration() const { return m_generation; }
+	virtual unsigned int getGeneration() const override { return m_generation; }
 
 	// Get number of births for this generation.
-	inline unsigned int getBirths() const { return m_births; }
+	virtual unsigned int getBirths() const override { return m_births + m_escapeeBirths; }
 
-	// Get number of births for this generation.
-	inline unsigned int getDeaths() const { return m_deaths; }
+	// Get number of deaths for this generation.
+	virtual unsigned int getDeaths() const override { return m_deaths + m_escapeeDeaths; }
 
 	// Get the count of current simulation chunks.
 	inline unsigned int getChunkCount() const { return m_chunkCount; }
 
+	// Get the count of chunks using the sparse representation, as of the last step.
+	inline unsigned int getSparseChunkCount() const { return m_sparseChunkCount; }
+
+	// Get the count of chunks using the dense representation, as of the last step.
+	inline unsigned int getDenseChunkCount() const { return m_denseChunkCount; }
+
+	// Get the count of chunks with cell storage allocated, as of the last step.
+	// Other chunks have no alive cells and do not use memory for them.
+	inline unsigned int getAllocatedChunkCount() const { return m_allocatedChunkCount; }
+
+	// Get the count of chunks with compressed cells, as of the last step.
+	inline unsigned int getCompressedChunkCount() const { return m_compressedChunkCount; }
+
+	// Get bytes used by uncompressed cell storage of all chunks, as of the last step.
+	inline size_t getResidentCellBytes() const { return m_residentCellBytes; }
+
+	// Get bytes used by compressed cell storage of all chunks, as of the last step.
+	// Storage shared by identical chunks is counted once, as of the last compression pass.
+	inline size_t getCompressedCellBytes() const { return m_compressedCellBytes; }
+
+	// Get ratio of compressed cell bytes referenced by chunks to bytes actually stored, as of the last compression pass.
+	// Identical compressed chunks share storage, see ChunkStore.
+	inline float getCompressedDedupRatio() const { return m_chunkStore.getDedupRatio(); }
+
+	// Get the count of chunks in periodic sleep (replaying an oscillating pattern), as of the last step.
+	inline unsigned int getPeriodicChunkCount() const { return m_periodicChunkCount; }
+
+	// Get cache of chunk transitions. Disabled by default, see ChunkMemo::setCapacity().
+	inline ChunkMemo& getChunkMemo() { return m_chunkMemo; }
+	inline const ChunkMemo& getChunkMemo() const { return m_chunkMemo; }
+
+	// Get shared storage of compressed chunk cells.
+	inline ChunkStore& getChunkStore() { return m_chunkStore; }
+	inline const ChunkStore& getChunkStore() const { return m_chunkStore; }
+
+	// Set memory budget for cell storage in bytes, or 0 for no budget (default).
+	// Once exceeded, cells of the least recently active sleeping chunks are paged out to disk, see Chunk::pageOut().
+	// Checked every COMPRESS_CHECK_INTERVAL generations.
+	inline void setMemoryBudget(size_t bytes) { m_memoryBudget = bytes; }
+	inline size_t getMemoryBudget() const { return m_memoryBudget; }
+
+	// Get bounding box of alive cells (inclusive), including escaped spaceships.
+	// Returns false if there are no alive cells. Populated chunks are known from the population pyramid,
+	// only chunks on the edges of the pattern are visited to find cell bounds, once after each change.
+	bool getBounds(int& out_left, int& out_top, int& out_right, int& out_bottom) const;
+
+	// Get the count of alive cells within the bounds given (inclusive), including escaped spaceships.
+	// Chunks wholly within the bounds are summed through the population pyramid.
+	unsigned int getRegionPopulation(int left, int top, int right, int bottom) const;
+
+	// Get populations of chunks and regions of chunks. Escaped spaceships are not included.
+	inline const PopulationPyramid& getPopulationPyramid() const { return m_pyramid; }
+
+	// Get backing file of paged out chunks, including page in/out counters.
+	inline ChunkPager& getChunkPager() { return m_chunkPager; }
+	inline const ChunkPager& getChunkPager() const { return m_chunkPager; }
+
+	// Get the count of spaceships which escaped the universe, and are tracked without chunks.
+	inline unsigned int getEscapeeCount() const { return static_cast<unsigned int>(m_escapees.size()); }
+
+	// Push positions {x,y} of alive cells belonging to escaped spaceships to the vector provided.
+	// (Vector is not cleared here, data is only appended.)
+	void getEscapeeCells(std::vector<std::pair<int,int>>& out_vec) const;
+
+	// Enable or disable tracking of escaped spaceships.
+	// When disabled, escaped spaceships are returned to the universe.
+	void setEscapeTracking(bool enable);
+
+	// Get whether escaped spaceships are tracked.
+	inline bool isEscapeTracking() const { return m_escapeTracking; }
+
+	// Returns true if the universe has entered a cycle, repeating every getPeriod() generations.
+	// Escaped spaceships are not included, as they are tracked separately.
+	inline bool isStable() const { return m_worldPeriod > 0; }
+
+	// Get period of the universe's cycle. Returns 0 if it is not stable.
+	inline unsigned int getPeriod() const { return m_worldPeriod; }
+
+	// Advance the simulation by a number of generations.
+	// While the universe is stable, whole cycles are skipped instead of stepped.
+	// Stops early rather than wrap the generation counter past its maximum.
+	void fastForward(unsigned int generations);
+
 	// Get the count of currently alive cells.
-	inline unsigned int getPopulation() const { return m_cellCount; }
+	virtual unsigned int getPopulation() const override { return m_cellCount + m_escapeeCellCount; }
 
 	// Get chunk by {column,row}.
 	Chunk* getChunk(int col, int row);
@@ -95,21 +260,38 @@ public:
 	// (Vector is not cleared here, data is only appended.)
 	void getAllChunks(std::vector<const Chunk*>& out_vec) const;
 
+	// Call fn for each chunk intersecting the bounds given (inclusive, in cell coordinates).
+	// Only chunks in index blocks overlapping the bounds are visited, not every chunk in the simulator.
+	void forEachChunkIn(int left, int top, int right, int bottom, const std::function<void(const Chunk*)>& fn) const;
+
+	// Get an immutable snapshot of the current generation, which any thread may read while the simulation moves on.
+	// Chunks which have not changed since the last snapshot share their cells with it, and only index blocks
+	// of chunks which have changed are rebuilt.
+	// Must not be called while the simulation is being stepped or modified.
+	std::shared_ptr<const Snapshot> snapshot() const;
+
 	// Get simulation rule-set.
-	inline const Ruleset& getRuleset() const { return m_ruleset; }
+	virtual const Ruleset& getRuleset() const override { return m_ruleset; }
 
 	// Set simulation rule-set.
-	void setRuleset(const Ruleset& ruleset);
+	virtual void setRuleset(const Ruleset& ruleset) override;
 
 	// Enable or disable multithreading mode.
-	void setMultithreadMode(bool enable);
+	virtual void setMultithreadMode(bool enable) override;
+
+	// Set number of worker threads, restarting workers if they are running. 0 uses a thread per core.
+	// Multithreading mode is enabled for more than one thread, and disabled otherwise.
+	void setThreadCount(size_t threads);
 
 	// Get whether the simulation is multithreaded.
-	inline bool isMultithreaded() const { return m_multithreaded; }
+	virtual bool isMultithreaded() const override { return m_multithreaded; }
 
 	// Get number of worker threads running.
 	// Returns 0 if multithreading mode is disabled.
-	inline size_t getWorkerThreadCount() const { return m_ccWorkers.size(); }
+	virtual size_t getWorkerThreadCount() const override { return m_ccWorkers.size(); }
+
+	// Get where the time of recent steps went, summarised over the last StepProfile::WINDOW steps.
+	inline StepProfile::Stats getStats() const { return m_profile.getStats(); }
 
 
 private:
@@ -117,22 +299,138 @@ private:
 	typedef std::unordered_map<int, RowMap> ColumnMap;
 
 	ColumnMap m_chunks; // m_chunks[col][row]
+	std::unordered_map<uint64_t, std::vector<Chunk*>> m_chunkIndex; //> Chunks by index block, see INDEX_BLOCK_SIZE.
 	unsigned int m_chunkCount;
+	unsigned int m_sparseChunkCount;
+	unsigned int m_denseChunkCount;
+	unsigned int m_periodicChunkCount;
+	unsigned int m_allocatedChunkCount;
+	unsigned int m_compressedChunkCount;
+	size_t m_residentCellBytes;
+	size_t m_compressedCellBytes;
 	unsigned int m_cellCount;
 	unsigned int m_births;
 	unsigned int m_deaths;
 	unsigned int m_generation;
 	Ruleset m_ruleset;
+	ChunkMemo m_chunkMemo;
+	ChunkStore m_chunkStore;
+	ChunkStore::UseCounts m_compressedUses; //> Chunks using each shared buffer, counted by the compression pass.
+	ChunkPager m_chunkPager;
+	size_t m_memoryBudget;
+	PopulationPyramid m_pyramid;
+
+	// Cell bounds, found by getBounds() after each change.
+	mutable bool m_boundsValid;
+	mutable bool m_boundsEmpty;
+	mutable int m_boundsLeft, m_boundsTop, m_boundsRight, m_boundsBottom;
+
+	// Index blocks of the latest snapshot, and keys of index blocks changed since. Changes are only tracked
+	// once a snapshot has been made.
+	mutable std::shared_ptr<const Snapshot::BlockMap> m_snapshotBlocks;
+	mutable std::unordered_set<uint64_t> m_snapshotChanges;
+
+	// Internal: Mark the index block of a chunk as changed since the latest snapshot.
+	void snapshotChanged(const Chunk* chunk);
+
+	EditJournal m_edits;
+	std::vector<CellEdit> m_editBuffer; //> Edits being applied by applyEdits().
 
 	Chunk* createChunk(int column, int row);
 	void checkForNewChunks();
 	void freeInactiveChunks();
+	void enforceMemoryBudget();
+
+	/////////////////////////////////
+	///// Whole universe period /////
+	/////////////////////////////////
+
+	uint64_t m_worldHash;                    //> XOR of Chunk::getPositionalHash() of every chunk.
+	std::vector<uint64_t> m_worldHashes;     //> Recent world hashes, indexed by m_worldHashCount.
+	std::unordered_map<uint64_t, unsigned long long> m_worldHashSeen; //> Latest index of each recent world hash.
+	unsigned long long m_worldHashCount;
+	unsigned int m_worldCandidate;           //> Period being confirmed.
+	unsigned int m_worldMatches;             //> Generations matching the period being confirmed.
+	unsigned int m_worldPeriod;
+	int m_worldLeft;                         //> Chunk bounds of alive cells while confirming the period.
+	int m_worldTop;
+	int m_worldRight;
+	int m_worldBottom;
+
+	// Record world hash for this generation, and check whether the universe is repeating.
+	void checkWorldPeriod();
+
+	// Drop the period found so far, the universe has been changed.
+	// clearHistory: Also forget recorded world hashes.
+	void resetWorldPeriod(bool clearHistory = false);
+
+	// Get number of generations after which the whole simulation (including escape searches) repeats.
+	unsigned int getCycleLength(unsigned int period) const;
+
+	// Get number of generations escaped spaceships can be moved without coming near alive chunks, or each other.
+	unsigned int getEscapeeHorizon() const;
+
+	//////////////////////////////
+	///// Escaped spaceships /////
+	//////////////////////////////
+
+	// A spaceship removed from the chunks, its position is found from the generation it escaped.
+	struct Escapee
+	{
+		size_t ship;             //> Index into m_spaceships.
+		unsigned int phase;      //> Phase when escaped.
+		int x;                   //> Origin when escaped.
+		int y;
+		unsigned int generation; //> Generation when escaped.
+	};
+
+	bool m_escapeTracking;
+	unsigned int m_escapeeCellCount;
+	unsigned int m_escapeeBirths;
+	unsigned int m_escapeeDeaths;
+	std::vector<Spaceship> m_spaceships;
+	std::vector<Escapee> m_escapees;
+
+	// Search small isolated groups of cells for spaceships heading away from everything else, and remove them from chunks.
+	void findEscapees();
+
+	// Return escaped spaceships to the universe when other cells come near.
+	void checkEscapees();
+
+	// Update population, births and deaths of escaped spaceships for the current generation.
+	void countEscapees();
+
+	// Set alive state for cell at position {x,y} in chunks, ignoring escaped spaceships.
+	void setChunkCell(int x, int y, bool alive);
+
+	// Return escaped spaceships near the bounds given (inclusive) to the universe, so they react to cells set there.
+	void restoreEscapeesNear(int left, int top, int right, int bottom);
+
+	// Create neighbours of a chunk whose border cells were set, and wake them if sleeping.
+	void wakeNeighbours(const Chunk* chunk);
+
+	// Stamp cells of the chunk at {column,row}, see stampCells(). Given one bitmask per row of the chunk, of the
+	// stamped cells and of the cells within the stamped area.
+	void stampChunk(int column, int row, const uint64_t bits[Chunk::CHUNK_SIZE], const uint64_t area[Chunk::CHUNK_SIZE], EStampMode mode);
+
+	// Return escaped spaceship to the universe, removing it from m_escapees.
+	void restoreEscapee(size_t idx);
+
+	// Get current phase and origin of escaped spaceship.
+	void getEscapeeState(const Escapee& escapee, unsigned int& out_phase, int& out_x, int& out_y) const;
+
+	// Returns true if any alive cell in chunks lies within the bounds given (inclusive).
+	bool hasAliveCellsIn(int left, int top, int right, int bottom) const;
 
 	///////////////////////
 	///// Concurrency /////
 	///////////////////////
 
-	bool m_multithreaded;
+	// Measurements of recent steps, and of the step in progress.
+	StepProfile m_profile;
+	StepProfile::Sample m_stepSample;
+
+	std::atomic_bool m_multithreaded; //> Read by workers to know when to close.
 	size_t m_availableThreads;
 	std::vector<std::thread> m_ccWorkers;
 	std::atomic_int m_ccWorking;
@@ -163,10 +461,25 @@ private:
 		}
 	};
 	CCSharedQueue<Chunk*> m_ccQueue;
+	CCSharedQueue<Chunk*> m_ccChanged; //> Chunks whose population changed while applying.
 	std::atomic_int m_ccCellCount;
 	std::atomic_int m_ccBirths;
 	std::atomic_int m_ccDeaths;
-	static void ccStartWorker(Simulation* sim);
+	std::atomic_int m_ccSparseChunks;
+	std::atomic_int m_ccDenseChunks;
+	std::atomic_int m_ccPeriodicChunks;
+	std::atomic_int m_ccAllocatedChunks;
+	std::atomic_int m_ccCompressedChunks;
+	std::atomic<size_t> m_ccResidentCellBytes;
+	std::atomic<size_t> m_ccCompressedCellBytes;
+	std::atomic<uint64_t> m_ccWorldHash;
+	// Measurements of each worker, handed over each time it runs out of chunks.
+	struct alignas(64) CCWorkerProfile {
+		std::atomic<uint64_t> busyNanoseconds;
+		std::atomic<unsigned int> chunks[StepProfile::SLEEP_MODES];
+	};
+	std::unique_ptr<CCWorkerProfile[]> m_ccProfiles;
+	static void ccStartWorker(Simulation* sim, size_t index);
 };
 
 }
\ No newline at end of file
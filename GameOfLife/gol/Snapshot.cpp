@@ -0,0 +1,210 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/Snapshot.cpp
+// 
+// Implements class gol::ChunkSnapshot
+// Implements class gol::Snapshot
+// 
+
+#include "Snapshot.hpp"
+#include "Simulation.hpp"
+
+#include <algorithm>
+#include <climits>
+
+using namespace gol;
+
+
+// Get key of the block at block coordinates {x,y}. Same keys as the simulation's chunk index.
+static inline uint64_t blockKey(int x, int y)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+
+// Floor division, also for negative coordinates.
+static inline int floorDiv(int v, int size)
+{
+	return (v < 0) ? (v + 1) / size - 1 : v / size;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+ChunkSnapshot::ChunkSnapshot(const Chunk& chunk)
+	: m_column(chunk.m_column)
+	, m_row(chunk.m_row)
+	, m_uid(chunk.m_uid)
+	, m_version(chunk.m_version)
+	, m_aliveCells(chunk.m_aliveCells)
+	, m_sleepMode(chunk.m_sleepMode)
+{
+	if (m_aliveCells == 0)
+		return;
+
+	// Share compressed cells instead of copying them
+	if (chunk.m_compressed)
+	{
+		m_compressed = chunk.m_compressed;
+		return;
+	}
+
+	m_cells.reset(new uint64_t[Chunk::CHUNK_SIZE]);
+	chunk.packCells(m_cells.get());
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void ChunkSnapshot::getCells(uint64_t out_cells[Chunk::CHUNK_SIZE]) const
+{
+	if (m_cells)
+		std::copy(m_cells.get(), m_cells.get() + Chunk::CHUNK_SIZE, out_cells);
+	else if (m_compressed)
+		Chunk::unpackCells(m_compressed->data, out_cells);
+	else
+		std::fill(out_cells, out_cells + Chunk::CHUNK_SIZE, 0);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+const unsigned char* ChunkSnapshot::getDensity(int level) const
+{
+	if (level < 1 || level > Chunk::DENSITY_LEVELS)
+		return nullptr;
+
+	std::call_once(m_densityBuilt, [this]() {
+		uint64_t cells[Chunk::CHUNK_SIZE];
+		this->getCells(cells);
+		m_density.reset(new unsigned char[Chunk::DENSITY_BYTES]);
+		Chunk::buildDensity(cells, m_density.get());
+	});
+	return m_density.get() + Chunk::getDensityOffset(level);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+Snapshot::Snapshot()
+	: m_generation(0)
+	, m_population(0)
+	, m_chunkCount(0)
+	, m_blocks(std::make_shared<BlockMap>())
+{
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Snapshot::forEachChunkIn(int left, int top, int right, int bottom, const std::function<void(const ChunkSnapshot&)>& fn) const
+{
+	if (left > right || top > bottom)
+		return;
+
+	const int CHUNK_SIZE = static_cast<int>(Chunk::CHUNK_SIZE);
+	const int BLOCK_SIZE = Simulation::INDEX_BLOCK_SIZE;
+	const int colLeft = floorDiv(left, CHUNK_SIZE);
+	const int colRight = floorDiv(right, CHUNK_SIZE);
+	const int rowTop = floorDiv(top, CHUNK_SIZE);
+	const int rowBottom = floorDiv(bottom, CHUNK_SIZE);
+
+	this->forEachBlockIn(floorDiv(colLeft, BLOCK_SIZE), floorDiv(rowTop, BLOCK_SIZE), floorDiv(colRight, BLOCK_SIZE), floorDiv(rowBottom, BLOCK_SIZE),
+		[&](const Block& block) {
+			for (const ChunkHandle& chunk : block.chunks)
+				if (chunk->getColumn() >= colLeft && chunk->getColumn() <= colRight && chunk->getRow() >= rowTop && chunk->getRow() <= rowBottom)
+					fn(*chunk);
+		});
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Snapshot::forEachRegionIn(int level, int left, int top, int right, int bottom, const std::function<void(int, int, unsigned int)>& fn) const
+{
+	if (left > right || top > bottom || level < 0)
+		return;
+
+	// Blocks are regions of 4^BLOCK_LEVEL chunks per side
+	const int BLOCK_SIZE = Simulation::INDEX_BLOCK_SIZE;
+	const int BLOCK_LEVEL = 2;
+	static_assert(Simulation::INDEX_BLOCK_SIZE == 1 << (BLOCK_LEVEL * 2), "index blocks must be regions of the population pyramid");
+
+	auto toLevel = [](int v, int level) { return (v >= 0) ? (v >> (level * 2)) : ~((~v) >> (level * 2)); };
+	std::unordered_map<uint64_t, unsigned int> regions;
+
+	// Whole regions overlapping the bounds are summed
+	const int64_t span = int64_t(1) << (level * 2);
+	left   = static_cast<int>(std::max<int64_t>(INT_MIN, toLevel(left, level) * span));
+	top    = static_cast<int>(std::max<int64_t>(INT_MIN, toLevel(top, level) * span));
+	right  = static_cast<int>(std::min<int64_t>(INT_MAX, (toLevel(right, level) + 1) * span - 1));
+	bottom = static_cast<int>(std::min<int64_t>(INT_MAX, (toLevel(bottom, level) + 1) * span - 1));
+
+	if (level < BLOCK_LEVEL)
+	{
+		// Sum populations of chunks
+		this->forEachBlockIn(floorDiv(left, BLOCK_SIZE), floorDiv(top, BLOCK_SIZE), floorDiv(right, BLOCK_SIZE), floorDiv(bottom, BLOCK_SIZE),
+			[&](const Block& block) {
+				for (const ChunkHandle& chunk : block.chunks)
+					if (chunk->getAliveCells() > 0 && chunk->getColumn() >= left && chunk->getColumn() <= right && chunk->getRow() >= top && chunk->getRow() <= bottom)
+						regions[blockKey(toLevel(chunk->getColumn(), level), toLevel(chunk->getRow(), level))] += chunk->getAliveCells();
+			});
+	}
+	else
+	{
+		// Sum populations of whole blocks
+		const int blockLevel = level - BLOCK_LEVEL;
+		this->forEachBlockIn(floorDiv(left, BLOCK_SIZE), floorDiv(top, BLOCK_SIZE), floorDiv(right, BLOCK_SIZE), floorDiv(bottom, BLOCK_SIZE),
+			[&](const Block& block) {
+				if (block.population > 0)
+					regions[blockKey(toLevel(block.column, blockLevel), toLevel(block.row, blockLevel))] += block.population;
+			});
+	}
+
+	for (const auto& it : regions)
+		fn(static_cast<int32_t>(it.first >> 32), static_cast<int32_t>(it.first & 0xFFFFFFFF), it.second);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Snapshot::forEachBlockIn(int left, int top, int right, int bottom, const std::function<void(const Block&)>& fn) const
+{
+	const uint64_t count = static_cast<uint64_t>(right - left + 1) * static_cast<uint64_t>(bottom - top + 1);
+	if (count > m_blocks->size())
+	{
+		// Bounds span more blocks than there are, visit the blocks there are instead
+		for (const auto& it : *m_blocks)
+		{
+			const Block& block = *it.second;
+			if (block.column >= left && block.column <= right && block.row >= top && block.row <= bottom)
+				fn(block);
+		}
+		return;
+	}
+
+	for (int y = top; y <= bottom; y++)
+	{
+		for (int x = left; x <= right; x++)
+		{
+			auto it = m_blocks->find(blockKey(x, y));
+			if (it != m_blocks->end())
+				fn(*it->second);
+		}
+	}
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/Snapshot.hpp
+//
+// class gol::ChunkSnapshot
+// class gol::Snapshot
+// 
+// Immutable views of a gol::Simulation at one generation, made by
+// Simulation::snapshot(). Once made, a snapshot is never modified, so any
+// number of threads may read it while the simulation moves on. Chunks
+// whose cells have not changed share one ChunkSnapshot between snapshots,
+// as do whole index blocks of unchanged chunks, and sleeping compressed
+// chunks share their compressed buffer.
+// 
+
+#include "Chunk.hpp"
+#include "ChunkStore.hpp"
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+
+namespace gol
+{
+
+class ChunkSnapshot
+{
+public:
+	// Get chunk column.
+	inline int getColumn() const { return m_column; }
+
+	// Get chunk row.
+	inline int getRow() const { return m_row; }
+
+	// Get unique ID of the chunk.
+	inline unsigned int getUniqueID() const { return m_uid; }
+
+	// Get Chunk::getVersion() of the chunk when the snapshot was made.
+	inline unsigned int getVersion() const { return m_version; }
+
+	// Get sleep mode of the chunk when the snapshot was made.
+	inline Chunk::ESleepMode getSleepMode() const { return m_sleepMode; }
+
+	// Get count of alive cells.
+	inline unsigned int getAliveCells() const { return m_aliveCells; }
+
+	// Read alive states of cells into bitmasks, one per row (bit x of row y).
+	void getCells(uint64_t out_cells[Chunk::CHUNK_SIZE]) const;
+
+	// Get density of alive cells, see Chunk::getDensity(). Built on first use, from any thread.
+	const unsigned char* getDensity(int level) const;
+
+private:
+	friend Chunk;
+	ChunkSnapshot(const Chunk& chunk);
+
+	int m_column;
+	int m_row;
+	unsigned int m_uid;
+	unsigned int m_version;
+	unsigned int m_aliveCells;
+	Chunk::ESleepMode m_sleepMode;
+
+	// Cells are either shared with a compressed chunk, or held as bitmasks (none if there are no alive cells).
+	ChunkStore::Handle m_compressed;
+	std::unique_ptr<uint64_t[]> m_cells;
+
+	mutable std::once_flag m_densityBuilt;
+	mutable std::unique_ptr<unsigned char[]> m_density;
+};
+
+
+class Snapshot
+{
+public:
+	typedef std::shared_ptr<const ChunkSnapshot> ChunkHandle;
+
+	// Get generation the snapshot was made at.
+	inline unsigned int getGeneration() const { return m_generation; }
+
+	// Get the count of alive cells, including escaped spaceships.
+	inline unsigned int getPopulation() const { return m_population; }
+
+	// Get the count of chunks.
+	inline unsigned int getChunkCount() const { return m_chunkCount; }
+
+	// Get positions {x,y} of alive cells belonging to escaped spaceships.
+	inline const std::vector<std::pair<int,int>>& getEscapeeCells() const { return m_escapeeCells; }
+
+	// Call fn for each chunk intersecting the bounds given (inclusive, in cell coordinates).
+	// See Simulation::forEachChunkIn().
+	void forEachChunkIn(int left, int top, int right, int bottom, const std::function<void(const ChunkSnapshot&)>& fn) const;
+
+	// Call fn with {column,row} and population of each populated region at the level given, overlapping the bounds given
+	// (inclusive, in chunk coordinates). See PopulationPyramid::forEachRegionIn(). Escaped spaceships are not included.
+	void forEachRegionIn(int level, int left, int top, int right, int bottom, const std::function<void(int, int, unsigned int)>& fn) const;
+
+private:
+	friend class Simulation;
+	Snapshot();
+
+	// Chunks of one index block of the simulation, see Simulation::INDEX_BLOCK_SIZE.
+	struct Block
+	{
+		int column;                      //> Block coordinates.
+		int row;
+		unsigned int population;
+		std::vector<ChunkHandle> chunks;
+	};
+	typedef std::unordered_map<uint64_t, std::shared_ptr<const Block>> BlockMap;
+
+	unsigned int m_generation;
+	unsigned int m_population;
+	unsigned int m_chunkCount;
+	std::vector<std::pair<int,int>> m_escapeeCells;
+	std::shared_ptr<const BlockMap> m_blocks; //> Shared with the previous snapshot if no chunk changed.
+
+	// Internal: Call fn for each block overlapping the bounds given (inclusive, in block coordinates).
+	void forEachBlockIn(int left, int top, int right, int bottom, const std::function<void(const Block&)>& fn) const;
+};
+
+}
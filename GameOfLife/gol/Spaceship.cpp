@@ -0,0 +1,205 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/Spaceship.cpp
+// 
+// Implements class gol::Spaceship
+// 
+
+#include "Spaceship.hpp"
+
+#include <algorithm>
+
+using namespace gol;
+
+
+//////////////////////////////////////////////////////////////////////
+bool Spaceship::identify(const CellList& cells, const Ruleset& ruleset, Spaceship& out_ship, int& out_x, int& out_y)
+{
+	if (cells.empty() || cells.size() > MAX_CELLS)
+		return false;
+
+	CellList first = cells;
+	normalize(first, out_x, out_y);
+
+	// Evolve cells until the first shape comes around again
+	// Cells are kept relative to the origin of the first phase
+	out_ship.m_phases.clear();
+	CellList current = first;
+	CellList next;
+	for (unsigned int gen = 1; gen <= MAX_PERIOD; gen++)
+	{
+		out_ship.m_phases.emplace_back();
+		Phase& phase = out_ship.m_phases.back();
+		stepCells(current, ruleset, next, phase.births, phase.deaths);
+
+		phase.left = phase.right = current.front().first;
+		phase.top = phase.bottom = current.front().second;
+		for (const std::pair<int, int>& xy : current)
+		{
+			phase.left   = std::min(phase.left, xy.first);
+			phase.right  = std::max(phase.right, xy.first);
+			phase.top    = std::min(phase.top, xy.second);
+			phase.bottom = std::max(phase.bottom, xy.second);
+		}
+		phase.cells.swap(current);
+
+		// Died out or grew too large
+		if (next.empty() || next.size() > MAX_CELLS)
+			return false;
+
+		int dx, dy;
+		current = next;
+		normalize(next, dx, dy);
+		if (next == first)
+		{
+			// Same shape in the same place is an oscillator (or still life), not a spaceship
+			if (dx == 0 && dy == 0)
+				return false;
+
+			out_ship.m_dx = dx;
+			out_ship.m_dy = dy;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+int Spaceship::findPhase(const CellList& cells, int& out_x, int& out_y) const
+{
+	CellList shape = cells;
+	int x, y;
+	normalize(shape, x, y);
+
+	for (size_t i = 0; i < m_phases.size(); i++)
+	{
+		const Phase& phase = m_phases[i];
+		if (phase.cells.size() != shape.size())
+			continue;
+
+		// Phase cells are sorted, so compare in order after moving to the same origin
+		bool match = true;
+		for (size_t j = 0; j < shape.size() && match; j++)
+		{
+			match = (phase.cells[j].first  - phase.left == shape[j].first)
+			     && (phase.cells[j].second - phase.top  == shape[j].second);
+		}
+
+		if (match)
+		{
+			out_x = x - phase.left;
+			out_y = y - phase.top;
+			return static_cast<int>(i);
+		}
+	}
+
+	return -1;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Spaceship::advance(unsigned int phase, int x, int y, unsigned int generations, unsigned int& out_phase, int& out_x, int& out_y) const
+{
+	unsigned long long t = static_cast<unsigned long long>(phase) + generations;
+	int periods = static_cast<int>(t / m_phases.size());
+	out_phase = static_cast<unsigned int>(t % m_phases.size());
+	out_x = x + periods * m_dx;
+	out_y = y + periods * m_dy;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Spaceship::stepCells(const CellList& cells, const Ruleset& ruleset, CellList& out_cells, unsigned int& out_births, unsigned int& out_deaths)
+{
+	// Each alive cell adds itself as a neighbour of its surrounding cells
+	// After sorting, runs of equal positions give neighbour counts
+	static thread_local CellList neighbours;
+	neighbours.clear();
+	for (const std::pair<int, int>& xy : cells)
+		for (int oy = -1; oy <= 1; oy++)
+			for (int ox = -1; ox <= 1; ox++)
+				if (ox != 0 || oy != 0)
+					neighbours.emplace_back(xy.first + ox, xy.second + oy);
+	std::sort(neighbours.begin(), neighbours.end());
+
+	out_cells.clear();
+	out_births = 0;
+	unsigned int survivors = 0;
+	for (size_t i = 0; i < neighbours.size();)
+	{
+		size_t j = i;
+		while (j < neighbours.size() && neighbours[j] == neighbours[i])
+			j++;
+
+		bool alive = std::binary_search(cells.begin(), cells.end(), neighbours[i]);
+		if (alive ? ruleset.testSurvival(j - i) : ruleset.testBirth(j - i))
+		{
+			out_cells.push_back(neighbours[i]);
+			if (alive)
+				survivors++;
+			else
+				out_births++;
+		}
+		i = j;
+	}
+
+	// Alive cells without any neighbours are missed above
+	if (ruleset.testSurvival(0))
+	{
+		for (const std::pair<int, int>& xy : cells)
+		{
+			if (!std::binary_search(neighbours.begin(), neighbours.end(), xy))
+			{
+				out_cells.push_back(xy);
+				survivors++;
+			}
+		}
+		std::sort(out_cells.begin(), out_cells.end());
+	}
+
+	out_deaths = static_cast<unsigned int>(cells.size()) - survivors;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void Spaceship::normalize(CellList& io_cells, int& out_x, int& out_y)
+{
+	out_x = io_cells.front().first;
+	out_y = io_cells.front().second;
+	for (const std::pair<int, int>& xy : io_cells)
+	{
+		out_x = std::min(out_x, xy.first);
+		out_y = std::min(out_y, xy.second);
+	}
+
+	for (std::pair<int, int>& xy : io_cells)
+	{
+		xy.first  -= out_x;
+		xy.second -= out_y;
+	}
+	std::sort(io_cells.begin(), io_cells.end());
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/Spaceship.hpp
+//
+// class gol::Spaceship
+// 
+// Describes a pattern which repeats its shape after a number of
+// generations (its period), displaced by {dx,dy}. Spaceships are found by
+// evolving a small group of cells in isolation. gol::Simulation uses them
+// to track spaceships escaping the universe, without simulating (or
+// allocating chunks for) their cells.
+// 
+
+#include "Ruleset.hpp"
+#include <vector>
+#include <utility>
+
+
+namespace gol
+{
+
+class Spaceship
+{
+public:
+	typedef std::vector<std::pair<int,int>> CellList;
+
+	// Shape of a spaceship at one point of its period.
+	struct Phase
+	{
+		CellList cells;               //> Cell positions relative to the first phase's origin.
+		int left, top, right, bottom; //> Bounds of cells, inclusive.
+		unsigned int births;          //> Births going to the next phase.
+		unsigned int deaths;          //> Deaths going to the next phase.
+	};
+
+	// Longest period checked when identifying spaceships.
+	static const unsigned int MAX_PERIOD = 16;
+
+	// Most cells a pattern may have, in any phase, to be identified as a spaceship.
+	static const size_t MAX_CELLS = 32;
+
+	// Evolve cells in isolation and check whether they form a spaceship.
+	// On success, out_ship is filled with every phase, where the first phase is the cells given
+	// with their top-left bound at {out_x,out_y}.
+	static bool identify(const CellList& cells, const Ruleset& ruleset, Spaceship& out_ship, int& out_x, int& out_y);
+
+	// Find the phase matching the shape of cells given.
+	// Returns the phase index and sets the origin {out_x,out_y} of the cells, or returns -1 if not matched.
+	int findPhase(const CellList& cells, int& out_x, int& out_y) const;
+
+	// Get the phase and origin of this spaceship some generations after being at phase with origin {x,y}.
+	void advance(unsigned int phase, int x, int y, unsigned int generations, unsigned int& out_phase, int& out_x, int& out_y) const;
+
+	// Get number of generations before the shape repeats.
+	inline unsigned int getPeriod() const { return static_cast<unsigned int>(m_phases.size()); }
+
+	// Get horizontal displacement every period.
+	inline int getDX() const { return m_dx; }
+
+	// Get vertical displacement every period.
+	inline int getDY() const { return m_dy; }
+
+	// Get phase by index. Must be less than getPeriod().
+	inline const Phase& getPhase(unsigned int phase) const { return m_phases[phase]; }
+
+private:
+	std::vector<Phase> m_phases;
+	int m_dx;
+	int m_dy;
+
+	// Internal: Step cells in isolation to their next generation. Output is sorted.
+	static void stepCells(const CellList& cells, const Ruleset& ruleset, CellList& out_cells, unsigned int& out_births, unsigned int& out_deaths);
+
+	// Internal: Sort cells and move them so their top-left bound is {0,0}. Sets {out_x,out_y} to the original bound.
+	static void normalize(CellList& io_cells, int& out_x, int& out_y);
+};
+
+}
@@ -0,0 +1,182 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/StepProfile.cpp
+// 
+// Implements class gol::StepProfile
+// 
+
+#include "StepProfile.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace gol;
+
+
+//////////////////////////////////////////////////////////////////////
+void StepProfile::Sample::clear(size_t workers)
+{
+	std::fill(phases, phases + PHASE_COUNT, 0.f);
+	barrier = 0.f;
+	workerBusy.assign(workers, 0.f);
+	std::fill(chunks, chunks + SLEEP_MODES, 0);
+	chunksCreated = 0;
+	chunksFreed = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+StepProfile::StepProfile()
+	: m_next(0)
+{
+
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void StepProfile::record(const Sample& sample)
+{
+	if (m_samples.size() < WINDOW)
+	{
+		m_samples.push_back(sample);
+		return;
+	}
+
+	// Copy into the oldest sample, reusing its worker buffer
+	Sample& oldest = m_samples[m_next];
+	std::copy(sample.phases, sample.phases + PHASE_COUNT, oldest.phases);
+	oldest.barrier = sample.barrier;
+	oldest.workerBusy.assign(sample.workerBusy.begin(), sample.workerBusy.end());
+	std::copy(sample.chunks, sample.chunks + SLEEP_MODES, oldest.chunks);
+	oldest.chunksCreated = sample.chunksCreated;
+	oldest.chunksFreed = sample.chunksFreed;
+	m_next = (m_next + 1) % WINDOW;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void StepProfile::clear()
+{
+	m_samples.clear();
+	m_next = 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+template <typename Fn>
+StepProfile::Summary StepProfile::summarise(Fn value) const
+{
+	Summary summary = { 0.f, 0.f, 0.f, 0.f, 0.f };
+	if (m_samples.empty())
+		return summary;
+
+	std::vector<float> values;
+	values.reserve(m_samples.size());
+	for (const Sample& sample : m_samples)
+		values.push_back(value(sample));
+	std::sort(values.begin(), values.end());
+
+	const size_t last = values.size() - 1;
+	summary.average = std::accumulate(values.begin(), values.end(), 0.f) / values.size();
+	summary.p50 = values[last * 50 / 100];
+	summary.p95 = values[last * 95 / 100];
+	summary.p99 = values[last * 99 / 100];
+	summary.max = values[last];
+	return summary;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+StepProfile::Stats StepProfile::getStats() const
+{
+	Stats stats;
+	stats.steps = static_cast<unsigned int>(m_samples.size());
+
+	stats.total = this->summarise([](const Sample& s) { return std::accumulate(s.phases, s.phases + PHASE_COUNT, 0.f); });
+	for (int i = 0; i < PHASE_COUNT; i++)
+		stats.phases[i] = this->summarise([i](const Sample& s) { return s.phases[i]; });
+	stats.barrier = this->summarise([](const Sample& s) { return s.barrier; });
+
+	// Workers are summarised over steps with the current number of workers
+	const size_t workers = m_samples.empty() ? 0 : m_samples[(m_next + m_samples.size() - 1) % m_samples.size()].workerBusy.size();
+	stats.workerBusy.assign(workers, 0.f);
+	stats.workerIdle.assign(workers, 0.f);
+	unsigned int workerSteps = 0;
+
+	std::fill(stats.chunks, stats.chunks + SLEEP_MODES, 0.f);
+	stats.chunksCreated = 0.f;
+	stats.chunksFreed = 0.f;
+
+	for (const Sample& sample : m_samples)
+	{
+		for (size_t mode = 0; mode < SLEEP_MODES; mode++)
+			stats.chunks[mode] += sample.chunks[mode];
+		stats.chunksCreated += sample.chunksCreated;
+		stats.chunksFreed += sample.chunksFreed;
+
+		if (sample.workerBusy.size() != workers)
+			continue;
+		const float working = sample.phases[Update] + sample.phases[Apply];
+		for (size_t i = 0; i < workers; i++)
+		{
+			stats.workerBusy[i] += sample.workerBusy[i];
+			stats.workerIdle[i] += std::max(working - sample.workerBusy[i], 0.f);
+		}
+		workerSteps++;
+	}
+
+	if (stats.steps > 0)
+	{
+		for (size_t mode = 0; mode < SLEEP_MODES; mode++)
+			stats.chunks[mode] /= stats.steps;
+		stats.chunksCreated /= stats.steps;
+		stats.chunksFreed /= stats.steps;
+	}
+	for (size_t i = 0; i < workers && workerSteps > 0; i++)
+	{
+		stats.workerBusy[i] /= workerSteps;
+		stats.workerIdle[i] /= workerSteps;
+	}
+
+	return stats;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+const char* StepProfile::getPhaseName(EPhase phase)
+{
+	switch (phase)
+	{
+	case Edits:     return "edits";
+	case Escapees:  return "escapees";
+	case NewChunks: return "new chunks";
+	case Compress:  return "compress";
+	case Update:    return "update";
+	case Apply:     return "apply";
+	case Free:      return "free";
+	case Period:    return "period";
+	default:        return "";
+	}
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/StepProfile.hpp
+//
+// class gol::StepProfile
+// 
+// Where the time of recent simulation steps went: each phase of a step,
+// waiting for workers, how busy each worker was, and how many chunks were
+// updated in each sleep mode. Samples of the last WINDOW steps are kept,
+// and summarised into averages and percentiles on request.
+// 
+
+#include "Chunk.hpp"
+#include <chrono>
+#include <vector>
+
+
+namespace gol
+{
+
+class StepProfile
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	// Number of recent steps summarised.
+	static const size_t WINDOW = 256;
+
+	// Number of chunk sleep modes, see Chunk::ESleepMode.
+	static const size_t SLEEP_MODES = Chunk::Periodic + 1;
+
+	enum EPhase
+	{
+		// Setting queued cell edits.
+		Edits,
+
+		// Returning, stepping and finding escaped spaceships.
+		Escapees,
+
+		// Creating chunks next to chunks with alive border cells.
+		NewChunks,
+
+		// Compressing sleeping chunks, and decompressing disturbed periodic chunks.
+		Compress,
+
+		// Updating next generation cell states of every chunk.
+		Update,
+
+		// Applying next generation cell states of every chunk.
+		Apply,
+
+		// Freeing chunks which have been inactive for a while.
+		Free,
+
+		// Checking whether the whole universe is periodic.
+		Period,
+
+		PHASE_COUNT
+	};
+
+	// Measurements of a single step. Times are in seconds.
+	struct Sample
+	{
+		float phases[PHASE_COUNT];
+		float barrier;                     //> Waiting for workers to finish updating or applying chunks.
+		std::vector<float> workerBusy;     //> Time each worker spent processing chunks.
+		unsigned int chunks[SLEEP_MODES];  //> Chunks updated in each sleep mode.
+		unsigned int chunksCreated;
+		unsigned int chunksFreed;
+
+		// Zero every measurement, for a step with the given number of workers.
+		void clear(size_t workers);
+	};
+
+	// Rolling statistics of one measurement over recent steps.
+	struct Summary
+	{
+		float average;
+		float p50;
+		float p95;
+		float p99;
+		float max;
+	};
+
+	// Summary of recent steps, see Simulation::getStats(). Times are in seconds.
+	struct Stats
+	{
+		unsigned int steps;               //> Steps summarised, up to WINDOW.
+		Summary total;                    //> Whole steps.
+		Summary phases[PHASE_COUNT];
+		Summary barrier;                  //> Zero when single-threaded.
+		std::vector<float> workerBusy;    //> Average time per step each worker spent processing chunks.
+		std::vector<float> workerIdle;    //> Average time per step each worker waited while chunks were updated and applied.
+		float chunks[SLEEP_MODES];        //> Average chunks updated per step in each sleep mode.
+		float chunksCreated;              //> Average chunks created per step.
+		float chunksFreed;                //> Average chunks freed per step.
+	};
+
+	StepProfile();
+
+	// Add measurements of a step, replacing the oldest once WINDOW steps are kept.
+	void record(const Sample& sample);
+
+	// Remove all recorded steps.
+	void clear();
+
+	// Summarise recorded steps.
+	Stats getStats() const;
+
+	// Get name of a phase, for display.
+	static const char* getPhaseName(EPhase phase);
+
+	// Get seconds elapsed between two points in time.
+	static inline float seconds(Clock::time_point from, Clock::time_point to) {
+		return std::chrono::duration<float>(to - from).count();
+	}
+
+private:
+	std::vector<Sample> m_samples;
+	size_t m_next; //> Index of the sample replaced next, once WINDOW steps are kept.
+
+	// Internal: Summarise one measurement of every recorded step.
+	template <typename Fn>
+	Summary summarise(Fn value) const;
+};
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// gol/Universe.hpp
+// 
+// class gol::Universe
+// 
+// Abstraction interface for simulation universes. Provides the common
+// controls shared by every simulation engine (stepping, cell access,
+// rulesets, population statistics and multithreading), so that scenes
+// and tools may drive any engine without knowing how it stores cells.
+// 
+
+#include "Ruleset.hpp"
+
+
+namespace gol
+{
+
+class Universe
+{
+public:
+	virtual ~Universe() { }
+
+	// Resets the entire universe.
+	// resetGeneration: Resets generation counter to zero.
+	virtual void reset(bool resetGeneration = true) = 0;
+
+	// Steps the universe once. This will move on to the next generation of the simulation.
+	virtual void step() = 0;
+
+	// Set alive state for cell at position {x,y}.
+	virtual void setCell(int x, int y, bool alive) = 0;
+
+	// Get alive state for cell at position {x,y}.
+	virtual bool getCell(int x, int y) const = 0;
+
+	// Get the current generation.
+	virtual unsigned int getGeneration() const = 0;
+
+	// Get number of births for this generation.
+	virtual unsigned int getBirths() const = 0;
+
+	// Get number of deaths for this generation.
+	virtual unsigned int getDeaths() const = 0;
+
+	// Get the count of currently alive cells.
+	virtual unsigned int getPopulation() const = 0;
+
+	// Get simulation rule-set.
+	virtual const Ruleset& getRuleset() const = 0;
+
+	// Set simulation rule-set.
+	virtual void setRuleset(const Ruleset& ruleset) = 0;
+
+	// Enable or disable multithreading mode.
+	virtual void setMultithreadMode(bool enable) = 0;
+
+	// Get whether the universe is multithreaded.
+	virtual bool isMultithreaded() const = 0;
+
+	// Get number of worker threads running.
+	// Returns 0 if multithreading mode is disabled.
+	virtual size_t getWorkerThreadCount() const = 0;
+};
+
+}
@@ -0,0 +1,327 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// Headless/main.cpp
+// 
+// Entry point of the headless runner. Steps a simulation as fast as it
+// can, without a window or rendering, then prints throughput and final
+// statistics. Only links the gol engine.
+// 
+
+#include "gol/Simulation.hpp"
+#include "gol/Pattern.hpp"
+#include "Version.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <string>
+
+using namespace gol;
+
+
+struct Options
+{
+	std::string rule;
+	std::string patternPath;
+	int soupWidth = 256;
+	int soupHeight = 256;
+	float soupDensity = 0.5f;
+	uint64_t seed = 1;
+	unsigned int generations = 1000;
+	size_t threads = 0;
+	unsigned int reportInterval = 0;
+	bool fastForward = false;
+};
+
+
+//////////////////////////////////////////////////////////////////////
+static void printUsage(const char* program)
+{
+	std::cout
+		<< "usage: " << program << " [options]" << std::endl
+		<< std::endl
+		<< "  -r, --rule RULE         rule-string in B/S notation (default: pattern's rule, or B3/S23)" << std::endl
+		<< "  -p, --pattern FILE      start from an RLE (.rle) or plaintext (.cells) pattern file" << std::endl
+		<< "  -s, --soup WxH          start from a random soup of W by H cells (default: 256x256)" << std::endl
+		<< "  -d, --density D         chance of soup cells being alive, 0 to 1 (default: 0.5)" << std::endl
+		<< "      --seed N            seed of the random soup (default: 1)" << std::endl
+		<< "  -g, --generations N     number of generations to run (default: 1000)" << std::endl
+		<< "  -t, --threads N         worker threads, 1 runs single-threaded (default: 0, one per core)" << std::endl
+		<< "      --report N          print progress every N generations (default: 0, never)" << std::endl
+		<< "      --fast-forward      skip whole cycles once the universe is stable" << std::endl
+		<< "  -h, --help              show this message" << std::endl;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// Parse a decimal count, rejecting anything that does not fit in an unsigned int.
+static bool parseCount(const char* str, unsigned int& out_value)
+{
+	if (*str < '0' || *str > '9')
+		return false;
+	char* end = nullptr;
+	const unsigned long long value = std::strtoull(str, &end, 10);
+	if (*end != '\0' || value > std::numeric_limits<unsigned int>::max())
+		return false;
+	out_value = static_cast<unsigned int>(value);
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+static bool parseOptions(int argc, char** argv, Options& out_options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		auto value = [&]() -> const char* {
+			if (i + 1 >= argc)
+			{
+				std::cerr << "missing value for " << arg << std::endl;
+				return nullptr;
+			}
+			return argv[++i];
+		};
+
+		const char* v = nullptr;
+		if (arg == "-h" || arg == "--help")
+		{
+			printUsage(argv[0]);
+			std::exit(0);
+		}
+		else if (arg == "--fast-forward")
+		{
+			out_options.fastForward = true;
+		}
+		else if (arg == "-r" || arg == "--rule")
+		{
+			if (!(v = value()))
+				return false;
+			out_options.rule = v;
+		}
+		else if (arg == "-p" || arg == "--pattern")
+		{
+			if (!(v = value()))
+				return false;
+			out_options.patternPath = v;
+		}
+		else if (arg == "-s" || arg == "--soup")
+		{
+			if (!(v = value()))
+				return false;
+			char* end = nullptr;
+			out_options.soupWidth = static_cast<int>(std::strtol(v, &end, 10));
+			out_options.soupHeight = (*end == 'x') ? static_cast<int>(std::strtol(end + 1, &end, 10)) : out_options.soupWidth;
+			if (*end != '\0' || out_options.soupWidth <= 0 || out_options.soupHeight <= 0)
+			{
+				std::cerr << "invalid soup size " << v << std::endl;
+				return false;
+			}
+		}
+		else if (arg == "-d" || arg == "--density")
+		{
+			if (!(v = value()))
+				return false;
+			out_options.soupDensity = std::strtof(v, nullptr);
+		}
+		else if (arg == "--seed")
+		{
+			if (!(v = value()))
+				return false;
+			out_options.seed = std::strtoull(v, nullptr, 10);
+		}
+		else if (arg == "-g" || arg == "--generations")
+		{
+			if (!(v = value()))
+				return false;
+			if (!parseCount(v, out_options.generations))
+			{
+				std::cerr << "invalid generation count " << v << std::endl;
+				return false;
+			}
+		}
+		else if (arg == "-t" || arg == "--threads")
+		{
+			if (!(v = value()))
+				return false;
+			out_options.threads = static_cast<size_t>(std::strtoul(v, nullptr, 10));
+		}
+		else if (arg == "--report")
+		{
+			if (!(v = value()))
+				return false;
+			if (!parseCount(v, out_options.reportInterval))
+			{
+				std::cerr << "invalid report interval " << v << std::endl;
+				return false;
+			}
+		}
+		else
+		{
+			std::cerr << "unknown option " << arg << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	// Load the starting pattern
+	Pattern pattern;
+	if (!options.patternPath.empty())
+	{
+		if (!pattern.load(options.patternPath))
+			return 1;
+	}
+	else
+	{
+		pattern.randomize(options.soupWidth, options.soupHeight, options.soupDensity, options.seed);
+	}
+
+	std::string rule = !options.rule.empty() ? options.rule : !pattern.getRule().empty() ? pattern.getRule() : "B3/S23";
+	Ruleset ruleset;
+	if (!ruleset.set(rule))
+	{
+		std::cerr << "invalid rule-string " << rule << std::endl;
+		return 1;
+	}
+
+	Simulation sim;
+	sim.setThreadCount(options.threads);
+	sim.setRuleset(ruleset);
+	pattern.place(sim, -pattern.getWidth() / 2, -pattern.getHeight() / 2);
+
+	std::cout << "game of life v" << VERSION_STRING << " (headless)" << std::endl;
+	if (!options.patternPath.empty())
+		std::cout << "pattern     : " << options.patternPath << (pattern.getName().empty() ? "" : " (" + pattern.getName() + ")") << std::endl;
+	else
+		std::cout << "soup        : " << options.soupWidth << "x" << options.soupHeight << ", density " << options.soupDensity << ", seed " << options.seed << std::endl;
+	std::cout << "rule        : " << ruleset.getString() << std::endl
+	          << "threads     : " << (sim.isMultithreaded() ? sim.getWorkerThreadCount() : 1) << std::endl
+	          << "population  : " << sim.getPopulation() << std::endl
+	          << std::endl;
+
+	// Step as fast as possible, counting cells of each generation stepped from
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = Clock::now();
+	const unsigned int firstGeneration = sim.getGeneration();
+	uint64_t cellsStepped = 0;
+	unsigned int peakChunks = sim.getChunkCount();
+	unsigned int done = 0;
+	while (done < options.generations)
+	{
+		unsigned int batch = options.generations - done;
+		if (options.reportInterval > 0)
+			batch = std::min(batch, options.reportInterval);
+
+		if (options.fastForward)
+		{
+			cellsStepped += static_cast<uint64_t>(sim.getPopulation()) * batch;
+			sim.fastForward(batch);
+			peakChunks = std::max(peakChunks, sim.getChunkCount());
+		}
+		else
+		{
+			for (unsigned int i = 0; i < batch; i++)
+			{
+				cellsStepped += sim.getPopulation();
+				sim.step();
+				peakChunks = std::max(peakChunks, sim.getChunkCount());
+			}
+		}
+		done += batch;
+
+		if (options.reportInterval > 0 && done < options.generations)
+		{
+			const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+			std::cout << "generation " << sim.getGeneration() << ": population " << sim.getPopulation()
+			          << ", chunks " << sim.getChunkCount() << ", " << std::fixed << std::setprecision(1)
+			          << done / elapsed << " gen/s" << std::defaultfloat << std::endl;
+		}
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	const unsigned int generations = sim.getGeneration() - firstGeneration;
+	std::cout << std::fixed << std::setprecision(3)
+	          << "generations : " << generations << std::endl
+	          << "time (s)    : " << seconds << std::endl
+	          << "gen/s       : " << (seconds > 0 ? generations / seconds : 0.0) << std::endl
+	          << "cells/s     : " << (seconds > 0 ? cellsStepped / seconds : 0.0) << std::endl
+	          << std::defaultfloat
+	          << std::endl
+	          << "generation  : " << sim.getGeneration() << std::endl
+	          << "population  : " << sim.getPopulation() << std::endl
+	          << "births      : " << sim.getBirths() << std::endl
+	          << "deaths      : " << sim.getDeaths() << std::endl
+	          << "chunks      : " << sim.getChunkCount() << " (peak " << peakChunks << ")" << std::endl
+	          << "  sparse    : " << sim.getSparseChunkCount() << std::endl
+	          << "  dense     : " << sim.getDenseChunkCount() << std::endl
+	          << "  allocated : " << sim.getAllocatedChunkCount() << std::endl
+	          << "  compressed: " << sim.getCompressedChunkCount() << std::endl
+	          << "escapees    : " << sim.getEscapeeCount() << std::endl;
+
+	int left, top, right, bottom;
+	if (sim.getBounds(left, top, right, bottom))
+		std::cout << "bounds      : (" << left << ", " << top << ") to (" << right << ", " << bottom << ")" << std::endl;
+	if (sim.isStable())
+		std::cout << "period      : " << sim.getPeriod() << std::endl;
+
+	// Where the time of the last steps went
+	const StepProfile::Stats stats = sim.getStats();
+	if (stats.steps > 0)
+	{
+		std::cout << std::endl << std::fixed << std::setprecision(3)
+		          << "step (ms)   : " << stats.total.average * 1000.f << " (p50=" << stats.total.p50 * 1000.f
+		          << ", p95=" << stats.total.p95 * 1000.f << ", p99=" << stats.total.p99 * 1000.f
+		          << ", last " << stats.steps << " steps)" << std::endl;
+		for (int i = 0; i < StepProfile::PHASE_COUNT; i++)
+		{
+			std::string name = StepProfile::getPhaseName(static_cast<StepProfile::EPhase>(i));
+			name.resize(10, ' ');
+			std::cout << "  " << name << ": " << stats.phases[i].average * 1000.f << std::endl;
+		}
+		if (!stats.workerBusy.empty())
+		{
+			std::cout << "  barrier   : " << stats.barrier.average * 1000.f << std::endl;
+			for (size_t i = 0; i < stats.workerBusy.size(); i++)
+				std::cout << "  worker " << i << "  : busy=" << stats.workerBusy[i] * 1000.f << " idle=" << stats.workerIdle[i] * 1000.f << std::endl;
+		}
+		std::cout << std::defaultfloat;
+	}
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// Tests/Check.hpp
+// 
+// Minimal checks shared by the gol engine tests. A failed check prints
+// what failed and is counted, and the test's exit code is non-zero if
+// any check failed. Checks may be made from any thread.
+// 
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+
+namespace test
+{
+
+// Get the count of failed checks.
+inline std::atomic<unsigned int>& failures()
+{
+	static std::atomic<unsigned int> count(0);
+	return count;
+}
+
+// Check a condition, printing what was expected if it doesn't hold. Returns the condition.
+inline bool check(bool condition, const std::string& what)
+{
+	if (!condition)
+	{
+		static std::mutex printGuard;
+		std::lock_guard<std::mutex> lock(printGuard);
+		std::cerr << "check failed: " << what << std::endl;
+		failures()++;
+	}
+	return condition;
+}
+
+// Get the test's exit code, printing a summary.
+inline int result(const char* name)
+{
+	const unsigned int failed = failures();
+	if (failed > 0)
+		std::cerr << name << ": " << failed << " check(s) failed!" << std::endl;
+	else
+		std::cout << name << ": passed" << std::endl;
+	return (failed > 0) ? 1 : 0;
+}
+
+}
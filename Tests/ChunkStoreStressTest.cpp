@@ -0,0 +1,140 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// Tests/ChunkStoreStressTest.cpp
+// 
+// Stress test of chunks sharing compressed buffers while stepping with
+// worker threads. A field of identical chunks is compressed into a single
+// shared buffer, then sparks on chunk edges wake many of them in the same
+// step, so worker threads copy cells out of the buffer and drop their
+// references at once. Every generation must match the same field stepped
+// on the calling thread, and once the chunks sleep again they must share
+// one buffer again. Build with GOL_SANITIZE=thread to check for data races
+// as well.
+// 
+
+#include "Check.hpp"
+#include "gol/Simulation.hpp"
+#include <string>
+#include <utility>
+#include <vector>
+
+
+static const int CHUNK_SIZE = static_cast<int>(gol::Chunk::CHUNK_SIZE);
+static const int FIELD_CHUNKS = 12;       //> Field is FIELD_CHUNKS * FIELD_CHUNKS chunks.
+static const int FIELD_SIZE = FIELD_CHUNKS * CHUNK_SIZE;
+static const unsigned int WAKE_CYCLES = 4;
+static const size_t THREADS = 4;
+
+// Spark placed one cell in from a chunk's west edge. Its first generation has cells on the edge,
+// waking the west neighbour, and it dies out within 3 generations.
+static const std::pair<int,int> SPARK[] = { { 1, 0 }, { 1, 1 }, { 1, 2 }, { 3, 0 } };
+
+
+// Read every cell of the field.
+static std::vector<uint64_t> readField(const gol::Simulation& sim)
+{
+	const size_t stride = FIELD_SIZE / 64;
+	std::vector<uint64_t> bitmap(stride * FIELD_SIZE);
+	sim.readCells(0, 0, FIELD_SIZE, FIELD_SIZE, bitmap.data(), stride);
+	return bitmap;
+}
+
+
+// Set a cell of both simulations.
+static void setCell(gol::Simulation& sim, gol::Simulation& reference, int x, int y)
+{
+	sim.setCell(x, y, true);
+	reference.setCell(x, y, true);
+}
+
+
+// Step both simulations once, counting generations which differ.
+static unsigned int step(gol::Simulation& sim, gol::Simulation& reference)
+{
+	sim.step();
+	reference.step();
+	return (sim.getPopulation() != reference.getPopulation() || readField(sim) != readField(reference)) ? 1 : 0;
+}
+
+
+int main()
+{
+	gol::Simulation sim;
+	gol::Simulation reference;
+	sim.setThreadCount(THREADS);
+	reference.setThreadCount(1);
+
+	// The same beehive in every chunk
+	for (int row = 0; row < FIELD_CHUNKS; row++)
+	{
+		for (int column = 0; column < FIELD_CHUNKS; column++)
+		{
+			const int x = column * CHUNK_SIZE + 30;
+			const int y = row * CHUNK_SIZE + 20;
+			for (const std::pair<int,int>& cell : { std::make_pair(1, 0), std::make_pair(2, 0), std::make_pair(0, 1), std::make_pair(3, 1), std::make_pair(1, 2), std::make_pair(2, 2) })
+				setCell(sim, reference, x + cell.first, y + cell.second);
+		}
+	}
+	const std::vector<uint64_t> field = readField(sim);
+
+	// Chunks sleep from the start, so are compressed by the first check after COMPRESS_SLEEP_STEPS
+	const unsigned int compressSteps = (gol::Chunk::COMPRESS_SLEEP_STEPS / gol::Simulation::COMPRESS_CHECK_INTERVAL + 2) * gol::Simulation::COMPRESS_CHECK_INTERVAL;
+	unsigned int mismatches = 0;
+	while (sim.getGeneration() <= compressSteps)
+		mismatches += step(sim, reference);
+	test::check(sim.getCompressedChunkCount() == FIELD_CHUNKS * FIELD_CHUNKS, "identical chunks are compressed");
+	test::check(sim.getChunkStore().getSize() == 1, "identical chunks share one buffer");
+
+	unsigned int woken = 0;
+	for (unsigned int cycle = 0; cycle < WAKE_CYCLES; cycle++)
+	{
+		const std::string when = ", cycle " + std::to_string(cycle);
+
+		// Sparks in every other column (alternating each cycle) wake their west neighbours in the same step
+		for (int row = 0; row < FIELD_CHUNKS; row++)
+			for (int column = 1 + static_cast<int>(cycle % 2); column < FIELD_CHUNKS; column += 2)
+				for (const std::pair<int,int>& spark : SPARK)
+					setCell(sim, reference, column * CHUNK_SIZE + spark.first, row * CHUNK_SIZE + 45 + spark.second);
+
+		const unsigned int compressed = sim.getCompressedChunkCount();
+		mismatches += step(sim, reference);
+		mismatches += step(sim, reference);
+		woken += compressed - sim.getCompressedChunkCount();
+
+		// Sparks die out, and chunks share a buffer again once compressed
+		const unsigned int compressAt = sim.getGeneration() + compressSteps;
+		while (sim.getGeneration() <= compressAt)
+			mismatches += step(sim, reference);
+		test::check(readField(sim) == field, "sparks leave the field as it was" + when);
+		test::check(sim.getCompressedChunkCount() == FIELD_CHUNKS * FIELD_CHUNKS, "woken chunks are compressed again" + when);
+		test::check(sim.getChunkStore().getSize() == 1, "woken chunks share one buffer again, of " + std::to_string(sim.getChunkStore().getSize()) + when);
+	}
+
+	test::check(mismatches == 0, std::to_string(mismatches) + " generation(s) differ from stepping on the calling thread");
+	test::check(woken >= WAKE_CYCLES * FIELD_CHUNKS * (FIELD_CHUNKS / 2), "sparks wake chunks sharing the buffer while stepping, " + std::to_string(woken) + " woken");
+
+	std::cout << woken << " shared chunks woken while stepping with " << THREADS << " threads" << std::endl;
+	return test::result("chunk store stress");
+}
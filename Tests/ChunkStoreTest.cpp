@@ -0,0 +1,171 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// Tests/ChunkStoreTest.cpp
+// 
+// Tests of gol::ChunkStore. Identical compressed chunks must share one
+// buffer, and a chunk modified after being compressed must make its own
+// cells without changing the chunks (or snapshots) sharing its buffer.
+// 
+
+#include "Check.hpp"
+#include "gol/Simulation.hpp"
+#include <climits>
+#include <string>
+#include <vector>
+
+
+static const int CHUNK_SIZE = static_cast<int>(gol::Chunk::CHUNK_SIZE);
+static const int CHUNK_COUNT = 32;           //> Chunks in a row holding identical blocks.
+
+
+// Make compressed cells from a format byte and data.
+static gol::CompressedCells makeCells(uint64_t edge, std::vector<unsigned char> data)
+{
+	gol::CompressedCells cells;
+	for (uint64_t& e : cells.edges)
+		e = edge;
+	cells.data = std::move(data);
+	return cells;
+}
+
+
+// Place a block (2x2 still life) with its top left cell at {x,y}.
+static void placeBlock(gol::Simulation& sim, int x, int y)
+{
+	sim.setCell(x, y, true);
+	sim.setCell(x + 1, y, true);
+	sim.setCell(x, y + 1, true);
+	sim.setCell(x + 1, y + 1, true);
+}
+
+
+// Read cells of the chunk at {column,0}.
+static std::vector<uint64_t> readChunk(const gol::Simulation& sim, int column)
+{
+	std::vector<uint64_t> cells(CHUNK_SIZE);
+	sim.readCells(column * CHUNK_SIZE, 0, CHUNK_SIZE, CHUNK_SIZE, cells.data(), 1);
+	return cells;
+}
+
+
+// Intern buffers into a store directly.
+static void testIntern()
+{
+	gol::ChunkStore store;
+	gol::ChunkStore::Handle a = store.intern(makeCells(1, { 0, 1, 2, 3 }));
+	gol::ChunkStore::Handle b = store.intern(makeCells(1, { 0, 1, 2, 3 }));
+	gol::ChunkStore::Handle c = store.intern(makeCells(1, { 0, 1, 2, 4 }));
+	gol::ChunkStore::Handle d = store.intern(makeCells(2, { 0, 1, 2, 3 }));
+
+	test::check(a == b, "identical cells share a buffer");
+	test::check(a != c, "cells with different data don't share a buffer");
+	test::check(a != d, "cells with different edges don't share a buffer");
+	test::check(b->data == std::vector<unsigned char>({ 0, 1, 2, 3 }), "shared buffer holds the cells");
+
+	store.collect({ { a.get(), 2 }, { c.get(), 1 }, { d.get(), 1 } });
+	test::check(store.getSize() == 3, "store counts distinct buffers");
+	test::check(store.getReferencedBytes() > store.getUniqueBytes(), "store counts shared bytes once");
+	test::check(store.getDedupRatio() > 1.f, "dedup ratio counts sharing");
+
+	// Buffers still held, but not by chunks, are collected as well
+	d.reset();
+	store.collect({ { a.get(), 2 } });
+	test::check(store.getSize() == 1, "unused buffers are collected");
+	test::check(store.getReferencedBytes() == store.getUniqueBytes() * 2, "only uses by chunks are counted");
+	test::check(c->data == std::vector<unsigned char>({ 0, 1, 2, 4 }), "handles outlive their buffer being collected");
+	test::check(store.intern(makeCells(1, { 0, 1, 2, 3 })) == a, "buffers in use are kept");
+
+	store.clear();
+	test::check(store.getSize() == 0, "clearing removes all buffers");
+	test::check(a->data == std::vector<unsigned char>({ 0, 1, 2, 3 }), "handles outlive the store clearing");
+}
+
+
+// Compress chunks of a simulation holding identical cells, then modify one.
+static void testSharedChunks()
+{
+	gol::Simulation sim;
+	sim.setThreadCount(1);
+	for (int column = 0; column < CHUNK_COUNT; column++)
+		placeBlock(sim, column * CHUNK_SIZE * 2 + 20, 20);
+
+	// Chunks sleep from the start, so are compressed by the first check after COMPRESS_SLEEP_STEPS
+	const unsigned int compressAt = (gol::Chunk::COMPRESS_SLEEP_STEPS / gol::Simulation::COMPRESS_CHECK_INTERVAL + 2) * gol::Simulation::COMPRESS_CHECK_INTERVAL;
+	while (sim.getGeneration() <= compressAt)
+		sim.step();
+
+	const std::vector<uint64_t> block = readChunk(sim, 0);
+	test::check(sim.getCompressedChunkCount() == CHUNK_COUNT, "sleeping chunks are compressed");
+	test::check(sim.getChunkStore().getSize() == 1, "identical chunks share one buffer, of " + std::to_string(sim.getChunkStore().getSize()));
+	test::check(sim.getCompressedDedupRatio() >= CHUNK_COUNT, "dedup ratio counts every chunk sharing the buffer");
+	const size_t blockBytes = sim.getChunkStore().getUniqueBytes();
+	for (int column = 1; column < CHUNK_COUNT; column++)
+		test::check(readChunk(sim, column * 2) == block, "compressed chunk " + std::to_string(column) + " holds its cells");
+
+	unsigned int mismatches = 0;
+	for (int y = 0; y < CHUNK_SIZE; y++)
+		for (int x = 0; x < CHUNK_SIZE; x++)
+			if (((block[y] >> x) & 1) != sim.getCell(x, y))
+				mismatches++;
+	test::check(mismatches == 0, "cells of compressed chunks are read one at a time");
+
+	// Modifying one chunk leaves the others, and snapshots of it, as they were
+	std::shared_ptr<const gol::Snapshot> before = sim.snapshot();
+	placeBlock(sim, 40, 40);
+	const std::vector<uint64_t> modified = readChunk(sim, 0);
+	test::check(modified != block, "modified chunk holds its new cells");
+	for (int column = 1; column < CHUNK_COUNT; column++)
+		test::check(readChunk(sim, column * 2) == block, "chunk " + std::to_string(column) + " is unchanged by modifying a chunk sharing its buffer");
+
+	uint64_t cells[gol::Chunk::CHUNK_SIZE];
+	unsigned int unchanged = 0;
+	before->forEachChunkIn(INT_MIN / 2, INT_MIN / 2, INT_MAX / 2, INT_MAX / 2, [&](const gol::ChunkSnapshot& chunk) {
+		chunk.getCells(cells);
+		if (std::vector<uint64_t>(cells, cells + CHUNK_SIZE) == block)
+			unchanged++;
+	});
+	test::check(unchanged == CHUNK_COUNT, "snapshot is unchanged by modifying a chunk sharing its buffer");
+
+	// Once asleep long enough, the modified chunk is compressed into a buffer of its own
+	while (sim.getGeneration() <= compressAt * 2)
+		sim.step();
+	test::check(sim.getCompressedChunkCount() == CHUNK_COUNT, "modified chunk is compressed again");
+	test::check(sim.getChunkStore().getSize() == 2, "modified chunk has a buffer of its own");
+
+	// Snapshots (including those kept by chunks for reuse) holding buffers don't count as chunks using them
+	const size_t modifiedBytes = sim.getChunkStore().getUniqueBytes() - blockBytes;
+	test::check(sim.getChunkStore().getReferencedBytes() == blockBytes * (CHUNK_COUNT - 1) + modifiedBytes, "referenced bytes only count chunks using each buffer");
+	test::check(readChunk(sim, 0) == modified, "modified chunk keeps its cells once compressed");
+	for (int column = 1; column < CHUNK_COUNT; column++)
+		test::check(readChunk(sim, column * 2) == block, "chunk " + std::to_string(column) + " keeps its cells once compressed");
+}
+
+
+int main()
+{
+	testIntern();
+	testSharedChunks();
+	return test::result("chunk store");
+}
@@ -0,0 +1,95 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// Tests/ConcurrentSimulationTest.cpp
+// 
+// Independent simulations stepped on different threads at once must not
+// share any state. Each soup is stepped alone, then again alongside the
+// others, and must end the same either way. Escaping spaceships are
+// released, so the escapee checks run too. Build with GOL_SANITIZE=thread
+// to check for data races as well.
+// 
+
+#include "Check.hpp"
+#include "gol/Simulation.hpp"
+#include "gol/Pattern.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+
+static const unsigned int SIMULATIONS = 4;
+static const unsigned int GENERATIONS = 1200;
+
+
+struct Outcome
+{
+	unsigned int population;
+	unsigned int chunks;
+	unsigned int escapees;
+};
+
+
+// Step a seeded soup, returning how it ended.
+static Outcome runSoup(uint64_t seed)
+{
+	gol::Simulation sim;
+	sim.setThreadCount(1);
+
+	gol::Pattern soup;
+	soup.randomize(128, 128, 0.3f, seed);
+	soup.place(sim, 0, 0);
+	for (unsigned int i = 0; i < GENERATIONS; i++)
+		sim.step();
+
+	return { sim.getPopulation(), sim.getChunkCount(), sim.getEscapeeCount() };
+}
+
+
+int main()
+{
+	std::vector<Outcome> alone;
+	for (unsigned int i = 0; i < SIMULATIONS; i++)
+		alone.push_back(runSoup(i + 1));
+
+	std::vector<Outcome> together(SIMULATIONS);
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < SIMULATIONS; i++)
+		threads.push_back(std::thread([&together, i]() { together[i] = runSoup(i + 1); }));
+	for (std::thread& thread : threads)
+		thread.join();
+
+	unsigned int escapees = 0;
+	for (unsigned int i = 0; i < SIMULATIONS; i++)
+	{
+		const std::string soup = "soup " + std::to_string(i + 1);
+		test::check(together[i].population == alone[i].population, soup + " population is the same stepped alongside others");
+		test::check(together[i].chunks == alone[i].chunks, soup + " chunk count is the same stepped alongside others");
+		test::check(together[i].escapees == alone[i].escapees, soup + " escapee count is the same stepped alongside others");
+		escapees += alone[i].escapees;
+	}
+	test::check(escapees > 0, "spaceships escaped");
+
+	return test::result("concurrent simulations");
+}
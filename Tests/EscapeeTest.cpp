@@ -0,0 +1,258 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// Tests/EscapeeTest.cpp
+// 
+// Escaped spaceships are tracked without chunks, which must not change
+// how the universe evolves. Soups, a Gosper gun and colliding ships are
+// compared with a naive stepper every generation, cells set near an
+// escaped ship must return it to the universe, and fastForward() must
+// move escaped ships on while skipping the cycles of the rest.
+// 
+
+#include "Check.hpp"
+#include "gol/Simulation.hpp"
+#include "gol/Pattern.hpp"
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+static const char* GOSPER_GUN =
+	"x = 36, y = 9, rule = B3/S23\n"
+	"24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4bobo$10bo5bo7bo$11bo3bo$12b2o!\n";
+
+// Glider heading south-east, and lightweight spaceship heading west
+static const std::vector<std::pair<int,int>> GLIDER = { {1,0},{2,1},{0,2},{1,2},{2,2} };
+static const std::vector<std::pair<int,int>> LWSS = { {1,0},{4,0},{0,1},{0,2},{4,2},{0,3},{1,3},{2,3},{3,3} };
+
+
+// Naive B3/S23 universe, a set of alive cells.
+class Reference
+{
+public:
+	void setCell(int x, int y, bool alive)
+	{
+		if (alive)
+			m_cells.insert(key(x, y));
+		else
+			m_cells.erase(key(x, y));
+	}
+
+	void step()
+	{
+		std::unordered_map<uint64_t, int> neighbours;
+		for (uint64_t cell : m_cells)
+		{
+			const int x = cellX(cell), y = cellY(cell);
+			for (int oy = -1; oy <= 1; oy++)
+				for (int ox = -1; ox <= 1; ox++)
+					if (ox != 0 || oy != 0)
+						neighbours[key(x + ox, y + oy)]++;
+		}
+
+		std::unordered_set<uint64_t> next;
+		for (const auto& it : neighbours)
+			if (it.second == 3 || (it.second == 2 && m_cells.count(it.first) != 0))
+				next.insert(it.first);
+		m_cells.swap(next);
+	}
+
+	inline const std::unordered_set<uint64_t>& getCells() const { return m_cells; }
+
+	static inline uint64_t key(int x, int y) { return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y); }
+	static inline int cellX(uint64_t cell) { return static_cast<int32_t>(cell >> 32); }
+	static inline int cellY(uint64_t cell) { return static_cast<int32_t>(cell & 0xFFFFFFFF); }
+
+private:
+	std::unordered_set<uint64_t> m_cells;
+};
+
+
+// Check the simulation has exactly the cells of the reference.
+static bool matches(const gol::Simulation& sim, const Reference& reference)
+{
+	if (sim.getPopulation() != reference.getCells().size())
+		return false;
+	for (uint64_t cell : reference.getCells())
+		if (!sim.getCell(Reference::cellX(cell), Reference::cellY(cell)))
+			return false;
+	return true;
+}
+
+// Set cells of a ship at {x,y} in both universes.
+static void place(gol::Simulation& sim, Reference& reference, const std::vector<std::pair<int,int>>& ship, int x, int y)
+{
+	for (const auto& cell : ship)
+	{
+		sim.setCell(x + cell.first, y + cell.second, true);
+		reference.setCell(x + cell.first, y + cell.second, true);
+	}
+}
+
+// Step both universes, checking they match every generation. Returns the most escaped ships seen at once.
+static unsigned int stepMatching(gol::Simulation& sim, Reference& reference, unsigned int generations, const std::string& what)
+{
+	unsigned int escapees = sim.getEscapeeCount();
+	for (unsigned int i = 0; i < generations; i++)
+	{
+		sim.step();
+		reference.step();
+		if (!test::check(matches(sim, reference), what + " matches the naive stepper at generation " + std::to_string(sim.getGeneration())))
+			break;
+		escapees = std::max(escapees, sim.getEscapeeCount());
+	}
+	return escapees;
+}
+
+
+static void testSoups()
+{
+	unsigned int escapees = 0;
+	for (uint64_t seed = 1; seed <= 3; seed++)
+	{
+		gol::Simulation sim;
+		sim.setThreadCount(1);
+		Reference reference;
+
+		gol::Pattern soup;
+		soup.randomize(64, 64, 0.3f, seed);
+		soup.place(sim, 0, 0);
+		for (int y = 0; y < soup.getHeight(); y++)
+			for (int x = 0; x < soup.getWidth(); x++)
+				if (soup.getCell(x, y))
+					reference.setCell(x, y, true);
+
+		escapees += stepMatching(sim, reference, 1500, "soup " + std::to_string(seed));
+	}
+	test::check(escapees > 0, "spaceships escaped from soups");
+}
+
+
+static void testGosperGun()
+{
+	gol::Simulation sim;
+	sim.setThreadCount(1);
+	Reference reference;
+
+	gol::Pattern gun;
+	std::istringstream in(GOSPER_GUN);
+	test::check(gun.parse(in), "Gosper gun parsed");
+	gun.place(sim, 0, 0);
+	for (const gol::CellSpan& span : gun.getSpans())
+		for (int x = span.x; x < span.x + span.length; x++)
+			reference.setCell(x, span.y, true);
+
+	const unsigned int escapees = stepMatching(sim, reference, 1000, "Gosper gun");
+	test::check(escapees > 0, "gliders escaped from the Gosper gun");
+}
+
+
+static void testCollidingShips()
+{
+	// Glider and LWSS meet after about 800 generations, long after both escaped
+	gol::Simulation sim;
+	sim.setThreadCount(1);
+	Reference reference;
+	place(sim, reference, GLIDER, 0, 0);
+	place(sim, reference, LWSS, 600, 200);
+
+	const unsigned int escapees = stepMatching(sim, reference, 400, "glider and LWSS");
+	test::check(escapees == 2, "glider and LWSS escaped");
+	stepMatching(sim, reference, 800, "glider and LWSS colliding");
+	test::check(sim.getEscapeeCount() == 0, "glider and LWSS restored to collide");
+}
+
+
+static void testEditNearEscapee()
+{
+	gol::Simulation sim;
+	sim.setThreadCount(1);
+	Reference reference;
+	place(sim, reference, GLIDER, 0, 0);
+	stepMatching(sim, reference, 200, "lone glider");
+	if (!test::check(sim.getEscapeeCount() == 1, "lone glider escaped"))
+		return;
+
+	// Cells set far away leave it escaped
+	sim.setCell(-500, -500, true);
+	reference.setCell(-500, -500, true);
+	test::check(sim.getEscapeeCount() == 1, "cell set far from the glider leaves it escaped");
+
+	// A block set just ahead of the glider returns it, and the glider hits the block
+	std::vector<std::pair<int,int>> cells;
+	sim.getEscapeeCells(cells);
+	int right = cells.front().first, bottom = cells.front().second;
+	for (const auto& cell : cells)
+	{
+		right = std::max(right, cell.first);
+		bottom = std::max(bottom, cell.second);
+	}
+	place(sim, reference, { {0,0},{1,0},{0,1},{1,1} }, right + 2, bottom + 2);
+	test::check(sim.getEscapeeCount() == 0, "cells set near the glider return it to the universe");
+	test::check(matches(sim, reference), "glider returned in place");
+	stepMatching(sim, reference, 200, "glider hitting a block");
+}
+
+
+static void testFastForward()
+{
+	// A blinker keeps the universe stable while the glider and LWSS escape on their way to collide
+	gol::Simulation sim;
+	sim.setThreadCount(1);
+	Reference reference;
+	place(sim, reference, { {0,0},{0,1},{0,2} }, -40, 0);
+	place(sim, reference, GLIDER, 0, 0);
+	place(sim, reference, LWSS, 600, 200);
+
+	stepMatching(sim, reference, 200, "blinker, glider and LWSS");
+	test::check(sim.getEscapeeCount() == 2, "glider and LWSS escaped before fast forwarding");
+	test::check(sim.isStable(), "universe stable besides the escaped ships");
+
+	// Skipped cycles move the ships on, and they are stepped again once they near each other
+	const unsigned int jumps[] = { 300, 1000, 2000 };
+	for (unsigned int jump : jumps)
+	{
+		const unsigned int generation = sim.getGeneration();
+		sim.fastForward(jump);
+		for (unsigned int i = 0; i < jump; i++)
+			reference.step();
+		test::check(sim.getGeneration() == generation + jump, "fast forward by " + std::to_string(jump) + " generations");
+		test::check(matches(sim, reference), "fast forward matches the naive stepper at generation " + std::to_string(sim.getGeneration()));
+	}
+}
+
+
+int main()
+{
+	testSoups();
+	testGosperGun();
+	testCollidingShips();
+	testEditNearEscapee();
+	testFastForward();
+	return test::result("escapees");
+}
@@ -0,0 +1,267 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// Tests/PagingTest.cpp
+// 
+// Soak test of chunk paging. A field of still lifes is held under a
+// memory budget, so sleeping chunks are paged out to the backing file
+// (see gol::ChunkPager), then woken by edits and paged back in, over many
+// cycles. Every cell must survive each round trip, the budget must hold
+// after each pass enforcing it, and slots of the backing file must be
+// reused rather than growing the file.
+// 
+// The soak runs once on the stepping thread and once with worker threads,
+// which page chunks in while applying cell states. Each run is stepped
+// alongside an unbudgeted simulation given the same edits, which it must
+// match cell for cell.
+// 
+
+#include "Check.hpp"
+#include "gol/Simulation.hpp"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+static const int CHUNK_SIZE = static_cast<int>(gol::Chunk::CHUNK_SIZE);
+static const int FIELD_CHUNKS = 16;           //> Field is FIELD_CHUNKS * FIELD_CHUNKS chunks.
+static const int FIELD_SIZE = FIELD_CHUNKS * CHUNK_SIZE;
+static const int SPACING = 16;                //> Still lifes are placed on a grid this many cells apart.
+static const unsigned int SOAK_CYCLES = 24;
+static const size_t SOAK_THREADS[] = { 1, 4 };
+
+// Still lifes placed on the field, at most 4x4 cells.
+static const std::vector<std::vector<const char*>> STILL_LIFES = {
+	{ "XX", "XX" },                       //> Block
+	{ ".XX.", "X..X", ".XX." },           //> Beehive
+	{ ".XX.", "X..X", ".X.X", "..X." },   //> Loaf
+	{ "XX.", "X.X", ".X." },              //> Boat
+	{ ".X.", "X.X", ".X." },              //> Tub
+	{ ".XX.", "X..X", "X..X", ".XX." },   //> Pond
+};
+
+// Spark placed one cell in from a chunk's west edge. Its first generation has cells on the edge.
+static const std::pair<int,int> SPARK[] = { { 1, 0 }, { 1, 1 }, { 1, 2 }, { 3, 0 } };
+
+
+// Read every cell of the field.
+static std::vector<uint64_t> readField(const gol::Simulation& sim)
+{
+	const size_t stride = FIELD_SIZE / 64;
+	std::vector<uint64_t> bitmap(stride * FIELD_SIZE);
+	sim.readCells(0, 0, FIELD_SIZE, FIELD_SIZE, bitmap.data(), stride);
+	return bitmap;
+}
+
+
+// Step both simulations until the generation given.
+static void stepTo(gol::Simulation& sim, gol::Simulation& reference, unsigned int generation)
+{
+	while (sim.getGeneration() < generation)
+		sim.step();
+	while (reference.getGeneration() < generation)
+		reference.step();
+}
+
+
+// Set a cell of both simulations.
+static void setCell(gol::Simulation& sim, gol::Simulation& reference, int x, int y)
+{
+	sim.setCell(x, y, true);
+	reference.setCell(x, y, true);
+}
+
+
+// Get bytes of cell storage held in memory, as counted against the memory budget.
+static size_t getUsedBytes(const gol::Simulation& sim)
+{
+	return sim.getResidentCellBytes() + sim.getCompressedCellBytes();
+}
+
+
+// Count cells of the first rows of chunks which getCell() reads differently from the bitmap of the field.
+static unsigned int countCellMismatches(const gol::Simulation& sim, const std::vector<uint64_t>& field, int chunkRows)
+{
+	const size_t stride = FIELD_SIZE / 64;
+	unsigned int mismatches = 0;
+	for (int y = 0; y < chunkRows * CHUNK_SIZE; y++)
+		for (int x = 0; x < FIELD_SIZE; x++)
+			if (((field[y * stride + x / 64] >> (x % 64)) & 1) != sim.getCell(x, y))
+				mismatches++;
+	return mismatches;
+}
+
+
+// Count chunks with cells paged out.
+static unsigned int countPagedChunks(const gol::Simulation& sim)
+{
+	unsigned int count = 0;
+	sim.forEachChunkIn(0, 0, FIELD_SIZE - 1, FIELD_SIZE - 1, [&count](const gol::Chunk* chunk) {
+		if (chunk->isPaged())
+			count++;
+	});
+	return count;
+}
+
+
+// Write, read and free slots of a pager directly.
+static void testPager()
+{
+	gol::ChunkPager pager;
+	std::mt19937 random(1);
+	std::vector<std::vector<unsigned char>> datas;
+	for (size_t bytes : { size_t(1), size_t(2), size_t(100), gol::ChunkPager::MAX_DATA_BYTES })
+	{
+		std::vector<unsigned char> data(bytes);
+		for (unsigned char& byte : data)
+			byte = static_cast<unsigned char>(random());
+		datas.push_back(data);
+	}
+
+	std::vector<int64_t> slots;
+	for (const std::vector<unsigned char>& data : datas)
+		slots.push_back(pager.pageOut(data));
+	test::check(std::find(slots.begin(), slots.end(), -1) == slots.end(), "pager writes data");
+	test::check(pager.getPagedCount() == datas.size(), "pager counts slots in use");
+
+	std::vector<unsigned char> data;
+	for (size_t i = 0; i < datas.size(); i++)
+		test::check(pager.read(slots[i], data) && data == datas[i], "pager reads back data of " + std::to_string(datas[i].size()) + " bytes");
+
+	const uint64_t fileBytes = pager.getFileBytes();
+	test::check(pager.pageIn(slots[1], data) && data == datas[1], "pager pages data in");
+	test::check(pager.getPagedCount() == datas.size() - 1, "paging in frees the slot");
+	test::check(pager.pageOut(datas[3]) == slots[1], "pager reuses free slots");
+	test::check(pager.getFileBytes() == fileBytes, "reusing a slot doesn't grow the file");
+
+	pager.clear();
+	test::check(pager.getPagedCount() == 0 && pager.getFileBytes() == 0, "clearing the pager truncates the file");
+}
+
+
+// Soak a budgeted simulation stepped with the thread count given.
+static void soak(size_t threads)
+{
+	const std::string pass = " (" + std::to_string(threads) + " thread(s))";
+	gol::Simulation sim;
+	gol::Simulation reference;
+	sim.setThreadCount(threads);
+	reference.setThreadCount(1);
+
+	// Still lifes on a grid, far enough apart not to interact
+	std::mt19937 random(7);
+	for (int gy = 0; gy < FIELD_SIZE / SPACING; gy++)
+	{
+		for (int gx = 0; gx < FIELD_SIZE / SPACING; gx++)
+		{
+			if (random() % 3 == 0)
+				continue;
+			const std::vector<const char*>& shape = STILL_LIFES[random() % STILL_LIFES.size()];
+			const int x = gx * SPACING + 4 + static_cast<int>(random() % 4);
+			const int y = gy * SPACING + 4 + static_cast<int>(random() % 4);
+			for (size_t row = 0; row < shape.size(); row++)
+				for (size_t col = 0; shape[row][col] != '\0'; col++)
+					if (shape[row][col] == 'X')
+						setCell(sim, reference, x + static_cast<int>(col), y + static_cast<int>(row));
+		}
+	}
+
+	const std::vector<uint64_t> field = readField(sim);
+	const unsigned int population = sim.getPopulation();
+	stepTo(sim, reference, 2);
+	test::check(readField(sim) == field, "field is made of still lifes" + pass);
+
+	// Budget a quarter of the memory the field uses without one
+	const size_t unbudgeted = getUsedBytes(sim);
+	const size_t budget = unbudgeted / 4;
+	sim.setMemoryBudget(budget);
+
+	unsigned int generation = gol::Simulation::COMPRESS_CHECK_INTERVAL;
+	stepTo(sim, reference, generation + 1);
+	test::check(getUsedBytes(sim) <= budget, "memory use of " + std::to_string(getUsedBytes(sim)) + " bytes is within budget of " + std::to_string(budget) + pass);
+	test::check(countPagedChunks(sim) > 0 && sim.getChunkPager().getPagedCount() == countPagedChunks(sim), "chunks are paged out" + pass);
+	test::check(readField(sim) == field, "cells survive paging out" + pass);
+	test::check(countCellMismatches(sim, field, 2) == 0, "cells of paged chunks are read one at a time" + pass);
+
+	// Wake chunks in turn with lone cells (which die next generation), paging them back in,
+	// until the budget pages them out again
+	// A spark beside the west edge of a chunk is born onto the edge, waking the west neighbour while
+	// stepping and paging it in from the thread applying cell states, then dies out within 3 generations
+	const uint64_t fileBytes = sim.getChunkPager().getFileBytes();
+	const unsigned long long pageIns = sim.getChunkPager().getPageIns();
+	const unsigned long long pageOuts = sim.getChunkPager().getPageOuts();
+	unsigned long long steppedPageIns = 0;
+	for (unsigned int cycle = 0; cycle < SOAK_CYCLES; cycle++)
+	{
+		const std::string when = ", cycle " + std::to_string(cycle) + pass;
+		for (int i = 0; i < FIELD_CHUNKS; i++)
+		{
+			const int column = (i + static_cast<int>(cycle) * 3) % FIELD_CHUNKS;
+			const int row = (i * 5 + static_cast<int>(cycle)) % FIELD_CHUNKS;
+			setCell(sim, reference, column * CHUNK_SIZE + 12, row * CHUNK_SIZE + 12);
+			for (const std::pair<int,int>& spark : SPARK)
+				setCell(sim, reference, column * CHUNK_SIZE + spark.first, row * CHUNK_SIZE + 45 + spark.second);
+		}
+		const unsigned long long editPageIns = sim.getChunkPager().getPageIns();
+		stepTo(sim, reference, sim.getGeneration() + 4);
+		steppedPageIns += sim.getChunkPager().getPageIns() - editPageIns;
+		test::check(readField(sim) == readField(reference), "cells match the unbudgeted simulation after paging in" + when);
+		test::check(readField(sim) == field, "cells survive paging in" + when);
+
+		generation += gol::Simulation::COMPRESS_CHECK_INTERVAL;
+		stepTo(sim, reference, generation + 1);
+		test::check(getUsedBytes(sim) <= budget, "memory use of " + std::to_string(getUsedBytes(sim)) + " bytes is within budget" + when);
+		test::check(readField(sim) == readField(reference), "cells match the unbudgeted simulation after paging out" + when);
+		test::check(readField(sim) == field, "cells survive paging out" + when);
+		test::check(sim.getChunkPager().getPagedCount() == countPagedChunks(sim), "pager slots match paged chunks" + when);
+		test::check(sim.getPopulation() == reference.getPopulation(), "population matches the unbudgeted simulation" + when);
+	}
+
+	test::check(sim.getChunkPager().getPageIns() > pageIns, "chunks were paged in" + pass);
+	test::check(steppedPageIns > 0, "chunks were paged in while stepping" + pass);
+	test::check(sim.getChunkPager().getPageOuts() > pageOuts, "chunks were paged out again" + pass);
+	test::check(sim.getChunkPager().getFileBytes() <= fileBytes * 2, "backing file reuses slots rather than growing" + pass);
+	test::check(sim.getPopulation() == population, "population survives paging" + pass);
+
+	// Lifting the budget leaves cells paged out until chunks wake, and reset frees the backing file
+	sim.setMemoryBudget(0);
+	stepTo(sim, reference, generation + gol::Simulation::COMPRESS_CHECK_INTERVAL + 1);
+	test::check(readField(sim) == field, "cells survive lifting the budget" + pass);
+	sim.reset();
+	test::check(sim.getChunkPager().getPagedCount() == 0, "reset frees paged slots" + pass);
+
+	std::cout << threads << " thread(s): budget " << budget << " of " << unbudgeted << " bytes, " << sim.getChunkPager().getPageOuts() << " page outs, "
+		<< sim.getChunkPager().getPageIns() << " page ins, " << steppedPageIns << " while stepping" << std::endl;
+}
+
+
+int main()
+{
+	testPager();
+	for (size_t threads : SOAK_THREADS)
+		soak(threads);
+	return test::result("paging");
+}
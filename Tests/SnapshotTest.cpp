@@ -0,0 +1,233 @@
+// 
+// MIT License
+// 
+// Copyright(c) 2019 Nathan Cousins
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// 
+// 
+// Tests/SnapshotTest.cpp
+// 
+// Stress test of gol::Snapshot. Reader threads verify snapshots published
+// by a SimulationThread while it steps the simulation, and while another
+// thread edits it. Still lifes fall asleep and are compressed, so
+// snapshots share compressed cells with the simulation, and are woken by
+// edits again. Every snapshot must stay as it was when first read, however
+// far the simulation moves on. Build with GOL_SANITIZE=thread to check for
+// data races as well.
+// 
+
+#include "Check.hpp"
+#include "SimulationThread.hpp"
+#include "gol/Simulation.hpp"
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <climits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+static const int CHUNK_SIZE = static_cast<int>(gol::Chunk::CHUNK_SIZE);
+static const unsigned int READER_THREADS = 3;
+static const unsigned int GENERATIONS = 3500;          //> Long enough for sleeping chunks to be compressed, woken and compressed again.
+static const unsigned int EDIT_INTERVAL = 400;         //> Generations between edits.
+static const unsigned int STILL_LIFE_CHUNKS = 8;
+static const std::chrono::seconds TIME_LIMIT(240);
+
+
+// Get a checksum of the cells of a snapshot, checking chunks agree with its population.
+static uint64_t verifySnapshot(const gol::Snapshot& snapshot)
+{
+	uint64_t checksum = 0;
+	uint64_t population = 0;
+	uint64_t cells[gol::Chunk::CHUNK_SIZE];
+
+	snapshot.forEachChunkIn(INT_MIN / 2, INT_MIN / 2, INT_MAX / 2, INT_MAX / 2, [&](const gol::ChunkSnapshot& chunk) {
+		chunk.getCells(cells);
+
+		unsigned int alive = 0;
+		uint64_t hash = (static_cast<uint64_t>(static_cast<uint32_t>(chunk.getColumn())) << 32) | static_cast<uint32_t>(chunk.getRow());
+		for (int y = 0; y < CHUNK_SIZE; y++)
+		{
+			alive += static_cast<unsigned int>(std::bitset<64>(cells[y]).count());
+			hash = (hash ^ cells[y]) * 0x100000001B3ull;
+		}
+
+		test::check(alive == chunk.getAliveCells(), "chunk cells match its alive cell count");
+		test::check(chunk.getDensity(1) != nullptr, "chunk density is built");
+		checksum += hash; //> Chunks are visited in no particular order
+		population += alive;
+	});
+
+	test::check(population + snapshot.getEscapeeCells().size() == snapshot.getPopulation(), "snapshot chunks match its population");
+	return checksum;
+}
+
+
+// Place a block (2x2 still life) with its top left cell at {x,y}.
+static void placeBlock(gol::Simulation& sim, int x, int y)
+{
+	sim.setCell(x, y, true);
+	sim.setCell(x + 1, y, true);
+	sim.setCell(x, y + 1, true);
+	sim.setCell(x + 1, y + 1, true);
+}
+
+
+int main()
+{
+	gol::Simulation sim;
+	sim.setThreadCount(1); //> Only snapshots are under test, chunks are updated on the stepping thread
+
+	// Still lifes in chunks of their own fall asleep and are compressed, a blinker is compressed in periodic sleep
+	for (unsigned int i = 0; i < STILL_LIFE_CHUNKS; i++)
+		placeBlock(sim, static_cast<int>(i) * CHUNK_SIZE * 2 + 20, 20);
+	sim.setCell(CHUNK_SIZE * 20 + 30, 30, true);
+	sim.setCell(CHUNK_SIZE * 20 + 31, 30, true);
+	sim.setCell(CHUNK_SIZE * 20 + 32, 30, true);
+
+	// R-pentomino keeps the simulation busy, and releases gliders
+	const int cx = CHUNK_SIZE * 8, cy = CHUNK_SIZE * 8;
+	sim.setCell(cx + 1, cy, true);
+	sim.setCell(cx + 2, cy, true);
+	sim.setCell(cx, cy + 1, true);
+	sim.setCell(cx + 1, cy + 1, true);
+	sim.setCell(cx + 1, cy + 2, true);
+
+	SimulationThread thread;
+	thread.setTargetStepsPerSecond(0.f);
+	thread.start(sim);
+	thread.setPaused(false);
+
+	std::atomic<bool> done(false);
+	std::atomic<bool> compressed(false);
+	std::atomic<unsigned int> snapshotsRead(0);
+
+	// Readers verify each new snapshot, then check the previous one is unchanged
+	std::vector<std::thread> readers;
+	for (unsigned int r = 0; r < READER_THREADS; r++)
+	{
+		readers.push_back(std::thread([&, r]() {
+			std::shared_ptr<const gol::Snapshot> previous, held;
+			uint64_t previousChecksum = 0, heldChecksum = 0;
+
+			while (!done)
+			{
+				std::shared_ptr<const gol::Snapshot> snapshot = thread.getSnapshot();
+				if (!snapshot || snapshot == previous)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				const uint64_t checksum = verifySnapshot(*snapshot);
+				if (previous)
+				{
+					test::check(snapshot->getGeneration() >= previous->getGeneration(), "snapshot generations never go back");
+					test::check(verifySnapshot(*previous) == previousChecksum, "snapshot is unchanged after newer snapshots are made");
+				}
+
+				// Hold the first snapshot sharing compressed cells until the end
+				if (!held && compressed)
+				{
+					held = snapshot;
+					heldChecksum = checksum;
+				}
+
+				previous = snapshot;
+				previousChecksum = checksum;
+				snapshotsRead++;
+			}
+
+			if (test::check(held != nullptr, "reader " + std::to_string(r) + " read a snapshot of compressed chunks"))
+				test::check(verifySnapshot(*held) == heldChecksum, "snapshot of compressed chunks is unchanged after they were woken");
+		}));
+	}
+
+	// Edit while stepping, waking sleeping chunks in turn with a lone cell (which dies next generation),
+	// or by toggling a block through stampCells()
+	const uint64_t block[2] = { 0x3, 0x3 };
+	unsigned int nextEdit = EDIT_INTERVAL;
+	unsigned int edits = 0;
+	const auto deadline = std::chrono::steady_clock::now() + TIME_LIMIT;
+
+	while (std::chrono::steady_clock::now() < deadline)
+	{
+		unsigned int generation;
+		bool edited = false;
+		{
+			std::lock_guard<std::mutex> lock(thread.getGuard());
+			generation = sim.getGeneration();
+			if (sim.getCompressedChunkCount() > 0)
+				compressed = true;
+
+			if (generation >= nextEdit)
+			{
+				const int column = static_cast<int>(edits % STILL_LIFE_CHUNKS) * 2;
+				if (edits % 2 == 0)
+					sim.queueCell(column * CHUNK_SIZE + 50, 50, true);
+				else
+					sim.stampCells(block, 2, 2, 1, column * CHUNK_SIZE + 40, 10, gol::Simulation::StampXor);
+				nextEdit = generation + EDIT_INTERVAL;
+				edits++;
+				edited = true;
+			}
+		}
+
+		if (edited)
+			thread.invalidate();
+		if (generation >= GENERATIONS)
+			break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// Let readers catch up with the last snapshot
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	done = true;
+	for (std::thread& reader : readers)
+		reader.join();
+	thread.stop();
+
+	test::check(sim.getGeneration() >= GENERATIONS, "simulation reached " + std::to_string(GENERATIONS) + " generations in time");
+	test::check(compressed, "chunks were compressed while snapshots were read");
+	test::check(edits >= GENERATIONS / EDIT_INTERVAL - 1, "edits were made while stepping");
+	test::check(snapshotsRead >= READER_THREADS, "snapshots were read");
+
+	// A snapshot of the stopped simulation matches it cell for cell
+	std::shared_ptr<const gol::Snapshot> snapshot = sim.snapshot();
+	test::check(snapshot->getGeneration() == sim.getGeneration(), "snapshot generation matches the simulation");
+	test::check(snapshot->getPopulation() == sim.getPopulation(), "snapshot population matches the simulation");
+	test::check(snapshot->getChunkCount() == sim.getChunkCount(), "snapshot chunk count matches the simulation");
+
+	uint64_t cells[gol::Chunk::CHUNK_SIZE];
+	unsigned int mismatches = 0;
+	snapshot->forEachChunkIn(INT_MIN / 2, INT_MIN / 2, INT_MAX / 2, INT_MAX / 2, [&](const gol::ChunkSnapshot& chunk) {
+		chunk.getCells(cells);
+		for (int y = 0; y < CHUNK_SIZE; y++)
+			for (int x = 0; x < CHUNK_SIZE; x++)
+				if (((cells[y] >> x) & 1) != sim.getCell(chunk.getColumn() * CHUNK_SIZE + x, chunk.getRow() * CHUNK_SIZE + y))
+					mismatches++;
+	});
+	test::check(mismatches == 0, std::to_string(mismatches) + " snapshot cells differ from the simulation");
+
+	std::cout << snapshotsRead << " snapshots read, " << edits << " edits, generation " << sim.getGeneration() << std::endl;
+	return test::result("snapshot");
+}